@@ -0,0 +1,242 @@
+#include "benchmark.h"
+#include "bdd_collection.h"
+#include "bdd_shared_collection.h"
+#include "bdd_message_passing.h"
+#include <vector>
+#include <numeric>
+#include <random>
+
+using namespace BDD;
+
+struct collection_input {
+    bdd_collection collection;
+    std::vector<size_t> bdds;
+};
+
+// at_most constraints on overlapping windows of variables
+collection_input window_constraints(bdd_mgr& mgr, const size_t nr_bdds, const size_t window_size, const size_t b)
+{
+    collection_input input;
+    const size_t stride = window_size / 2;
+    std::vector<node_ref> x;
+    for(size_t i=0; i<stride*(nr_bdds+1); ++i)
+        x.push_back(mgr.projection(i));
+    for(size_t c=0; c<nr_bdds; ++c)
+    {
+        node_ref f = mgr.at_most(x.begin() + c*stride, x.begin() + c*stride + window_size, b);
+        input.bdds.push_back(input.collection.add_bdd(f));
+    }
+    return input;
+}
+
+// min-sum message passing over window constraints with random costs in each lane
+template<size_t LANES>
+struct message_passing_input {
+    std::unique_ptr<bdd_message_passing<min_sum_semiring<>, LANES>> mp;
+    std::vector<std::array<double,LANES>> c0, c1;
+    size_t nr_nodes = 0;
+};
+
+template<size_t LANES>
+message_passing_input<LANES> message_passing_setup(bdd_mgr& mgr, const size_t nr_bdds)
+{
+    collection_input in = window_constraints(mgr, nr_bdds, 32, 4);
+    message_passing_input<LANES> mp_in;
+    mp_in.mp = std::make_unique<bdd_message_passing<min_sum_semiring<>, LANES>>(in.collection);
+    const size_t nr_vars = mgr.nr_variables();
+    mp_in.c0.resize(nr_vars);
+    mp_in.c1.resize(nr_vars);
+    for(size_t i=0; i<nr_vars; ++i)
+        for(size_t l=0; l<LANES; ++l)
+        {
+            mp_in.c0[i][l] = 0.0;
+            mp_in.c1[i][l] = double((i * 7919 + l * 104729) % 1000) / 500.0 - 1.0;
+        }
+    for(const size_t bdd_nr : in.bdds)
+        mp_in.nr_nodes += in.collection.nr_bdd_nodes(bdd_nr);
+    return mp_in;
+}
+
+// random assignments, bit-sliced in batches of 256, to evaluate window constraints on
+struct evaluation_input {
+    collection_input in;
+    std::vector<std::vector<assignment_batch<4>>> batches;
+};
+
+evaluation_input evaluation_setup(bdd_mgr& mgr, const size_t nr_bdds, const size_t nr_batches)
+{
+    evaluation_input e;
+    e.in = window_constraints(mgr, nr_bdds, 32, 4);
+    std::mt19937_64 gen(17);
+    e.batches.resize(nr_batches, std::vector<assignment_batch<4>>(mgr.nr_variables()));
+    for(auto& batch : e.batches)
+        for(auto& x : batch)
+            for(auto& w : x)
+                w = gen() & gen(); // one in four variables set keeps some assignments feasible
+    return e;
+}
+
+// conjunctions of neighbouring window constraints, held in the manager
+std::vector<node_ref> import_setup(bdd_mgr& mgr, const size_t nr_bdds)
+{
+    const size_t window_size = 32;
+    const size_t stride = window_size / 2;
+    std::vector<node_ref> x;
+    for(size_t i=0; i<stride*(nr_bdds+2); ++i)
+        x.push_back(mgr.projection(i));
+    std::vector<node_ref> roots;
+    for(size_t c=0; c<nr_bdds; ++c)
+        roots.push_back(mgr.and_rec(
+                    mgr.at_most(x.begin() + c*stride, x.begin() + c*stride + window_size, 4),
+                    mgr.at_most(x.begin() + (c+1)*stride, x.begin() + (c+1)*stride + window_size, 4)));
+    return roots;
+}
+
+// windows of cardinality constraints, each conjoined with one simplex over separate variables below them
+std::vector<node_ref> shared_simplex_setup(bdd_mgr& mgr, const size_t nr_bdds)
+{
+    const size_t window_size = 16;
+    const size_t stride = window_size / 2;
+    const size_t nr_simplex_vars = 256;
+    std::vector<node_ref> x;
+    for(size_t i=0; i<stride*(nr_bdds+1) + nr_simplex_vars; ++i)
+        x.push_back(mgr.projection(i));
+    node_ref simplex = mgr.simplex(x.end() - nr_simplex_vars, x.end());
+    std::vector<node_ref> roots;
+    for(size_t c=0; c<nr_bdds; ++c)
+        roots.push_back(mgr.and_rec(mgr.at_most(x.begin() + c*stride, x.begin() + c*stride + window_size, 4), simplex));
+    return roots;
+}
+
+int main(int argc, char** argv)
+{
+    benchmark_suite suite(argc, argv);
+
+    for(const size_t nr_bdds : {2, 4, 8, 16, 64, 256})
+        suite.run("bdd_collection::bdd_and/" + std::to_string(nr_bdds),
+                [nr_bdds](bdd_mgr& mgr) { return window_constraints(mgr, nr_bdds, 32, 4); },
+                [](bdd_mgr&, collection_input& in) {
+                    const size_t r = in.collection.bdd_and(in.bdds.begin(), in.bdds.end());
+                    return in.collection.nr_bdd_nodes(r);
+                });
+
+    // pairwise conjunction of all constraints one by one
+    for(const size_t nr_bdds : {16, 64, 256})
+        suite.run("bdd_collection::bdd_and/sequential/" + std::to_string(nr_bdds),
+                [nr_bdds](bdd_mgr& mgr) { return window_constraints(mgr, nr_bdds, 32, 4); },
+                [](bdd_mgr&, collection_input& in) {
+                    size_t r = in.bdds[0];
+                    for(size_t i=1; i<in.bdds.size(); ++i)
+                        r = in.collection.bdd_and(r, in.bdds[i]);
+                    return in.collection.nr_bdd_nodes(r);
+                });
+
+    // disjunction and parity of all constraints one by one
+    for(const size_t nr_bdds : {16, 64})
+    {
+        suite.run("bdd_collection::bdd_or/sequential/" + std::to_string(nr_bdds),
+                [nr_bdds](bdd_mgr& mgr) { return window_constraints(mgr, nr_bdds, 32, 4); },
+                [](bdd_mgr&, collection_input& in) {
+                    size_t r = in.bdds[0];
+                    for(size_t i=1; i<in.bdds.size(); ++i)
+                        r = in.collection.bdd_or(r, in.bdds[i]);
+                    return in.collection.nr_bdd_nodes(r);
+                });
+        suite.run("bdd_collection::bdd_xor/sequential/" + std::to_string(nr_bdds),
+                [nr_bdds](bdd_mgr& mgr) { return window_constraints(mgr, nr_bdds, 32, 4); },
+                [](bdd_mgr&, collection_input& in) {
+                    size_t r = in.bdds[0];
+                    for(size_t i=1; i<in.bdds.size(); ++i)
+                        r = in.collection.bdd_xor(r, in.bdds[i]);
+                    return in.collection.nr_bdd_nodes(r);
+                });
+    }
+
+    // result nodes are the instructions written
+    for(const size_t nr_bdds : {256, 1024})
+        suite.run("bdd_collection::add_bdd/" + std::to_string(nr_bdds),
+                [nr_bdds](bdd_mgr& mgr) { return import_setup(mgr, nr_bdds); },
+                [](bdd_mgr&, std::vector<node_ref>& roots) {
+                    size_t nr_instructions = 0;
+                    for(size_t round=0; round<4; ++round)
+                    {
+                        bdd_collection collection;
+                        for(const node_ref& f : roots)
+                            nr_instructions += collection.nr_bdd_nodes(collection.add_bdd(f));
+                    }
+                    return nr_instructions;
+                });
+
+    // result nodes are the instructions stored, separately per bdd resp. shared between them
+    for(const size_t nr_bdds : {256, 1024})
+    {
+        suite.run("bdd_collection::add_bdds/simplex/" + std::to_string(nr_bdds),
+                [nr_bdds](bdd_mgr& mgr) { return shared_simplex_setup(mgr, nr_bdds); },
+                [](bdd_mgr&, std::vector<node_ref>& roots) {
+                    bdd_collection collection;
+                    collection.add_bdds(roots.begin(), roots.end());
+                    size_t nr_instructions = 0;
+                    for(size_t i=0; i<collection.nr_bdds(); ++i)
+                        nr_instructions += collection.nr_bdd_nodes(i);
+                    return nr_instructions;
+                });
+        suite.run("bdd_shared_collection::add_bdds/simplex/" + std::to_string(nr_bdds),
+                [nr_bdds](bdd_mgr& mgr) { return shared_simplex_setup(mgr, nr_bdds); },
+                [](bdd_mgr&, std::vector<node_ref>& roots) {
+                    bdd_shared_collection collection;
+                    collection.add_bdds(roots.begin(), roots.end());
+                    return collection.nr_instructions();
+                });
+    }
+
+    // result nodes are the number of satisfying assignments found
+    suite.run("bdd_collection::evaluate/1024",
+            [](bdd_mgr& mgr) { return evaluation_setup(mgr, 1024, 16); },
+            [](bdd_mgr&, evaluation_input& e) {
+                size_t nr_satisfying = 0;
+                std::vector<char> x(e.batches[0].size());
+                for(const auto& batch : e.batches)
+                    for(size_t k=0; k<256; ++k)
+                    {
+                        for(size_t i=0; i<x.size(); ++i)
+                            x[i] = (batch[i][k/64] >> (k%64)) & 1;
+                        for(const size_t bdd_nr : e.in.bdds)
+                            nr_satisfying += e.in.collection.evaluate(bdd_nr, x.begin(), x.end());
+                    }
+                return nr_satisfying;
+            });
+    suite.run("bdd_collection::evaluate_batch/1024",
+            [](bdd_mgr& mgr) { return evaluation_setup(mgr, 1024, 16); },
+            [](bdd_mgr&, evaluation_input& e) {
+                size_t nr_satisfying = 0;
+                for(const auto& batch : e.batches)
+                    for(const size_t bdd_nr : e.in.bdds)
+                        for(const std::uint64_t w : e.in.collection.evaluate_batch(bdd_nr, batch.begin(), batch.end()))
+                            nr_satisfying += __builtin_popcountll(w);
+                return nr_satisfying;
+            });
+
+    // result nodes are nodes times lanes processed
+    suite.run("min_sum_marginals/1024/lanes_1",
+            [](bdd_mgr& mgr) { return message_passing_setup<1>(mgr, 1024); },
+            [](bdd_mgr&, message_passing_input<1>& in) { in.mp->marginals(in.c0, in.c1); return in.nr_nodes; });
+    suite.run("min_sum_marginals/1024/lanes_8",
+            [](bdd_mgr& mgr) { return message_passing_setup<8>(mgr, 1024); },
+            [](bdd_mgr&, message_passing_input<8>& in) { in.mp->marginals(in.c0, in.c1); return 8*in.nr_nodes; });
+    suite.run("min_sum_marginals/1024/lanes_8/threads_4",
+            [](bdd_mgr& mgr) { auto in = message_passing_setup<8>(mgr, 1024); in.mp->set_nr_threads(4); return in; },
+            [](bdd_mgr&, message_passing_input<8>& in) { in.mp->marginals(in.c0, in.c1); return 8*in.nr_nodes; });
+
+    for(const size_t nr_bdds : {16, 64, 256})
+        suite.run("bdd_collection::export_bdd/" + std::to_string(nr_bdds),
+                [nr_bdds](bdd_mgr& mgr) {
+                    collection_input in = window_constraints(mgr, nr_bdds, 32, 4);
+                    size_t r = in.bdds[0];
+                    for(size_t i=1; i<in.bdds.size(); ++i)
+                        r = in.collection.bdd_and(r, in.bdds[i]);
+                    in.bdds = {r};
+                    mgr.collect_garbage();
+                    return in;
+                },
+                [](bdd_mgr& mgr, collection_input& in) { return in.collection.export_bdd(mgr, in.bdds[0]).nr_nodes(); });
+}
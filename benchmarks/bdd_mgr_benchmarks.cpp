@@ -0,0 +1,282 @@
+#include "benchmark.h"
+#include <vector>
+#include <array>
+#include <numeric>
+#include <cstdint>
+
+using namespace BDD;
+
+std::vector<node_ref> projections(bdd_mgr& mgr, const size_t n)
+{
+    std::vector<node_ref> vars;
+    for(size_t i=0; i<n; ++i)
+        vars.push_back(mgr.projection(i));
+    return vars;
+}
+
+// constraints of n queens on an n x n board, variable i*n+j is set if a queen is placed on square (i,j)
+std::vector<node_ref> queens_constraints(bdd_mgr& mgr, const size_t n)
+{
+    const std::vector<node_ref> x = projections(mgr, n*n);
+    std::vector<node_ref> constraints;
+    for(size_t i=0; i<n; ++i)
+    {
+        std::vector<node_ref> row, col;
+        for(size_t j=0; j<n; ++j)
+        {
+            row.push_back(x[i*n+j]);
+            col.push_back(x[j*n+i]);
+        }
+        constraints.push_back(mgr.simplex(row.begin(), row.end()));
+        constraints.push_back(mgr.at_most_one(col.begin(), col.end()));
+    }
+    for(std::ptrdiff_t d=-std::ptrdiff_t(n)+2; d<=std::ptrdiff_t(n)-2; ++d)
+    {
+        std::vector<node_ref> diag, anti_diag;
+        for(std::ptrdiff_t i=0; i<std::ptrdiff_t(n); ++i)
+        {
+            const std::ptrdiff_t j = i + d;
+            if(j < 0 || j >= std::ptrdiff_t(n))
+                continue;
+            diag.push_back(x[i*n+j]);
+            anti_diag.push_back(x[i*n + (n-1-j)]);
+        }
+        constraints.push_back(mgr.at_most_one(diag.begin(), diag.end()));
+        constraints.push_back(mgr.at_most_one(anti_diag.begin(), anti_diag.end()));
+    }
+    return constraints;
+}
+
+// n+1 pigeons in n holes, variable p*n+h is set if pigeon p sits in hole h. Unsatisfiable
+std::vector<node_ref> pigeonhole_constraints(bdd_mgr& mgr, const size_t n)
+{
+    const std::vector<node_ref> x = projections(mgr, (n+1)*n);
+    std::vector<node_ref> constraints;
+    for(size_t p=0; p<n+1; ++p)
+    {
+        std::vector<node_ref> holes(x.begin() + p*n, x.begin() + (p+1)*n);
+        constraints.push_back(mgr.at_least_one(holes.begin(), holes.end()));
+    }
+    for(size_t h=0; h<n; ++h)
+    {
+        std::vector<node_ref> pigeons;
+        for(size_t p=0; p<n+1; ++p)
+            pigeons.push_back(x[p*n+h]);
+        constraints.push_back(mgr.at_most_one(pigeons.begin(), pigeons.end()));
+    }
+    return constraints;
+}
+
+// conjunction one by one, so that intermediate results grow as in incremental solving
+size_t and_sequential(bdd_mgr& mgr, const std::vector<node_ref>& constraints)
+{
+    node_ref r = mgr.topsink();
+    for(const node_ref& c : constraints)
+        r = mgr.and_rec(r, c);
+    return r.is_terminal() ? 0 : r.nr_nodes();
+}
+
+// chain structured markov random field as in test/test_mrf_chain.cpp: one simplex per variable and marginalization constraints between unary and pairwise labels
+template<typename ITERATOR>
+node_ref mrf_simplex(bdd_mgr& mgr, ITERATOR var_begin, ITERATOR var_end)
+{
+    std::vector<node_ref> nodes;
+    nodes.push_back(mgr.or_rec(var_begin, var_end));
+    const size_t n = std::distance(var_begin, var_end);
+    for(size_t i=0; i<n; ++i)
+        for(size_t j=i+1; j<n; ++j)
+            nodes.push_back(mgr.or_rec(mgr.negate(*(var_begin+i)), mgr.negate(*(var_begin+j))));
+    return mgr.and_rec(nodes.begin(), nodes.end());
+}
+
+template<typename ITERATOR>
+node_ref mrf_marginalization_constraint(bdd_mgr& mgr, node_ref u, ITERATOR var_begin, ITERATOR var_end)
+{
+    std::vector<node_ref> bdds;
+    std::vector<node_ref> all_vars({mgr.negate(u)});
+    for(auto it=var_begin; it!=var_end; ++it)
+    {
+        bdds.push_back(mgr.or_rec(mgr.negate(*it), u));
+        all_vars.push_back(*it);
+    }
+    bdds.push_back(mgr.or_rec(all_vars.begin(), all_vars.end()));
+    return mgr.and_rec(bdds.begin(), bdds.end());
+}
+
+std::vector<node_ref> mrf_chain_constraints(bdd_mgr& mgr, const size_t nr_vars, const size_t nr_labels)
+{
+    std::vector<node_ref> bdds;
+    std::vector<std::vector<node_ref>> unary_vars;
+    std::vector<std::vector<std::vector<node_ref>>> pairwise_vars;
+    size_t var_counter = 0;
+    for(size_t i=0; i<nr_vars; ++i)
+    {
+        unary_vars.push_back({});
+        for(size_t j=0; j<nr_labels; ++j)
+            unary_vars.back().push_back(mgr.projection(var_counter++));
+        bdds.push_back(mrf_simplex(mgr, unary_vars.back().begin(), unary_vars.back().end()));
+
+        pairwise_vars.push_back({});
+        for(size_t l1=0; l1<nr_labels; ++l1)
+        {
+            pairwise_vars.back().push_back({});
+            for(size_t l2=0; l2<nr_labels; ++l2)
+                pairwise_vars.back().back().push_back(mgr.projection(var_counter++));
+        }
+    }
+
+    for(size_t i=0; i+1<nr_vars; ++i)
+    {
+        for(size_t l1=0; l1<nr_labels; ++l1)
+        {
+            std::vector<node_ref> p;
+            for(size_t l2=0; l2<nr_labels; ++l2)
+                p.push_back(pairwise_vars[i][l1][l2]);
+            bdds.push_back(mrf_marginalization_constraint(mgr, unary_vars[i][l1], p.begin(), p.end()));
+        }
+        for(size_t l2=0; l2<nr_labels; ++l2)
+        {
+            std::vector<node_ref> p;
+            for(size_t l1=0; l1<nr_labels; ++l1)
+                p.push_back(pairwise_vars[i][l1][l2]);
+            bdds.push_back(mrf_marginalization_constraint(mgr, unary_vars[i+1][l2], p.begin(), p.end()));
+        }
+    }
+    return bdds;
+}
+
+int main(int argc, char** argv)
+{
+    benchmark_suite suite(argc, argv);
+
+    for(const size_t n : {6, 7, 8, 9})
+        suite.run("and_rec/queens/" + std::to_string(n),
+                [n](bdd_mgr& mgr) { return queens_constraints(mgr, n); },
+                [](bdd_mgr& mgr, std::vector<node_ref>& c) { return and_sequential(mgr, c); });
+
+    for(const size_t n : {7, 8, 9, 10})
+        suite.run("and_rec/pigeonhole/" + std::to_string(n),
+                [n](bdd_mgr& mgr) { return pigeonhole_constraints(mgr, n); },
+                [](bdd_mgr& mgr, std::vector<node_ref>& c) { return and_sequential(mgr, c); });
+
+    for(const size_t nr_labels : {3, 4, 5, 6})
+        suite.run("and_rec/mrf_chain/32x" + std::to_string(nr_labels),
+                [nr_labels](bdd_mgr& mgr) { return mrf_chain_constraints(mgr, 32, nr_labels); },
+                [](bdd_mgr& mgr, std::vector<node_ref>& c) { node_ref r = mgr.and_rec(c.begin(), c.end()); return r.nr_nodes(); });
+
+    for(const size_t n : {32, 64, 128})
+        suite.run("at_most/" + std::to_string(n) + "/" + std::to_string(n/8),
+                [n](bdd_mgr& mgr) { return projections(mgr, n); },
+                [n](bdd_mgr& mgr, std::vector<node_ref>& x) { return mgr.at_most(x.begin(), x.end(), n/8).nr_nodes(); });
+
+    for(const size_t n : {32, 64, 128})
+        suite.run("cardinality/" + std::to_string(n) + "/" + std::to_string(n/8),
+                [n](bdd_mgr& mgr) { return projections(mgr, n); },
+                [n](bdd_mgr& mgr, std::vector<node_ref>& x) { return mgr.cardinality(x.begin(), x.end(), n/8).nr_nodes(); });
+
+    // constraints over thousands of variables
+    for(const size_t n : {1024, 4096})
+        suite.run("cardinality/" + std::to_string(n) + "/64",
+                [n](bdd_mgr& mgr) { return projections(mgr, n); },
+                [](bdd_mgr& mgr, std::vector<node_ref>& x) { return mgr.cardinality(x.begin(), x.end(), 64).nr_nodes(); });
+
+    suite.run("simplex/4096",
+            [](bdd_mgr& mgr) { return projections(mgr, 4096); },
+            [](bdd_mgr& mgr, std::vector<node_ref>& x) { return mgr.simplex(x.begin(), x.end()).nr_nodes(); });
+
+    // knapsack constraints with weights up to 100 and capacity a quarter of the total weight
+    for(const size_t n : {100, 200, 400})
+        suite.run("linear_at_most/knapsack/" + std::to_string(n),
+                [n](bdd_mgr& mgr) { return projections(mgr, n); },
+                [n](bdd_mgr& mgr, std::vector<node_ref>& x) {
+                    std::vector<std::int64_t> weights;
+                    for(size_t i=0; i<n; ++i)
+                        weights.push_back(1 + (i * 37) % 100);
+                    const std::int64_t capacity = std::accumulate(weights.begin(), weights.end(), std::int64_t(0)) / 4;
+                    return mgr.linear_at_most(x.begin(), x.end(), weights.begin(), capacity).nr_nodes();
+                });
+
+    // ite of cardinality constraints on even variables, odd variables and all variables
+    for(const size_t n : {32, 64, 128})
+        suite.run("ite_rec/cardinality/" + std::to_string(n),
+                [n](bdd_mgr& mgr) {
+                    const std::vector<node_ref> x = projections(mgr, n);
+                    std::vector<node_ref> even, odd;
+                    for(size_t i=0; i<n; ++i)
+                        (i % 2 == 0 ? even : odd).push_back(x[i]);
+                    return std::array<node_ref,3>{
+                        mgr.at_most(even.begin(), even.end(), n/16),
+                        mgr.at_least(odd.begin(), odd.end(), n/16),
+                        mgr.cardinality(x.begin(), x.end(), n/8)};
+                },
+                [](bdd_mgr& mgr, std::array<node_ref,3>& fgh) { return mgr.ite_rec(fgh[0], fgh[1], fgh[2]).nr_nodes(); });
+
+    // parity of cardinality constraints over overlapping windows
+    for(const size_t n : {64, 128})
+        suite.run("xor_rec/windows/" + std::to_string(n),
+                [n](bdd_mgr& mgr) { return projections(mgr, n); },
+                [n](bdd_mgr& mgr, std::vector<node_ref>& x) {
+                    node_ref f = mgr.botsink();
+                    for(size_t i=0; i+16<=n; i+=8)
+                        f = mgr.xor_rec(f, mgr.at_most(x.begin() + i, x.begin() + i + 16, 4));
+                    return f.nr_nodes();
+                });
+
+    // entailment check between cardinality constraints, without building their negations
+    for(const size_t n : {256, 1024})
+        suite.run("implies_rec/cardinality/" + std::to_string(n),
+                [n](bdd_mgr& mgr) {
+                    const std::vector<node_ref> x = projections(mgr, n);
+                    return std::array<node_ref,2>{mgr.cardinality(x.begin(), x.end(), n/8), mgr.at_most(x.begin(), x.end(), n/8 + 1)};
+                },
+                [](bdd_mgr& mgr, std::array<node_ref,2>& fg) { return mgr.implies_rec(fg[0], fg[1]).nr_nodes(); });
+
+    // x_0 x_n + ... + x_{n-1} x_{2n-1} is exponential in the identity order, sifting brings pairs together
+    for(const size_t n : {10, 14, 18})
+        suite.run("reorder/pairs/" + std::to_string(n),
+                [n](bdd_mgr& mgr) {
+                    node_ref f = mgr.botsink();
+                    for(size_t i=0; i<n; ++i)
+                        f = mgr.or_rec(f, mgr.and_rec(mgr.projection(i), mgr.projection(i+n)));
+                    return f;
+                },
+                [](bdd_mgr& mgr, node_ref& f) { mgr.reorder(); return f.nr_nodes(); });
+
+    // moving a constraint between two blocks of variables and back, the map preserves the order
+    suite.run("rebase/shift/at_most/128/16",
+            [](bdd_mgr& mgr) { const std::vector<node_ref> x = projections(mgr, 256); return mgr.at_most(x.begin(), x.begin() + 128, 16); },
+            [](bdd_mgr& mgr, node_ref& f) {
+                std::vector<size_t> forward(256), backward(256);
+                for(size_t i=0; i<128; ++i)
+                {
+                    forward[i] = i + 128;
+                    backward[i + 128] = i;
+                }
+                node_ref g = f;
+                for(size_t round=0; round<100; ++round)
+                    g = mgr.rebase(mgr.rebase(g, forward.begin(), forward.end()), backward.begin(), backward.end());
+                return g.nr_nodes();
+            });
+
+    // reversing the variables of a chain, which does not preserve the order
+    suite.run("rebase/reverse/mrf_chain/32x4",
+            [](bdd_mgr& mgr) { const std::vector<node_ref> c = mrf_chain_constraints(mgr, 32, 4); return mgr.and_rec(c.begin(), c.end()); },
+            [](bdd_mgr& mgr, node_ref& f) {
+                std::vector<size_t> reversed(mgr.nr_variables());
+                for(size_t i=0; i<reversed.size(); ++i)
+                    reversed[i] = reversed.size()-1-i;
+                return mgr.rebase(f, reversed.begin(), reversed.end()).nr_nodes();
+            });
+
+#ifdef LBDD_CONCURRENT
+    // speedup of parallel synthesis over the number of threads, forks are bounded by set_parallel_levels
+    for(const size_t nr_threads : {1, 2, 4, 8})
+        suite.run("parallel/and_rec/mrf_chain/32x5/threads_" + std::to_string(nr_threads),
+                [nr_threads](bdd_mgr& mgr) { mgr.set_nr_threads(nr_threads); return mrf_chain_constraints(mgr, 32, 5); },
+                [](bdd_mgr& mgr, std::vector<node_ref>& c) { node_ref r = mgr.and_rec(c.begin(), c.end()); return r.nr_nodes(); });
+    for(const size_t nr_threads : {1, 2, 4, 8})
+        suite.run("parallel/and_rec/queens/8/threads_" + std::to_string(nr_threads),
+                [nr_threads](bdd_mgr& mgr) { mgr.set_nr_threads(nr_threads); return queens_constraints(mgr, 8); },
+                [](bdd_mgr& mgr, std::vector<node_ref>& c) { return and_sequential(mgr, c); });
+#endif
+}
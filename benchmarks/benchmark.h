@@ -0,0 +1,55 @@
+#pragma once
+
+#include "bdd_mgr.h"
+#include <chrono>
+#include <string>
+#include <cstdio>
+
+// Minimal self-contained benchmark harness, so that benchmarks run without external dependencies.
+// Each benchmark gets a fresh bdd_mgr. Setup is not timed, memo statistics and node counts are taken over the timed part only, peak nodes over the whole lifetime of the manager.
+// Build with -DCMAKE_BUILD_TYPE=Release for meaningful numbers.
+
+namespace BDD {
+
+    class benchmark_suite {
+        public:
+            // optional first argument restricts benchmarks to those whose name contains it
+            benchmark_suite(int argc, char** argv)
+                : filter_(argc > 1 ? argv[1] : "")
+            {
+                std::printf("%-42s %10s %12s %14s %12s %12s %9s\n", "benchmark", "time [s]", "result nodes", "nodes created", "nodes/s", "peak nodes", "memo hits");
+            }
+
+            // SETUP(bdd_mgr&) returns input of WORK(bdd_mgr&, INPUT&), which returns the number of nodes of the result
+            template<typename SETUP, typename WORK>
+                void run(const std::string& name, SETUP&& setup, WORK&& work)
+                {
+                    if(name.find(filter_) == std::string::npos)
+                        return;
+                    bdd_mgr mgr;
+                    auto input = setup(mgr);
+                    mgr.reset_memo_statistics();
+                    const size_t nodes_created_begin = mgr.nr_nodes_created();
+
+                    const auto begin_time = std::chrono::steady_clock::now();
+                    const size_t result_nodes = work(mgr, input);
+                    const auto end_time = std::chrono::steady_clock::now();
+                    const double seconds = std::chrono::duration<double>(end_time - begin_time).count();
+
+                    const size_t nodes_created = mgr.nr_nodes_created() - nodes_created_begin;
+                    const memo_operation_statistics memo = mgr.memo_statistics().total();
+                    char hit_rate[16] = "-";
+                    if(memo.hits + memo.misses > 0)
+                        std::snprintf(hit_rate, sizeof(hit_rate), "%.1f%%", 100.0 * double(memo.hits) / double(memo.hits + memo.misses));
+                    // workloads outside of bdd_mgr, e.g. bdd_collection synthesis, are measured by the size of their result
+                    const size_t throughput_nodes = nodes_created > 0 ? nodes_created : result_nodes;
+                    std::printf("%-42s %10.4f %12zu %14zu %12.3g %12zu %9s\n",
+                            name.c_str(), seconds, result_nodes, nodes_created, double(throughput_nodes) / std::max(seconds, 1e-9), mgr.peak_nr_nodes(), hit_rate);
+                    std::fflush(stdout);
+                }
+
+        private:
+            const std::string filter_;
+    };
+
+}
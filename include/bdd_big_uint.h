@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace BDD {
+
+    // Arbitrary precision unsigned integer for exact model counts, which exceed 64 bits already for moderately many variables.
+    // Supports the operations needed for counting: addition, subtraction of smaller values, multiplication and shifts.
+    class big_uint {
+        public:
+            big_uint(const std::uint64_t x = 0);
+
+            big_uint& operator+=(const big_uint& o);
+            // o must not be larger
+            big_uint& operator-=(const big_uint& o);
+            big_uint& operator<<=(const std::size_t k);
+            big_uint& operator>>=(const std::size_t k);
+
+            friend big_uint operator+(big_uint a, const big_uint& b) { return a += b; }
+            friend big_uint operator-(big_uint a, const big_uint& b) { return a -= b; }
+            friend big_uint operator*(const big_uint& a, const big_uint& b);
+            friend big_uint operator<<(big_uint a, const std::size_t k) { return a <<= k; }
+            friend big_uint operator>>(big_uint a, const std::size_t k) { return a >>= k; }
+
+            bool operator==(const big_uint& o) const { return limbs_ == o.limbs_; }
+            bool operator!=(const big_uint& o) const { return !(*this == o); }
+            bool operator<(const big_uint& o) const;
+
+            bool is_zero() const { return limbs_.empty(); }
+            // nr of bits needed, i.e. floor(log2)+1 for nonzero values
+            std::size_t bit_width() const;
+            // infinity if too large
+            double to_double() const;
+            double log2() const;
+            std::string to_string() const;
+
+        private:
+            void trim();
+
+            std::vector<std::uint32_t> limbs_; // least significant first, no leading zeros
+    };
+
+}
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "bdd_mgr.h"
+#include "bdd_flat_hash_map.h"
 #include <vector>
 #include <iterator>
-#include <unordered_map> // TODO: replace with faster hash map
+#include <unordered_map>
+#include <string>
+#include <cstdint>
 
 namespace BDD {
 
@@ -32,9 +35,91 @@ namespace BDD {
     };
 
     struct bdd_instruction_hasher {
-        size_t operator()(const bdd_instruction& bdd) const { return std::hash<size_t>()(bdd.lo) ^ std::hash<size_t>()(bdd.hi) ^ std::hash<size_t>()(bdd.index); }
+        size_t operator()(const bdd_instruction& bdd) const
+        {
+            // combine asymmetrically, so that swapping lo and hi changes the hash
+            size_t h = std::hash<size_t>()(bdd.lo);
+            h ^= std::hash<size_t>()(bdd.hi) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            h ^= std::hash<size_t>()(bdd.index) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h;
+        }
     };
 
+    // algorithms on the instructions [begin,end) of a single bdd, shared by bdd_collection and mapped_bdd_collection. Arcs are positions in the instruction array
+    namespace detail {
+
+        // instructions of one bdd with positions relative to its first instruction, for model counting
+        struct instruction_count_view {
+            size_t size() const { return end - begin; }
+            size_t variable(const size_t i) const { return begin[i].index; }
+            size_t lo(const size_t i) const { return begin[i].lo - offset; }
+            size_t hi(const size_t i) const { return begin[i].hi - offset; }
+            bool is_topsink(const size_t i) const { return begin[i].is_topsink(); }
+            bool is_botsink(const size_t i) const { return begin[i].is_botsink(); }
+
+            const bdd_instruction* begin;
+            const bdd_instruction* end;
+            size_t offset;
+        };
+
+        template<typename ITERATOR>
+            bool evaluate_instructions(const bdd_instruction* instructions, const size_t begin, ITERATOR var_begin, ITERATOR var_end)
+            {
+                for(size_t i=begin;;)
+                {
+                    const bdd_instruction bdd = instructions[i];
+                    if(bdd.is_topsink())
+                        return true;
+                    if(bdd.is_botsink())
+                        return false;
+                    assert(bdd.index < std::distance(var_begin, var_end));
+                    const bool x = *(var_begin + bdd.index);
+                    if(x == true)
+                        i = bdd.hi;
+                    else
+                        i = bdd.lo;
+                } 
+            }
+
+        template<typename ITERATOR>
+            typename std::iterator_traits<ITERATOR>::value_type evaluate_instructions_batch(const bdd_instruction* instructions, const size_t begin, const size_t end, ITERATOR var_begin, ITERATOR var_end)
+            {
+                using batch = typename std::iterator_traits<ITERATOR>::value_type;
+                constexpr size_t words = std::tuple_size<batch>::value;
+
+                // assignments reaching each instruction. Instructions come in topological order, so each is complete when visited
+                static thread_local std::vector<batch> reach;
+                reach.assign(end - begin, batch{});
+                reach[0].fill(~std::uint64_t(0));
+                batch result = {};
+                for(size_t i=begin; i<end; ++i)
+                {
+                    const bdd_instruction& instr = instructions[i];
+                    const batch& r = reach[i - begin];
+                    if(instr.is_topsink())
+                    {
+                        result = r;
+                        continue;
+                    }
+                    if(instr.is_botsink())
+                        continue;
+                    assert(instr.index < std::distance(var_begin, var_end));
+                    const batch& x = *(var_begin + instr.index);
+                    batch& lo = reach[instr.lo - begin];
+                    batch& hi = reach[instr.hi - begin];
+                    for(size_t w=0; w<words; ++w)
+                    {
+                        lo[w] |= r[w] & ~x[w];
+                        hi[w] |= r[w] & x[w];
+                    }
+                }
+                return result;
+            }
+
+        std::vector<size_t> instruction_variables(const bdd_instruction* instructions, const size_t begin, const size_t end);
+
+    }
+
     template<size_t N>
     struct array_hasher {
         size_t hash_combine(size_t lhs, size_t rhs) const
@@ -54,6 +139,23 @@ namespace BDD {
         } 
     };
 
+    // operand tuple of the n-ary meld, a slice of an arena of instruction indices. The hash is computed while the tuple is written
+    struct meld_tuple {
+        const std::vector<size_t>* arena = nullptr;
+        size_t begin = 0;
+        size_t size = 0;
+        size_t hash = 0;
+
+        bool operator==(const meld_tuple& o) const
+        {
+            return hash == o.hash && size == o.size && std::equal(arena->begin() + begin, arena->begin() + begin + size, o.arena->begin() + o.begin);
+        }
+    };
+
+    struct meld_tuple_hasher {
+        size_t operator()(const meld_tuple& t) const { return t.hash; }
+    };
+
     class bdd_collection_entry;
 
     // convenience class for wrapping bdd node
@@ -118,19 +220,39 @@ namespace BDD {
         friend class bdd_collection_node;
         friend class bdd_collection_entry;
         public:
-            // synthesize bdd unless it has too many nodes. If so, return std::numeric_limits<size_t>::max()
+            // Synthesis and the linear constraint compilers return std::numeric_limits<size_t>::max() instead of a bdd number if the result is constant or needs more than node_limit nodes.
+            // last_result tells these cases apart for the last call of one of them
+            enum class result_kind { bdd, constant_false, constant_true, node_limit_exceeded };
+            result_kind last_result() const { return last_result_; }
+
+            // synthesize i op j for a binary_operator of bdd_operators.h and return its number, or std::numeric_limits<size_t>::max() if the result is constant or too large.
+            // It is too large if the meld requests, an upper bound on the nodes of the result, or the result itself need more than node_limit nodes
+            template<typename OP>
+                size_t bdd_apply(const size_t i, const size_t j, const size_t node_limit = std::numeric_limits<size_t>::max());
             size_t bdd_and(const size_t i, const size_t j, const size_t node_limit = std::numeric_limits<size_t>::max());
             size_t bdd_and(const int i, const int j, const size_t node_limit = std::numeric_limits<size_t>::max()) { return bdd_and(size_t(i), size_t(j), node_limit); }
+            // more than two bdds are melded at once, for any number of them. Results as for bdd_apply
             template<typename BDD_ITERATOR>
                 size_t bdd_and(BDD_ITERATOR bdd_begin, BDD_ITERATOR bdd_end, const size_t node_limit = std::numeric_limits<size_t>::max());
 
-            // compute disjunction 
-            size_t bdd_or(const size_t i, const size_t j);
+            size_t bdd_or(const size_t i, const size_t j, const size_t node_limit = std::numeric_limits<size_t>::max());
+            size_t bdd_xor(const size_t i, const size_t j, const size_t node_limit = std::numeric_limits<size_t>::max());
             template<typename VAR_MAP>
                 size_t bdd_or_var(const size_t i, const VAR_MAP& positive_variables, const VAR_MAP& negative_variables);
 
+            // import by one marked traversal, the position of each node in the output is kept in the node itself. Must not run concurrently with operations of the bdd_mgr
+            // Instructions hold variables. After the manager has reordered them, paths need not visit variables in increasing order, such bdds can be evaluated, rebased and exported, but synthesis and model counting in the collection require the order.
             size_t add_bdd(node_ref bdd);
+            // import each root as a separate bdd, returns the number of the first one. Scratch memory is shared between the imports
+            template<typename NODE_REF_ITERATOR>
+                size_t add_bdds(NODE_REF_ITERATOR root_begin, NODE_REF_ITERATOR root_end);
             node_ref export_bdd(bdd_mgr& mgr, const size_t bdd_nr) const;
+            // linear pseudo-Boolean constraints sum_i coefficients_i * x_{variables_i} <= bound resp. == bound, coefficients may be negative and variables repeat.
+            // The bdd is written directly, return its number or std::numeric_limits<size_t>::max() if the constraint is constant.
+            template<typename VARIABLE_ITERATOR, typename COEFFICIENT_ITERATOR>
+                size_t add_linear_at_most(VARIABLE_ITERATOR var_begin, VARIABLE_ITERATOR var_end, COEFFICIENT_ITERATOR coefficient_begin, const std::int64_t bound);
+            template<typename VARIABLE_ITERATOR, typename COEFFICIENT_ITERATOR>
+                size_t add_linear_equal(VARIABLE_ITERATOR var_begin, VARIABLE_ITERATOR var_end, COEFFICIENT_ITERATOR coefficient_begin, const std::int64_t bound);
             size_t nr_bdds() const { return bdd_delimiters.size()-1; }
             size_t size() const { return nr_bdds(); }
             size_t nr_bdd_nodes(const size_t bdd_nr) const;
@@ -138,6 +260,16 @@ namespace BDD {
             size_t offset(const bdd_instruction& instr) const;
             template<typename ITERATOR>
                 bool evaluate(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const;
+            // iterators point to one assignment_batch per variable, bit k of the result tells whether assignment k is satisfying. One pass over the instructions propagates the whole batch.
+            template<typename ITERATOR>
+                typename std::iterator_traits<ITERATOR>::value_type evaluate_batch(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const;
+            // number of satisfying assignments of variables 0,...,nr_vars-1 by one reverse sweep over the instructions. COUNT is double, log2_count or big_uint
+            template<typename COUNT = double>
+                COUNT model_count(const size_t bdd_nr, const size_t nr_vars) const;
+            // for each variable the number of satisfying assignments setting it to 1, by a backward and a forward sweep
+            template<typename COUNT = double>
+                std::vector<COUNT> positive_counts(const size_t bdd_nr, const size_t nr_vars) const;
+            // rename variables in place. Maps not preserving the order leave instructions that export_bdd repairs, but that synthesis in the collection does not support
             template<typename ITERATOR>
                 void rebase(const size_t bdd_nr, ITERATOR var_map_begin, ITERATOR var_map_end);
             template<typename VAR_MAP>
@@ -148,9 +280,13 @@ namespace BDD {
                 void remove(ITERATOR bdd_it_begin, ITERATOR bdd_it_end);
 
             bdd_collection_entry operator[](const size_t bdd_nr);
+            // remove all bdds, memory is kept
+            void clear() { bdd_instructions.clear(); bdd_delimiters.resize(1); }
 
             template<typename STREAM>
                 void export_graphviz(const size_t bdd_nr, STREAM& s) const;
+            // write all bdds in the binary format read by mapped_bdd_collection. Throws std::runtime_error on failure
+            void save(const std::string& filename) const;
             auto get_bdd_instructions(const size_t bdd_nr) const { return std::make_pair(bdd_instructions.begin() + bdd_delimiters[bdd_nr], bdd_instructions.begin() + bdd_delimiters[bdd_nr+1]); }
             auto get_reverse_bdd_instructions(const size_t bdd_nr) const { return std::make_pair(bdd_instructions.begin() + bdd_delimiters[bdd_nr], bdd_instructions.begin() + bdd_delimiters[bdd_nr+1]); }
 
@@ -160,48 +296,94 @@ namespace BDD {
             void close_bdd();
 
         private:
-            size_t bdd_and_impl(const size_t i, const size_t j, const size_t node_limit);
-            template<size_t N>
-                size_t bdd_and(const std::array<size_t,N>& bdds, const size_t node_limit);
-            template<size_t N>
-            size_t bdd_and_impl(const std::array<size_t,N>& bdds, std::unordered_map<std::array<size_t,N>,size_t,array_hasher<N>>& generated_nodes, const size_t node_limit);
+            template<typename OP>
+                size_t meld_breadth_first(const size_t i, const size_t j, const size_t node_limit);
+            // append the bdd on stack with root root_idx on top, return its number or std::numeric_limits<size_t>::max() if root_idx is a terminal or invalid. Sets last_result_
+            size_t append_stack(const size_t root_idx);
+            size_t bdd_and(std::vector<size_t> bdds, const size_t node_limit);
+            size_t bdd_and_impl(const size_t tuple_begin, const size_t tuple_size, const size_t node_limit);
+            // terms given by variable and coefficient
+            size_t add_linear_constraint(std::vector<std::pair<size_t,std::int64_t>>& terms, std::int64_t bound, const bool equality);
             size_t splitting_variable(const bdd_instruction& k, const bdd_instruction& l) const;
-            size_t add_bdd_impl(node_ref bdd);
             bool is_bdd(const size_t i) const;
             // bring last DAG into BDD-form
             void reduce();
 
             std::vector<bdd_instruction> bdd_instructions;
             std::vector<size_t> bdd_delimiters = {0};
+            result_kind last_result_ = result_kind::bdd;
 
             // temporary memory for bdd synthesis
             std::vector<bdd_instruction> stack; // for computing bdd meld;
 
-            std::unordered_map<std::array<size_t,2>,size_t, array_hasher<2>> generated_nodes; // given nodes of left and right bdd, has melded template be generated?
-            std::unordered_map<bdd_instruction,size_t,bdd_instruction_hasher> reduction; // for generating a restricted graph. Given a variable index and left and right descendant, has node been generated?
-
-            // node_ref -> index in bdd_instructions
-            std::unordered_map<node_ref, size_t> node_ref_hash;
+            flat_hash_map<std::array<size_t,2>,size_t, array_hasher<2>> generated_nodes; // given nodes of left and right bdd, index of melded node on stack
+            flat_hash_map<bdd_instruction,size_t,bdd_instruction_hasher> reduction; // for generating a restricted graph. Given a variable index and left and right descendant, has node been generated?
+
+            // n-ary meld: operand tuples are slices of meld_arena, operands resolved to topsink are dropped
+            std::vector<size_t> meld_arena;
+            flat_hash_map<meld_tuple,size_t,meld_tuple_hasher> meld_tuples; // index of melded node on stack
+
+            // requests of breadth-first meld, one queue per variable level. Descendants are referenced by level and position in level, terminals lie on level meld_levels.size()
+            struct meld_request {
+                size_t f, g; // instructions of left and right bdd
+                size_t lo_level, lo;
+                size_t hi_level, hi;
+                size_t meld; // index of reduced node on stack
+            };
+            std::vector<std::vector<meld_request>> meld_levels;
+            std::vector<size_t> meld_variables; // variable of each level
+            std::vector<size_t> f_levels, g_levels; // level of instructions in left and right bdd
+
+            // temporary memory for importing bdds: non-terminal nodes in postorder and the traversal stack
+            std::vector<node*> import_nodes;
+            std::vector<node*> import_stack;
+#ifdef LBDD_COMPACT_NODES
+            // compact nodes have no field to spare for the postorder position
+            flat_hash_map<node*, size_t, std::hash<node*>> import_positions;
+#endif
     };
 
+    template<typename VARIABLE_ITERATOR, typename COEFFICIENT_ITERATOR>
+        size_t bdd_collection::add_linear_at_most(VARIABLE_ITERATOR var_begin, VARIABLE_ITERATOR var_end, COEFFICIENT_ITERATOR coefficient_begin, const std::int64_t bound)
+        {
+            std::vector<std::pair<size_t,std::int64_t>> terms;
+            auto coefficient_it = coefficient_begin;
+            for(auto it=var_begin; it!=var_end; ++it, ++coefficient_it)
+                terms.push_back({*it, *coefficient_it});
+            return add_linear_constraint(terms, bound, false);
+        }
+
+    template<typename VARIABLE_ITERATOR, typename COEFFICIENT_ITERATOR>
+        size_t bdd_collection::add_linear_equal(VARIABLE_ITERATOR var_begin, VARIABLE_ITERATOR var_end, COEFFICIENT_ITERATOR coefficient_begin, const std::int64_t bound)
+        {
+            std::vector<std::pair<size_t,std::int64_t>> terms;
+            auto coefficient_it = coefficient_begin;
+            for(auto it=var_begin; it!=var_end; ++it, ++coefficient_it)
+                terms.push_back({*it, *coefficient_it});
+            return add_linear_constraint(terms, bound, true);
+        }
+
     template<typename ITERATOR>
         bool bdd_collection::evaluate(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const
         {
             assert(bdd_nr < nr_bdds());
-            for(size_t i=bdd_delimiters[bdd_nr];;)
-            {
-                const bdd_instruction bdd = bdd_instructions[i];
-                if(bdd.is_topsink())
-                    return true;
-                if(bdd.is_botsink())
-                    return false;
-                assert(bdd.index < std::distance(var_begin, var_end));
-                const bool x = *(var_begin + bdd.index);
-                if(x == true)
-                    i = bdd.hi;
-                else
-                    i = bdd.lo;
-            } 
+            return detail::evaluate_instructions(bdd_instructions.data(), bdd_delimiters[bdd_nr], var_begin, var_end);
+        }
+
+    template<typename ITERATOR>
+        typename std::iterator_traits<ITERATOR>::value_type bdd_collection::evaluate_batch(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const
+        {
+            assert(bdd_nr < nr_bdds());
+            return detail::evaluate_instructions_batch(bdd_instructions.data(), bdd_delimiters[bdd_nr], bdd_delimiters[bdd_nr+1], var_begin, var_end);
+        }
+
+    template<typename NODE_REF_ITERATOR>
+        size_t bdd_collection::add_bdds(NODE_REF_ITERATOR root_begin, NODE_REF_ITERATOR root_end)
+        {
+            const size_t first_bdd_nr = nr_bdds();
+            for(auto it=root_begin; it!=root_end; ++it)
+                add_bdd(*it);
+            return first_bdd_nr;
         }
 
     template<typename ITERATOR>
@@ -300,74 +482,175 @@ namespace BDD {
             }
         }
 
-    template<size_t N, typename ITERATOR>
-        std::array<size_t,N> construct_array(ITERATOR begin, ITERATOR end)
+    template<typename OP>
+        size_t bdd_collection::bdd_apply(const size_t i, const size_t j, const size_t node_limit)
+        {
+            assert(i < nr_bdds());
+            assert(j < nr_bdds());
+            assert(stack.empty());
+            assert(generated_nodes.empty());
+            assert(reduction.empty());
+            assert(node_limit > 2);
+
+            // generate terminal vertices
+            stack.push_back(bdd_instruction::botsink());
+            stack.push_back(bdd_instruction::topsink());
+            const size_t bdd_nr = append_stack(meld_breadth_first<OP>(i, j, node_limit));
+
+            generated_nodes.clear();
+            reduction.clear();
+            stack.clear();
+            for(auto& requests : meld_levels)
+                requests.clear();
+            return bdd_nr;
+        }
+
+    // Algorithm S in Volume 4a of Knuth's "The Art of Computer Programming".
+    // First all meld requests are generated top-down, level by level. Then they are reduced bottom-up, again level by level.
+    // Each level is a contiguous queue of requests, hence both passes access memory sequentially.
+    // Terminal cases follow from the truth table of OP. Return index of root on stack or std::numeric_limits<size_t>::max() if more than node_limit nodes are needed.
+    // Each request gives at most one node, so synthesis already stops while generating requests once they could exceed node_limit, before the result is reduced.
+    template<typename OP>
+        size_t bdd_collection::meld_breadth_first(const size_t i, const size_t j, const size_t node_limit)
         {
-            assert(std::distance(begin,end) == N);
-            std::array<size_t,N> a;
-            auto it = begin;
-            for(size_t i=0; i<N; ++i, ++it)
-                a[i] = *it;
-            return a;
+            // variables occurring in either bdd determine the levels
+            const std::vector<size_t> f_vars = variables(i);
+            const std::vector<size_t> g_vars = variables(j);
+            meld_variables.clear();
+            std::set_union(f_vars.begin(), f_vars.end(), g_vars.begin(), g_vars.end(), std::back_inserter(meld_variables));
+            const size_t nr_levels = meld_variables.size();
+            const size_t terminal_level = nr_levels;
+            if(meld_levels.size() < nr_levels)
+                meld_levels.resize(nr_levels);
+
+            auto compute_levels = [&](const size_t bdd_nr, std::vector<size_t>& levels) {
+                levels.clear();
+                for(size_t k=bdd_delimiters[bdd_nr]; k<bdd_delimiters[bdd_nr+1]; ++k)
+                {
+                    const bdd_instruction& instr = bdd_instructions[k];
+                    if(instr.is_terminal())
+                        levels.push_back(terminal_level);
+                    else
+                        levels.push_back(std::lower_bound(meld_variables.begin(), meld_variables.end(), instr.index) - meld_variables.begin());
+                }
+            };
+            compute_levels(i, f_levels);
+            compute_levels(j, g_levels);
+            const size_t f_offset = bdd_delimiters[i];
+            const size_t g_offset = bdd_delimiters[j];
+
+            // upper bound on the nodes on stack after reduction
+            size_t nr_nodes_bound = stack.size();
+
+            // return level and position of request (f_i,g_i), enqueue it if not yet present
+            auto request = [&](const size_t f_i, const size_t g_i) -> std::array<size_t,2> {
+                const bdd_instruction& f = bdd_instructions[f_i];
+                const bdd_instruction& g = bdd_instructions[g_i];
+                // botsink and topsink lie at positions 0 and 1 on the stack. An operand that is terminal either fixes the result or the other operand is copied resp. negated
+                if(f.is_terminal() && g.is_terminal())
+                    return {terminal_level, OP::value(f.is_topsink(), g.is_topsink())};
+                if(f.is_terminal() && OP::value(f.is_topsink(), false) == OP::value(f.is_topsink(), true))
+                    return {terminal_level, OP::value(f.is_topsink(), false)};
+                if(g.is_terminal() && OP::value(false, g.is_topsink()) == OP::value(true, g.is_topsink()))
+                    return {terminal_level, OP::value(false, g.is_topsink())};
+
+                const size_t level = std::min(f_levels[f_i - f_offset], g_levels[g_i - g_offset]);
+                if(const size_t* pos = generated_nodes.find({f_i,g_i}))
+                    return {level, *pos};
+                const size_t pos = meld_levels[level].size();
+                meld_levels[level].push_back({f_i, g_i, 0, 0, 0, 0, 0});
+                generated_nodes.insert({f_i,g_i}, pos);
+                ++nr_nodes_bound;
+                return {level, pos};
+            };
+
+            const std::array<size_t,2> root = request(bdd_delimiters[i], bdd_delimiters[j]);
+            if(root[0] == terminal_level)
+                return root[1];
+            assert(root[0] == 0 && root[1] == 0);
+
+            // top-down: generate requests for descendants. Descendants lie on strictly larger levels.
+            for(size_t l=0; l<nr_levels; ++l)
+            {
+                const size_t v = meld_variables[l];
+                std::vector<meld_request>& requests = meld_levels[l];
+                for(size_t k=0; k<requests.size(); ++k)
+                {
+                    const bdd_instruction& f = bdd_instructions[requests[k].f];
+                    const bdd_instruction& g = bdd_instructions[requests[k].g];
+                    const std::array<size_t,2> lo = request(
+                            v == f.index ? f.lo : requests[k].f,
+                            v == g.index ? g.lo : requests[k].g);
+                    const std::array<size_t,2> hi = request(
+                            v == f.index ? f.hi : requests[k].f,
+                            v == g.index ? g.hi : requests[k].g);
+                    requests[k].lo_level = lo[0];
+                    requests[k].lo = lo[1];
+                    requests[k].hi_level = hi[0];
+                    requests[k].hi = hi[1];
+                    if(nr_nodes_bound > node_limit)
+                    {
+                        // give back the memory of the requests, they may be many more than the limit
+                        meld_levels.clear();
+                        return std::numeric_limits<size_t>::max();
+                    }
+                }
+            }
+
+            auto meld = [&](const size_t level, const size_t pos) {
+                if(level == terminal_level)
+                    return pos;
+                return meld_levels[level][pos].meld;
+            };
+
+            // bottom-up: reduce requests. Reduced nodes of different levels are distinct, so the reduction table only needs to hold the current level.
+            for(ptrdiff_t l=nr_levels-1; l>=0; --l)
+            {
+                const size_t v = meld_variables[l];
+                reduction.clear();
+                for(meld_request& r : meld_levels[l])
+                {
+                    const size_t lo = meld(r.lo_level, r.lo);
+                    const size_t hi = meld(r.hi_level, r.hi);
+                    if(lo == hi)
+                    {
+                        r.meld = lo;
+                        continue;
+                    }
+                    if(const size_t* reduced_idx = reduction.find({lo,hi,v}))
+                    {
+                        r.meld = *reduced_idx;
+                        continue;
+                    }
+                    stack.push_back({lo, hi, v});
+                    if(stack.size() > node_limit)
+                        return std::numeric_limits<size_t>::max();
+                    r.meld = stack.size()-1;
+                    reduction.insert({lo,hi,v}, r.meld);
+                }
+            }
+
+            return meld_levels[0][0].meld;
         }
 
     template<typename BDD_ITERATOR>
         size_t bdd_collection::bdd_and(BDD_ITERATOR bdd_begin, BDD_ITERATOR bdd_end, const size_t node_limit)
         {
             const size_t nr_bdds = std::distance(bdd_begin, bdd_end);
-
-            switch(nr_bdds) {
-                case 1: return *bdd_begin;
-                case 2: { const size_t i = *bdd_begin; ++bdd_begin; const size_t j = *bdd_begin; return bdd_and(i, j, node_limit); }
-                case 3: { auto b = construct_array<3>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 4: { auto b = construct_array<4>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 5: { auto b = construct_array<5>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 6: { auto b = construct_array<6>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 7: { auto b = construct_array<7>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 8: { auto b = construct_array<8>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 9: { auto b = construct_array<9>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 10: { auto b = construct_array<10>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 11: { auto b = construct_array<11>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 12: { auto b = construct_array<12>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 13: { auto b = construct_array<13>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 14: { auto b = construct_array<14>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 15: { auto b = construct_array<15>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 16: { auto b = construct_array<16>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 17: { auto b = construct_array<17>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 18: { auto b = construct_array<18>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 19: { auto b = construct_array<19>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 20: { auto b = construct_array<20>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 21: { auto b = construct_array<21>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 22: { auto b = construct_array<22>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 23: { auto b = construct_array<23>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 24: { auto b = construct_array<24>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 25: { auto b = construct_array<25>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 26: { auto b = construct_array<26>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 27: { auto b = construct_array<27>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 28: { auto b = construct_array<28>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 29: { auto b = construct_array<29>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 30: { auto b = construct_array<30>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 31: { auto b = construct_array<31>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 32: { auto b = construct_array<32>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 33: { auto b = construct_array<33>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 34: { auto b = construct_array<34>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 35: { auto b = construct_array<35>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 36: { auto b = construct_array<36>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 37: { auto b = construct_array<37>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 38: { auto b = construct_array<38>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 39: { auto b = construct_array<39>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 40: { auto b = construct_array<40>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 41: { auto b = construct_array<41>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 42: { auto b = construct_array<42>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 43: { auto b = construct_array<43>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 44: { auto b = construct_array<44>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 45: { auto b = construct_array<45>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 46: { auto b = construct_array<46>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 47: { auto b = construct_array<47>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 48: { auto b = construct_array<48>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                case 49: { auto b = construct_array<49>(bdd_begin, bdd_end); return bdd_and(b, node_limit); }
-                default: throw std::runtime_error("generic and not implemented.");
+            assert(nr_bdds > 0);
+            if(nr_bdds == 1)
+            {
+                last_result_ = result_kind::bdd;
+                return *bdd_begin;
+            }
+            if(nr_bdds == 2)
+            {
+                const size_t i = *bdd_begin;
+                ++bdd_begin;
+                const size_t j = *bdd_begin;
+                return bdd_and(i, j, node_limit);
             }
+            return bdd_and(std::vector<size_t>(bdd_begin, bdd_end), node_limit);
         }
 
     template<typename VAR_SET>
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+
+namespace BDD {
+
+    // Open addressing hash map with linear probing for small trivially copyable keys and values, as used in bdd_collection synthesis.
+    // Slots carry the epoch in which they were written and slots of earlier epochs count as empty. Hence clear() takes constant time and keeps memory, so that repeated synthesis calls do not reallocate.
+    template<typename KEY, typename VALUE, typename HASH>
+    class flat_hash_map {
+        public:
+            flat_hash_map(const std::size_t initial_capacity = 1024)
+            {
+                std::size_t capacity = 16;
+                while(capacity < initial_capacity)
+                    capacity *= 2;
+                slots_.resize(capacity);
+                mask_ = capacity - 1;
+            }
+
+            // pointer to value stored for key or nullptr if key is not present
+            VALUE* find(const KEY& key)
+            {
+                for(std::size_t i = slot_index(key);; i = (i+1) & mask_)
+                {
+                    slot& s = slots_[i];
+                    if(s.epoch != epoch_)
+                        return nullptr;
+                    if(s.key == key)
+                        return &s.value;
+                }
+            }
+
+            // key must not be present
+            void insert(const KEY& key, const VALUE& value)
+            {
+                assert(find(key) == nullptr);
+                if(2*(size_+1) > slots_.size())
+                    grow();
+                insert_impl(key, value);
+            }
+
+            std::size_t size() const { return size_; }
+            bool empty() const { return size_ == 0; }
+
+            void clear()
+            {
+                size_ = 0;
+                if(++epoch_ == 0) // wrapped around, slots of old epochs could be mistaken for occupied
+                {
+                    for(slot& s : slots_)
+                        s.epoch = 0;
+                    epoch_ = 1;
+                }
+            }
+
+        private:
+            struct slot {
+                KEY key;
+                VALUE value;
+                std::uint32_t epoch = 0;
+            };
+
+            std::size_t slot_index(const KEY& key) const
+            {
+                // finalizer of MurmurHash3, combined hashes of indices are not random enough in their lower bits for linear probing
+                std::size_t h = HASH()(key);
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdULL;
+                h ^= h >> 33;
+                h *= 0xc4ceb9fe1a85ec53ULL;
+                h ^= h >> 33;
+                return h & mask_;
+            }
+
+            void insert_impl(const KEY& key, const VALUE& value)
+            {
+                std::size_t i = slot_index(key);
+                while(slots_[i].epoch == epoch_)
+                    i = (i+1) & mask_;
+                slots_[i] = slot{key, value, epoch_};
+                ++size_;
+            }
+
+            void grow()
+            {
+                std::vector<slot> old_slots(2*slots_.size());
+                std::swap(old_slots, slots_);
+                mask_ = slots_.size() - 1;
+                const std::uint32_t old_epoch = epoch_;
+                epoch_ = 1;
+                size_ = 0;
+                for(const slot& s : old_slots)
+                    if(s.epoch == old_epoch)
+                        insert_impl(s.key, s.value);
+            }
+
+            std::vector<slot> slots_;
+            std::size_t mask_;
+            std::size_t size_ = 0;
+            std::uint32_t epoch_ = 1;
+    };
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+namespace BDD {
+
+    namespace detail {
+
+        // Compiles sum_i coefficients[i] * l_i <= bound resp. == bound over literals l_i into a bdd with the literals tested in the given order.
+        // Coefficients must be positive, the callers bring negative ones to this form by negating the literal.
+        // Bounds are memoized per level as intervals of remainders sharing one node (Abio et al., A New Look at BDDs for Pseudo-Boolean Constraints), so each node is built once and the result is reduced.
+        class linear_constraint_compiler {
+            public:
+                constexpr static size_t botsink = 0;
+                constexpr static size_t topsink = 1;
+                // false_child and true_child are taken when the literal is false resp. true
+                struct node {
+                    size_t literal;
+                    size_t false_child;
+                    size_t true_child;
+                };
+
+                // return the root, nodes() holds the non-terminal nodes numbered from 2 on, children before parents
+                size_t compile_at_most(const std::vector<std::int64_t>& coefficients, const std::int64_t bound);
+                size_t compile_equal(const std::vector<std::int64_t>& coefficients, const std::int64_t bound);
+
+                const std::vector<node>& nodes() const { return nodes_; }
+                const node& operator[](const size_t i) const { return nodes_[i-2]; }
+
+            private:
+                struct interval {
+                    std::int64_t lower, upper;
+                    size_t node;
+                };
+                void init(const std::vector<std::int64_t>& coefficients);
+                interval at_most(const size_t i, const std::int64_t bound);
+                interval equal(const size_t i, const std::int64_t bound);
+                size_t make_node(const size_t i, const size_t false_child, const size_t true_child);
+
+                std::vector<std::int64_t> coefficients_;
+                std::vector<std::int64_t> suffix_sums_; // sum of coefficients from literal i on
+                std::vector<std::map<std::int64_t, interval>> memo_; // per literal, intervals by lower end
+                std::vector<node> nodes_;
+        };
+
+    }
+
+}
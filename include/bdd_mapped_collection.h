@@ -0,0 +1,97 @@
+#pragma once
+
+#include "bdd_collection.h"
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <cstdint>
+#include <cassert>
+
+namespace BDD {
+
+    // On-disk layout written by bdd_collection::save: this header, the nr_bdds+1 delimiters and the instructions, each as 64 bit words in the byte order of the writer.
+    // Delimiters and instructions are stored exactly as held in memory, so a mapped file is used as is.
+    struct bdd_collection_file_header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order; // byte_order_mark as written, differs when read on a machine of other endianness
+        std::uint32_t word_size; // sizeof(size_t)
+        std::uint32_t instruction_size; // sizeof(bdd_instruction)
+        std::uint64_t nr_bdds;
+        std::uint64_t nr_instructions;
+
+        constexpr static char file_magic[8] = {'L','B','D','D','C','O','L','\0'};
+        constexpr static std::uint32_t current_version = 1;
+        constexpr static std::uint32_t byte_order_mark = 0x01020304;
+    };
+    static_assert(sizeof(bdd_collection_file_header) % sizeof(size_t) == 0, "delimiters after the header must stay aligned");
+
+    // Read-only bdd collection served from a file written by bdd_collection::save.
+    // The file is memory-mapped, bdds are read in place without parsing or copying. Throws std::runtime_error if the file cannot be mapped or has the wrong format.
+    // The format check covers the header, the delimiters and the arcs of all instructions by one pass when mapping.
+    class mapped_bdd_collection {
+        public:
+            explicit mapped_bdd_collection(const std::string& filename);
+            ~mapped_bdd_collection();
+            mapped_bdd_collection(mapped_bdd_collection&& o);
+            mapped_bdd_collection& operator=(mapped_bdd_collection&& o);
+            mapped_bdd_collection(const mapped_bdd_collection&) = delete;
+            mapped_bdd_collection& operator=(const mapped_bdd_collection&) = delete;
+
+            size_t nr_bdds() const { return nr_bdds_; }
+            size_t size() const { return nr_bdds(); }
+            size_t nr_bdd_nodes(const size_t bdd_nr) const { assert(bdd_nr < nr_bdds()); return delimiters_[bdd_nr+1] - delimiters_[bdd_nr]; }
+            size_t nr_bdd_nodes(const size_t bdd_nr, const size_t variable) const;
+            size_t offset(const bdd_instruction& instr) const { assert(&instr >= instructions_ && &instr < instructions_ + delimiters_[nr_bdds_]); return &instr - instructions_; }
+            auto get_bdd_instructions(const size_t bdd_nr) const { assert(bdd_nr < nr_bdds()); return std::make_pair(instructions_ + delimiters_[bdd_nr], instructions_ + delimiters_[bdd_nr+1]); }
+            std::vector<size_t> variables(const size_t bdd_nr) const;
+            node_ref export_bdd(bdd_mgr& mgr, const size_t bdd_nr) const;
+
+            template<typename ITERATOR>
+                bool evaluate(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const;
+            template<typename ITERATOR>
+                typename std::iterator_traits<ITERATOR>::value_type evaluate_batch(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const;
+            template<typename COUNT = double>
+                COUNT model_count(const size_t bdd_nr, const size_t nr_vars) const;
+            template<typename COUNT = double>
+                std::vector<COUNT> positive_counts(const size_t bdd_nr, const size_t nr_vars) const;
+
+        private:
+            void unmap();
+            detail::instruction_count_view count_view(const size_t bdd_nr) const;
+
+            void* data_ = nullptr;
+            size_t data_size_ = 0;
+            size_t nr_bdds_ = 0;
+            const size_t* delimiters_ = nullptr;
+            const bdd_instruction* instructions_ = nullptr;
+    };
+
+    template<typename ITERATOR>
+        bool mapped_bdd_collection::evaluate(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const
+        {
+            assert(bdd_nr < nr_bdds());
+            return detail::evaluate_instructions(instructions_, delimiters_[bdd_nr], var_begin, var_end);
+        }
+
+    template<typename ITERATOR>
+        typename std::iterator_traits<ITERATOR>::value_type mapped_bdd_collection::evaluate_batch(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const
+        {
+            assert(bdd_nr < nr_bdds());
+            return detail::evaluate_instructions_batch(instructions_, delimiters_[bdd_nr], delimiters_[bdd_nr+1], var_begin, var_end);
+        }
+
+    template<typename COUNT>
+        COUNT mapped_bdd_collection::model_count(const size_t bdd_nr, const size_t nr_vars) const
+        {
+            return detail::model_count<COUNT>(count_view(bdd_nr), nr_vars);
+        }
+
+    template<typename COUNT>
+        std::vector<COUNT> mapped_bdd_collection::positive_counts(const size_t bdd_nr, const size_t nr_vars) const
+        {
+            return detail::positive_counts<COUNT>(count_view(bdd_nr), nr_vars);
+        }
+
+}
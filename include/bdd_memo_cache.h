@@ -3,29 +3,47 @@
 #include "bdd_node.h"
 #include "bdd_node_cache.h"
 #include <vector>
-#include <unordered_map>
 #include <array>
+#include <cstdint>
+#include <cassert>
+#ifdef LBDD_CONCURRENT
+#include <mutex>
+#include <shared_mutex>
+#endif
 
 namespace BDD {
 
 
+    // tags of memos not keyed by a third node
+    enum class memo_operation : std::uintptr_t { and_op = 1, or_op = 2, xor_op = 3, exists_op = 4, forall_op = 5, nand_op = 6, implies_op = 7, diff_op = 8, equiv_op = 9 };
+    constexpr static std::size_t nr_memo_operations = 10;
+
     struct memo_struct {
         node* f = nullptr;
         node* g = nullptr;
         node* h = nullptr;
         node* r = nullptr;
 
-        template<typename T>
-        constexpr static node* and_symb_impl() { return static_cast<T*>(nullptr) + 1; }
-        constexpr static node* and_symb() { return and_symb_impl<node>(); }
-
-        template<typename T>
-        constexpr static node* or_symb_impl() { return static_cast<T*>(nullptr) + 2; }
-        constexpr static node* or_symb() { return or_symb_impl<node>(); }
-
-        template<typename T>
-        constexpr static node* xor_symb_impl() { return static_cast<T*>(nullptr) + 3; }
-        constexpr static node* xor_symb() { return or_symb_impl<node>(); }
+        // the operation of a memo keyed by (f, g, symbol(op)). Symbols are distinct, aligned non-null addresses no node can have
+        static node* symbol(const memo_operation op) { return reinterpret_cast<node*>(static_cast<std::uintptr_t>(op) * sizeof(node)); }
+        static bool is_operation_symbol(node* p)
+        {
+            const std::uintptr_t a = reinterpret_cast<std::uintptr_t>(p);
+            return a != 0 && a % sizeof(node) == 0 && a / sizeof(node) < nr_memo_operations;
+        }
+        static memo_operation operation(node* p) { assert(is_operation_symbol(p)); return static_cast<memo_operation>(reinterpret_cast<std::uintptr_t>(p) / sizeof(node)); }
+
+        static node* and_symb() { return symbol(memo_operation::and_op); }
+        static node* or_symb() { return symbol(memo_operation::or_op); }
+        static node* xor_symb() { return symbol(memo_operation::xor_op); }
+        // quantification memos are keyed by (f, cube, symbol)
+        static node* exists_symb() { return symbol(memo_operation::exists_op); }
+        static node* forall_symb() { return symbol(memo_operation::forall_op); }
+
+        // and_exists memos are keyed by (f, g, cube) with the lowest bit of the cube pointer set, to distinguish them from ite memos
+        static node* and_exists_key(node* cube) { return reinterpret_cast<node*>(reinterpret_cast<std::uintptr_t>(cube) | 1); }
+        static bool is_and_exists_key(node* p) { return (reinterpret_cast<std::uintptr_t>(p) & 1) != 0; }
+        static node* and_exists_cube(node* p) { return reinterpret_cast<node*>(reinterpret_cast<std::uintptr_t>(p) & ~std::uintptr_t(1)); }
 
         bool operator==(const memo_struct& m) const;
         bool operator!=(const memo_struct& m) const;
@@ -35,40 +53,72 @@ namespace BDD {
 
     using memo = memo_struct;
 
+    // counters of memo cache activity for one operation
+    struct memo_operation_statistics {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t inserts = 0;
+        size_t evictions = 0; // valid entries overwritten because their set was full
+    };
+
+    struct memo_cache_statistics {
+        enum class operation : size_t { and_op = 0, or_op = 1, xor_op = 2, ite_op = 3, exists_op = 4, forall_op = 5, and_exists_op = 6, nand_op = 7, implies_op = 8, diff_op = 9, equiv_op = 10 };
+        constexpr static size_t nr_operations = 11;
+        std::array<memo_operation_statistics, nr_operations> ops = {};
+        size_t nr_slots = 0; // current capacity in memos
+
+        const memo_operation_statistics& operator[](const operation op) const { return ops[size_t(op)]; }
+        memo_operation_statistics total() const;
+    };
+
+    // default upper bound for memory taken by memos
+    constexpr static std::size_t default_memo_cache_budget = static_cast<std::size_t>(256) << 20; // 256 MB
+
+    // Set associative computed table. Each set holds memo_cache_ways memos ordered by age, the youngest first.
+    // Lookup hits move the memo to the front, inserts into full sets evict the oldest memo.
+    // The table doubles with the number of inserts until its memory budget is exhausted and is lossy afterwards.
     class memo_cache {
         public:
-            memo_cache(bdd_node_cache& _node_cache);
+            constexpr static std::size_t memo_cache_ways = 4;
+
+            memo_cache(bdd_node_cache& _node_cache, const size_t memory_budget = default_memo_cache_budget);
             node* cache_lookup(node* f, node* g, node* h);
             void cache_insert(node* f, node* g, node* h, node* r);
-            memo_struct& get_memo(const size_t slot);
 
             void purge();
+            // drop all memos, for when nodes are freed without being retired first
+            void clear();
+
+            // memory budget in bytes. Shrinking below the current size drops the oldest memos
+            void set_memory_budget(const size_t bytes);
+            size_t memory_budget() const { return memory_budget_; }
+            const memo_cache_statistics& statistics() const { return statistics_; }
+            void reset_statistics();
 
         private:
+            using memo_set = std::array<memo_struct, memo_cache_ways>;
+
             size_t cache_hash(node* f, node* g, node* h);
-            void init_cache();
+            memo_set& get_set(const size_t hash);
             void double_cache();
-            size_t choose_cache_size(const size_t items) const;
-            size_t nr_occupied_slots() const;
-
-            std::vector<memo_struct> memos;
-            size_t memos_mask = 0;
-            size_t cache_inserts = 0; // nr of times we have inserted into cache
-            size_t threshold = 0; // nr of inserts that triggers cache doubling
-
-            struct array_hasher {
-                std::size_t operator()(const std::array<node*, 3>& a) const {
-                    size_t h = 0;
-                    for (auto e : a) {
-                        h ^= std::hash<node*>{}(e)  + 0x9e3779b9 + (h << 6) + (h >> 2); 
-                    }
-                    return h;
-                }   
-            };
-            std::unordered_map<std::array<node*,3>, std::tuple<node*,size_t>, array_hasher> memos2;
+            void resize(const size_t new_nr_sets);
+            size_t max_nr_sets() const;
+            static memo_cache_statistics::operation operation(node* h);
+            void count(size_t& counter);
+
+            std::vector<memo_set> sets;
+            size_t sets_mask = 0;
+            size_t cache_inserts = 0; // nr of inserts since last doubling
+            size_t memory_budget_;
+            memo_cache_statistics statistics_;
             bdd_node_cache& node_cache;
-            size_t insert_time_stamp = 0;
 
+#ifdef LBDD_CONCURRENT
+            // sets are read and written under a striped lock, resizing takes resize_mutex exclusively
+            std::mutex& set_mutex(const size_t hash);
+            std::shared_mutex resize_mutex;
+            std::array<std::mutex, 1024> set_mutexes;
+#endif
     };
 
 }
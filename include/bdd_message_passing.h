@@ -0,0 +1,329 @@
+#pragma once
+
+#include "bdd_collection.h"
+#include "bdd_task_pool.h"
+#include <vector>
+#include <array>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+
+namespace BDD {
+
+    // semirings for message passing. plus combines alternative models, times combines the weights within a model
+    template<typename REAL = double>
+    struct min_sum_semiring {
+        using value_type = REAL;
+        static REAL zero() { return std::numeric_limits<REAL>::infinity(); }
+        static REAL one() { return 0; }
+        static REAL plus(const REAL a, const REAL b) { return std::min(a, b); }
+        static REAL times(const REAL a, const REAL b) { return a + b; }
+    };
+
+    template<typename REAL = double>
+    struct sum_product_semiring {
+        using value_type = REAL;
+        static REAL zero() { return 0; }
+        static REAL one() { return 1; }
+        static REAL plus(const REAL a, const REAL b) { return a + b; }
+        static REAL times(const REAL a, const REAL b) { return a * b; }
+    };
+
+    template<typename REAL = double>
+    struct max_product_semiring {
+        using value_type = REAL;
+        static REAL zero() { return 0; }
+        static REAL one() { return 1; }
+        static REAL plus(const REAL a, const REAL b) { return std::max(a, b); }
+        static REAL times(const REAL a, const REAL b) { return a * b; }
+    };
+
+    // Forward and backward passes over the bdds of a bdd_collection with weights on variable values, templated on the semiring.
+    // The partition of a bdd combines, over all its models, the product of weights of the values taken by its variables:
+    // shortest path cost for min-sum, weighted model count for sum-product and weight of the most probable model for max-product.
+    // Marginals restrict models to one value of a variable: min-marginals, weighted marginal counts and max-marginals.
+    // Only variables of a bdd are modelled. Variables of the bdd skipped by an arc take both values.
+    // Each value holds LANES independent weightings, which are processed together in loops the compiler can vectorize.
+    // Bdds are kept as structure of arrays with 32 bit positions and levels. Passes over many bdds run in parallel on set_nr_threads threads.
+    template<typename SEMIRING, std::size_t LANES = 1>
+    class bdd_message_passing {
+        public:
+            using value_type = typename SEMIRING::value_type;
+            using lanes = std::array<value_type, LANES>;
+            // marginal for value 0 and 1
+            using marginal = std::array<lanes, 2>;
+
+            // BDD_COLLECTION is bdd_collection or mapped_bdd_collection
+            template<typename BDD_COLLECTION>
+                bdd_message_passing(const BDD_COLLECTION& bdds);
+
+            std::size_t nr_bdds() const { return bdds_.size(); }
+            // variables of bdd in increasing order, in which marginals are returned
+            const std::vector<std::size_t>& variables(const std::size_t bdd_nr) const { return bdds_[bdd_nr].variables; }
+            void set_nr_threads(const std::size_t nr_threads);
+
+            // w0[x] and w1[x] are the weights of variable x taking value 0 resp. 1, indexed by variables of the collection
+            lanes partition(const std::size_t bdd_nr, const std::vector<lanes>& w0, const std::vector<lanes>& w1) const;
+            std::vector<marginal> marginals(const std::size_t bdd_nr, const std::vector<lanes>& w0, const std::vector<lanes>& w1) const;
+
+            // for all bdds
+            std::vector<lanes> partitions(const std::vector<lanes>& w0, const std::vector<lanes>& w1) const;
+            std::vector<std::vector<marginal>> marginals(const std::vector<lanes>& w0, const std::vector<lanes>& w1) const;
+
+        private:
+            struct bdd_arrays {
+                std::vector<std::size_t> variables; // of each level
+                std::vector<std::uint32_t> level; // nr of levels for terminals
+                std::vector<std::uint32_t> lo;
+                std::vector<std::uint32_t> hi;
+                // arc 2*i+b leaves node i for value b. Arcs into node c are in_arcs[in_begin[c]],...,in_arcs[in_begin[c+1]-1] by increasing level of their source.
+                // Arcs into the botsink carry no models and are left out.
+                std::vector<std::uint32_t> in_begin;
+                std::vector<std::uint32_t> in_arcs;
+                std::uint32_t topsink;
+                std::uint32_t botsink = std::numeric_limits<std::uint32_t>::max();
+            };
+
+            // weights of levels of one bdd
+            struct level_weights {
+                std::vector<lanes> w0;
+                std::vector<lanes> w1;
+                std::vector<lanes> free; // plus of both values, for skipped levels
+            };
+
+            static lanes constant(const value_type x) { lanes r; r.fill(x); return r; }
+            static lanes plus(const lanes& a, const lanes& b) { lanes r; for(std::size_t l=0; l<LANES; ++l) r[l] = SEMIRING::plus(a[l], b[l]); return r; }
+            static lanes times(const lanes& a, const lanes& b) { lanes r; for(std::size_t l=0; l<LANES; ++l) r[l] = SEMIRING::times(a[l], b[l]); return r; }
+
+            level_weights gather_weights(const bdd_arrays& bdd, const std::vector<lanes>& w0, const std::vector<lanes>& w1) const;
+            std::vector<lanes> backward(const bdd_arrays& bdd, const level_weights& w) const;
+
+            template<typename F>
+                void parallel_for(const std::size_t begin, const std::size_t end, F&& f) const;
+
+            std::vector<bdd_arrays> bdds_;
+            std::unique_ptr<bdd_task_pool> task_pool_;
+    };
+
+    template<typename SEMIRING, std::size_t LANES>
+    template<typename BDD_COLLECTION>
+        bdd_message_passing<SEMIRING, LANES>::bdd_message_passing(const BDD_COLLECTION& bdds)
+        {
+            bdds_.reserve(bdds.nr_bdds());
+            for(std::size_t bdd_nr=0; bdd_nr<bdds.nr_bdds(); ++bdd_nr)
+            {
+                bdd_arrays a;
+                a.variables = bdds.variables(bdd_nr);
+                const auto [instr_begin, instr_end] = bdds.get_bdd_instructions(bdd_nr);
+                const std::size_t nr_nodes = std::distance(instr_begin, instr_end);
+                assert(nr_nodes < std::numeric_limits<std::uint32_t>::max());
+                const std::size_t offset = bdds.offset(*instr_begin);
+                a.level.reserve(nr_nodes);
+                a.lo.reserve(nr_nodes);
+                a.hi.reserve(nr_nodes);
+                for(auto it=instr_begin; it!=instr_end; ++it)
+                {
+                    const std::uint32_t i = std::distance(instr_begin, it);
+                    if(it->is_terminal())
+                    {
+                        if(it->is_topsink())
+                            a.topsink = i;
+                        else
+                            a.botsink = i;
+                        a.level.push_back(a.variables.size());
+                        a.lo.push_back(i);
+                        a.hi.push_back(i);
+                        continue;
+                    }
+                    a.level.push_back(std::lower_bound(a.variables.begin(), a.variables.end(), it->index) - a.variables.begin());
+                    a.lo.push_back(it->lo - offset);
+                    a.hi.push_back(it->hi - offset);
+                    assert(a.lo.back() > i && a.hi.back() > i);
+                }
+                assert(a.level[0] == 0);
+
+                // incoming arcs, sources are visited by increasing level
+                std::vector<std::uint32_t> sources;
+                sources.reserve(nr_nodes);
+                for(std::uint32_t i=0; i<nr_nodes; ++i)
+                    if(i != a.topsink && i != a.botsink)
+                        sources.push_back(i);
+                std::stable_sort(sources.begin(), sources.end(), [&](const std::uint32_t i, const std::uint32_t j) { return a.level[i] < a.level[j]; });
+                a.in_begin.assign(nr_nodes+1, 0);
+                for(const std::uint32_t i : sources)
+                    for(const std::uint32_t c : {a.lo[i], a.hi[i]})
+                        if(c != a.botsink)
+                            ++a.in_begin[c+1];
+                for(std::size_t i=0; i<nr_nodes; ++i)
+                    a.in_begin[i+1] += a.in_begin[i];
+                a.in_arcs.resize(a.in_begin.back());
+                std::vector<std::uint32_t> next(a.in_begin.begin(), a.in_begin.end()-1);
+                for(const std::uint32_t i : sources)
+                    for(std::uint32_t b=0; b<2; ++b)
+                    {
+                        const std::uint32_t c = b == 0 ? a.lo[i] : a.hi[i];
+                        if(c != a.botsink)
+                            a.in_arcs[next[c]++] = 2*i + b;
+                    }
+                bdds_.push_back(std::move(a));
+            }
+        }
+
+    template<typename SEMIRING, std::size_t LANES>
+        void bdd_message_passing<SEMIRING, LANES>::set_nr_threads(const std::size_t nr_threads)
+        {
+            if(nr_threads <= 1)
+                task_pool_.reset();
+            else
+                task_pool_ = std::make_unique<bdd_task_pool>(nr_threads);
+        }
+
+    template<typename SEMIRING, std::size_t LANES>
+        typename bdd_message_passing<SEMIRING, LANES>::level_weights bdd_message_passing<SEMIRING, LANES>::gather_weights(const bdd_arrays& bdd, const std::vector<lanes>& w0, const std::vector<lanes>& w1) const
+        {
+            level_weights w;
+            w.w0.reserve(bdd.variables.size());
+            w.w1.reserve(bdd.variables.size());
+            w.free.reserve(bdd.variables.size());
+            for(const std::size_t x : bdd.variables)
+            {
+                assert(x < w0.size() && x < w1.size());
+                w.w0.push_back(w0[x]);
+                w.w1.push_back(w1[x]);
+                w.free.push_back(plus(w0[x], w1[x]));
+            }
+            return w;
+        }
+
+    // Combined weight of the partial models from each node to the topsink, by one reverse sweep.
+    // Once a node is done, the weights behind its incoming arcs are computed from their highest source level upwards, so each level skipped into the node is multiplied in once and not once per arc.
+    template<typename SEMIRING, std::size_t LANES>
+        std::vector<typename bdd_message_passing<SEMIRING, LANES>::lanes> bdd_message_passing<SEMIRING, LANES>::backward(const bdd_arrays& bdd, const level_weights& w) const
+        {
+            std::vector<lanes> up(bdd.level.size(), constant(SEMIRING::zero()));
+            std::vector<lanes> arc_up(2*bdd.level.size(), constant(SEMIRING::zero())); // weight from the source level of an arc on, zero for arcs into the botsink
+            for(std::ptrdiff_t c=bdd.level.size()-1; c>=0; --c)
+            {
+                if(std::uint32_t(c) == bdd.botsink)
+                    continue;
+                if(std::uint32_t(c) == bdd.topsink)
+                    up[c] = constant(SEMIRING::one());
+                else
+                {
+                    const std::size_t l = bdd.level[c];
+                    up[c] = plus(times(w.w0[l], arc_up[2*c]), times(w.w1[l], arc_up[2*c+1]));
+                }
+
+                lanes u = up[c];
+                std::size_t s = bdd.level[c];
+                for(std::size_t k=bdd.in_begin[c+1]; k-- > bdd.in_begin[c];)
+                {
+                    const std::uint32_t arc = bdd.in_arcs[k];
+                    for(const std::size_t first_skipped = bdd.level[arc/2] + 1; s > first_skipped;)
+                        u = times(w.free[--s], u);
+                    arc_up[arc] = u;
+                }
+            }
+            return up;
+        }
+
+    template<typename SEMIRING, std::size_t LANES>
+        typename bdd_message_passing<SEMIRING, LANES>::lanes bdd_message_passing<SEMIRING, LANES>::partition(const std::size_t bdd_nr, const std::vector<lanes>& w0, const std::vector<lanes>& w1) const
+        {
+            assert(bdd_nr < nr_bdds());
+            const bdd_arrays& bdd = bdds_[bdd_nr];
+            return backward(bdd, gather_weights(bdd, w0, w1))[0];
+        }
+
+    // A forward sweep combines the weights of partial models from the root into each node. Marginals of a level combine forward weight, arc and backward weight of all arcs leaving or skipping it.
+    // Arcs into the same node are combined level by level from their lowest source level on, so the levels skipped into a node are visited once for all of its arcs.
+    template<typename SEMIRING, std::size_t LANES>
+        std::vector<typename bdd_message_passing<SEMIRING, LANES>::marginal> bdd_message_passing<SEMIRING, LANES>::marginals(const std::size_t bdd_nr, const std::vector<lanes>& w0, const std::vector<lanes>& w1) const
+        {
+            assert(bdd_nr < nr_bdds());
+            const bdd_arrays& bdd = bdds_[bdd_nr];
+            const level_weights w = gather_weights(bdd, w0, w1);
+            const std::vector<lanes> up = backward(bdd, w);
+            std::vector<lanes> down(bdd.level.size(), constant(SEMIRING::zero()));
+            std::vector<marginal> m(bdd.variables.size(), {constant(SEMIRING::zero()), constant(SEMIRING::zero())});
+            down[0] = constant(SEMIRING::one());
+
+            std::vector<lanes> skipped_up; // weight from each level skipped into the current node on, starting at its lowest source level + 1
+            for(std::size_t c=1; c<bdd.level.size(); ++c)
+            {
+                const std::size_t arcs_begin = bdd.in_begin[c];
+                const std::size_t arcs_end = bdd.in_begin[c+1];
+                if(arcs_begin == arcs_end)
+                    continue;
+                const std::size_t first = bdd.level[bdd.in_arcs[arcs_begin]/2] + 1;
+                const std::size_t last = bdd.level[c];
+                skipped_up.resize(last - first + 1);
+                skipped_up[last - first] = up[c];
+                for(std::size_t s=last; s-- > first;)
+                    skipped_up[s - first] = times(w.free[s], skipped_up[s - first + 1]);
+
+                // weight of partial models entering level s on arcs into c, skipped levels take both values
+                lanes into = constant(SEMIRING::zero());
+                std::size_t s = first;
+                auto skip_to = [&](const std::size_t level) {
+                    for(; s<level; ++s)
+                    {
+                        m[s][0] = plus(m[s][0], times(into, times(w.w0[s], skipped_up[s - first + 1])));
+                        m[s][1] = plus(m[s][1], times(into, times(w.w1[s], skipped_up[s - first + 1])));
+                        into = times(into, w.free[s]);
+                    }
+                };
+                for(std::size_t k=arcs_begin; k<arcs_end; ++k)
+                {
+                    const std::uint32_t i = bdd.in_arcs[k]/2;
+                    const std::uint32_t b = bdd.in_arcs[k]%2;
+                    const std::size_t l = bdd.level[i];
+                    skip_to(l+1);
+                    const lanes into_arc = times(down[i], b == 0 ? w.w0[l] : w.w1[l]);
+                    m[l][b] = plus(m[l][b], times(into_arc, skipped_up[l + 1 - first]));
+                    into = plus(into, into_arc);
+                }
+                skip_to(last);
+                down[c] = into;
+            }
+            return m;
+        }
+
+    // run f(i) for i in [begin,end), splitting the range recursively among the threads of the pool
+    template<typename SEMIRING, std::size_t LANES>
+        template<typename F>
+        void bdd_message_passing<SEMIRING, LANES>::parallel_for(const std::size_t begin, const std::size_t end, F&& f) const
+        {
+            // ranges are split until each thread gets about eight of them
+            const std::size_t grain = task_pool_ == nullptr ? 0 : std::max(std::size_t(1), nr_bdds() / (8 * task_pool_->nr_threads()));
+            if(task_pool_ == nullptr || end - begin <= grain)
+            {
+                for(std::size_t i=begin; i<end; ++i)
+                    f(i);
+                return;
+            }
+            const std::size_t middle = begin + (end - begin)/2;
+            task_pool_->fork_join(
+                    [&]() { parallel_for(begin, middle, f); },
+                    [&]() { parallel_for(middle, end, f); });
+        }
+
+    template<typename SEMIRING, std::size_t LANES>
+        std::vector<typename bdd_message_passing<SEMIRING, LANES>::lanes> bdd_message_passing<SEMIRING, LANES>::partitions(const std::vector<lanes>& w0, const std::vector<lanes>& w1) const
+        {
+            std::vector<lanes> p(nr_bdds());
+            parallel_for(0, nr_bdds(), [&](const std::size_t bdd_nr) { p[bdd_nr] = partition(bdd_nr, w0, w1); });
+            return p;
+        }
+
+    template<typename SEMIRING, std::size_t LANES>
+        std::vector<std::vector<typename bdd_message_passing<SEMIRING, LANES>::marginal>> bdd_message_passing<SEMIRING, LANES>::marginals(const std::vector<lanes>& w0, const std::vector<lanes>& w1) const
+        {
+            std::vector<std::vector<marginal>> m(nr_bdds());
+            parallel_for(0, nr_bdds(), [&](const std::size_t bdd_nr) { m[bdd_nr] = marginals(bdd_nr, w0, w1); });
+            return m;
+        }
+
+}
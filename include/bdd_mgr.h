@@ -4,15 +4,28 @@
 #include "bdd_node_cache.h"
 #include "bdd_var.h"
 #include "bdd_memo_cache.h"
+#include "bdd_operators.h"
+#ifdef LBDD_CONCURRENT
+#include "bdd_task_pool.h"
+#endif
 #include <vector>
+#include <memory>
 #include <unordered_map>
 #include <tuple>
 #include <algorithm>
+#include <numeric>
+#include <cstdint>
 #include <cassert>
+#include <atomic>
 
 namespace BDD {
 
+    // operations whose operands have combined depth above this bound use the non-recursive versions, so as not to exceed the stack
+    // node depths saturate at max_node_depth, hence the bound must lie below it
+    constexpr static std::size_t max_recursion_depth = std::min(std::size_t(16384), max_node_depth-1);
+
     class bdd_collection; // forward declaration for enabling import from bdds
+    struct bdd_instruction;
 
     class bdd_mgr {
         public:
@@ -21,12 +34,15 @@ namespace BDD {
             size_t add_variable();
             size_t nr_variables() const { return vars.size(); }
             size_t nr_nodes() const { return node_cache_.nr_nodes(); }
+            size_t peak_nr_nodes() const { return node_cache_.peak_nr_nodes(); }
+            size_t nr_nodes_created() const { return node_cache_.nr_nodes_created(); }
             node_ref projection(const size_t var);
             node_ref neg_projection(const size_t var);
             node_ref negate(node_ref p);
             node_ref topsink() const { return node_ref(node_cache_.topsink()); }
             node_ref botsink() const { return node_ref(node_cache_.botsink()); }
 
+            // node of variable var, lo and hi must lie on deeper levels, see variable order below
             node_ref unique_find(const size_t var, node_ref lo, node_ref hi);
 
             template<class... NODES>
@@ -49,11 +65,38 @@ namespace BDD {
                 node_ref xor_rec(ITERATOR nodes_begin, ITERATOR nodes_end);
             node_ref xor_rec(node_ref f, node_ref g);
 
+            node_ref nand_rec(node_ref f, node_ref g);
+            // f implies g
+            node_ref implies_rec(node_ref f, node_ref g);
+            // f and not g
+            node_ref diff_rec(node_ref f, node_ref g);
+            node_ref equiv_rec(node_ref f, node_ref g);
+            // f op g for a binary_operator of bdd_operators.h, the binary operations above are instances of it.
+            // Terminal cases follow from the truth table at compile time, operands of commutative operators are ordered for the memo cache.
+            template<typename OP>
+                node_ref apply(node_ref f, node_ref g);
+
             // f is if-condition, g is for 1-outcome, h is for lo outcome
             node_ref ite_rec(node_ref f, node_ref g, node_ref h);
-            //node_ref ite_non_rec(node_ref f, node_ref g, node_ref h, std::stack<>& stack);
 
-            // make a copy of bdd rooted at node to variables given
+            // conjunction of the projections of the given variables, a variable set for quantification
+            template<typename ITERATOR>
+                node_ref cube(ITERATOR var_begin, ITERATOR var_end);
+            // quantify the variables of cube, a conjunction of projections
+            node_ref exists(node_ref f, node_ref cube);
+            node_ref forall(node_ref f, node_ref cube);
+            // relational product exists(and_rec(f,g), cube), without constructing and_rec(f,g)
+            node_ref and_exists(node_ref f, node_ref g, node_ref cube);
+
+            // versions of the above operating on an explicit heap-allocated stack instead of recursion, for very deep bdds.
+            // The recursive versions dispatch to these automatically given the depth of their operands.
+            node_ref and_non_rec(node_ref f, node_ref g);
+            node_ref or_non_rec(node_ref f, node_ref g);
+            node_ref xor_non_rec(node_ref f, node_ref g);
+            node_ref ite_non_rec(node_ref f, node_ref g, node_ref h);
+
+            // make a copy of bdd rooted at node to variables given, maps may reverse or merge levels
+            // Nodes whose children stay on deeper levels are copied by one unique table lookup, for order preserving maps this is all of them. The others are composed by ite.
             // assume variable map is given by hash
             template<typename VAR_MAP>
             node_ref rebase(node_ref p, const VAR_MAP& var_map);
@@ -67,7 +110,53 @@ namespace BDD {
 
             void collect_garbage();
 
+            // Automatic incremental garbage collection. A collection cycle starts when there are dead nodes and the number of nodes has grown by the factor 1 + growth since the end of the last cycle.
+            // Only roots of dead subgraphs are counted as dead, nodes below them are referenced until their parents are reclaimed. Variables are swept in order, so a cycle reclaims whole dead subgraphs.
+            // A cycle sweeps the unique tables of vars_per_step variables per step, steps are taken periodically while nodes are created.
+            // Reclaimed nodes are reused after the cycle has swept all variables and purged the memo cache.
+            // Not available in concurrent mode, where garbage must be collected explicitly.
+#ifndef LBDD_CONCURRENT
+            void set_garbage_collection_policy(const double growth, const size_t vars_per_step);
+            void set_automatic_garbage_collection(const bool enable) { automatic_gc_ = enable; }
+            size_t nr_dead_nodes() { return node_cache_.nr_dead_nodes(); }
+#endif
+            // called by the unique tables
+            bool garbage_collection_due();
+            void garbage_collection_step();
+
+            // Variable order. Nodes are kept by the level of their variable, but all interfaces take and return variables: node_ref::variable, variables, evaluate and model_count, bdd_collection import and export, projection, cube and rebase.
+            // Variables and levels coincide until variables are reordered, variables added later are placed at the bottom.
+            size_t level(const size_t var) const { assert(var < nr_variables()); return levels_[var]; }
+            size_t variable(const size_t l) const { assert(l < nr_variables()); return variables_[l]; }
+            bool variables_reordered() const { return nr_moved_variables_ > 0; }
+            // Rudell's sifting: each variable in turn, the one with most nodes first, is moved through all levels by swaps of adjacent levels and left where the number of nodes is smallest.
+            // Moving in one direction stops when the number of nodes exceeds max_growth times the smallest one found.
+            // Collects garbage and drops all memos. Must not run concurrently to other operations on the manager.
+            void reorder();
+            // Automatic reordering runs at the start of operations on node_refs once the number of nodes reaches threshold. Afterwards the threshold is at least twice the number of nodes left by the last reordering.
+            // Off by default and not available in concurrent mode.
+            void set_reordering_policy(const size_t threshold, const double max_growth);
+#ifndef LBDD_CONCURRENT
+            void set_automatic_reordering(const bool enable) { automatic_reordering_ = enable; }
+#endif
+            size_t nr_reorderings() const { return nr_reorderings_; }
+
+            // computed table: memory budget in bytes and per-operation hit/miss/insert/eviction counters
+            void set_memo_cache_budget(const size_t bytes) { memo_.set_memory_budget(bytes); }
+            size_t memo_cache_budget() const { return memo_.memory_budget(); }
+            const memo_cache_statistics& memo_statistics() const { return memo_.statistics(); }
+            void reset_memo_statistics() { memo_.reset_statistics(); }
+
+#ifdef LBDD_CONCURRENT
+            // run synthesis on given number of threads. Halves of n-ary operations and cofactors of operands with combined depth at least the parallel cutoff are computed in parallel, as long as fewer than the parallel levels of forks enclose them.
+            // Bounding the fork nesting keeps the number of tasks per operation below 2^levels, by default log2(nr_threads) + 4 levels give at least 16 tasks per thread.
+            void set_nr_threads(const size_t nr_threads);
+            void set_parallel_cutoff(const size_t depth) { parallel_cutoff_ = depth; }
+            void set_parallel_levels(const size_t levels) { parallel_levels_ = levels; }
+#endif
+
             // utility functions for computing common functions
+            // If all operands are literals of distinct variables, the counting constraints are built directly level by level with O(n*b) unique table lookups, otherwise by apply operations.
             template<typename BDD_ITERATOR>
                 node_ref all_false(BDD_ITERATOR begin, BDD_ITERATOR end);
             template<typename BDD_ITERATOR>
@@ -83,19 +172,167 @@ namespace BDD {
                 node_ref at_most(BDD_ITERATOR begin, BDD_ITERATOR end, const size_t b);
             template<typename BDD_ITERATOR>
                 node_ref cardinality(BDD_ITERATOR begin, BDD_ITERATOR end, const size_t b);
+            // linear pseudo-Boolean constraints sum_i coefficients_i * f_i <= bound resp. == bound, coefficients may be negative.
+            // Remainders of the bound leading to the same node are merged into intervals per level, so no node is built twice. Operands that are literals of distinct variables are placed by one unique table lookup per node, others are composed by ite.
+            template<typename BDD_ITERATOR, typename COEFFICIENT_ITERATOR>
+                node_ref linear_at_most(BDD_ITERATOR begin, BDD_ITERATOR end, COEFFICIENT_ITERATOR coefficient_begin, const std::int64_t bound);
+            template<typename BDD_ITERATOR, typename COEFFICIENT_ITERATOR>
+                node_ref linear_equal(BDD_ITERATOR begin, BDD_ITERATOR end, COEFFICIENT_ITERATOR coefficient_begin, const std::int64_t bound);
 
             node_ref transform_to_base();
             node_ref add_bdd(bdd_collection& bdd_col, const size_t bdd_nr);
+            // import the instructions [begin,end) of one bdd, arcs are positions in instructions and indices are variables.
+            // Nodes are built bottom-up by one unique table lookup each, only nodes whose children do not lie on deeper levels need ite.
+            node_ref add_bdd(const bdd_instruction* instructions, const size_t begin, const size_t end);
 
         private:
+            friend class node_struct;
+            // variable at each level for translating node indices, nullptr while they coincide
+            const size_t* level_variables() const { return nr_moved_variables_ == 0 ? nullptr : variables_.data(); }
+            // as unique_find, but given the level of the node
+            node_ref level_find(const size_t l, node_ref lo, node_ref hi);
+
+            // frames of binary operations carry the truth table of their operator, h is its memo symbol
+            constexpr static unsigned char ite_op = 16;
+            node* apply_non_rec(const unsigned char op, node* f, node* g, node* h);
+            // result of a binary operation with one operand fixed, given its values for p false and p true
+            node_ref apply_unary(const bool on_false, const bool on_true, node_ref p);
+
+            // Algorithms holding unreferenced intermediate nodes suspend automatic garbage collection while running
+            struct gc_suspension {
+                gc_suspension(bdd_mgr& mgr) : mgr_(mgr) { ++mgr_.gc_suspended_; }
+                ~gc_suspension() { --mgr_.gc_suspended_; }
+                bdd_mgr& mgr_;
+            };
+            void finish_garbage_collection_cycle();
+
+            // Operations on node_refs may reorder variables when they start, but not when called from within another operation, whose nodes and levels would change underneath it.
+            // Operations interpreting levels given by the caller do not reorder at all.
+            struct operation_scope {
+#ifdef LBDD_CONCURRENT
+                operation_scope(bdd_mgr&, const bool = true) {}
+#else
+                operation_scope(bdd_mgr& mgr, const bool may_reorder = true)
+                    : mgr_(mgr), counted_(mgr.automatic_reordering_)
+                {
+                    if(counted_ && mgr_.operation_depth_++ == 0 && may_reorder && mgr_.reordering_due())
+                        mgr_.reorder();
+                }
+                ~operation_scope() { if(counted_) --mgr_.operation_depth_; }
+                bdd_mgr& mgr_;
+                const bool counted_; // nesting is only tracked while automatic reordering is enabled
+#endif
+            };
+            bool reordering_due() const;
+            // exchange the variables at levels l and l+1 in place. Nodes keep their functions, so node_refs stay valid, but freed nodes may still be referenced by memos.
+            void swap_levels(const size_t l);
+            void sift(const size_t var);
+            // operands given by their level and whether they are positive, if all are literals of distinct variables
+            template<typename BDD_ITERATOR>
+                bool literals(BDD_ITERATOR begin, BDD_ITERATOR end, std::vector<std::pair<size_t,bool>>& lits) const;
+            // true iff the number of true literals lies in [lower,upper]. Built bottom-up, the nodes of each level correspond to the number of true literals above
+            node_ref count_literals(std::vector<std::pair<size_t,bool>>& lits, const size_t lower, const size_t upper);
+            template<typename BDD_ITERATOR, typename COEFFICIENT_ITERATOR>
+                node_ref linear_constraint(BDD_ITERATOR begin, BDD_ITERATOR end, COEFFICIENT_ITERATOR coefficient_begin, std::int64_t bound, const bool equality);
+            // operands with positive coefficients, sorted by level if they are literals
+            node_ref linear_constraint(const std::vector<node_ref>& operands, const std::vector<std::int64_t>& coefficients, const std::int64_t bound, const bool equality, const bool literals);
+            // var_map gives the new variable of each variable
+            node_ref rebase_variables(node_ref p, const std::vector<size_t>& var_map);
+            // rebase of the flat copy bdd_nr in instructions of a bdd with the given variables, ordered by level, for maps that are injective on them but do not keep their order
+            node_ref permute_variables(bdd_collection& instructions, const size_t bdd_nr, const std::vector<size_t>& support, const std::vector<size_t>& var_map);
+
+            // run f0 and f1, in parallel if a task pool is present and size is at least the parallel cutoff
+            template<typename F0, typename F1>
+                void fork_join(const size_t size, F0&& f0, F1&& f1);
 
             bdd_node_cache node_cache_;
             unique_table_page_caches page_cache_;
             memo_cache memo_;
             std::vector<var_struct> vars; // vars must be after node cache und page cache for correct destructor calling order
 
+            // automatic garbage collection state
+            constexpr static size_t gc_min_nodes = 65536; // collection cycles are not started for fewer nodes
+#ifdef LBDD_CONCURRENT
+            bool automatic_gc_ = false;
+#else
+            bool automatic_gc_ = true;
+#endif
+            double gc_growth_ = 1.0;
+            size_t gc_nodes_after_cycle_ = 0;
+            size_t gc_vars_per_step_ = 64;
+            bool gc_cycle_active_ = false;
+            size_t gc_cursor_ = 0; // next variable to sweep in active cycle
+            size_t gc_suspended_ = 0;
+#ifdef LBDD_CONCURRENT
+            std::unique_ptr<bdd_task_pool> task_pool_;
+            size_t parallel_cutoff_ = 24;
+            size_t parallel_levels_ = 0;
+#endif
+
+            // variable order state, the variable at each level is also kept in its var_struct
+            std::vector<size_t> levels_;
+            std::vector<size_t> variables_;
+            size_t nr_moved_variables_ = 0; // variables not at the level of their number
+            // managers of the process with nr_moved_variables_ > 0. While there are none, node_struct::level_variables need not look up the manager of a node
+            static std::atomic<size_t> nr_reordered_mgrs_;
+            bool automatic_reordering_ = false;
+            size_t reordering_threshold_ = 1 << 20;
+            double reordering_max_growth_ = 1.2;
+            size_t nr_reorderings_ = 0;
+            size_t operation_depth_ = 0;
+            std::vector<node*> swap_upper_, swap_lower_; // nodes of the two levels being swapped
+
     }; 
 
+    template<typename F0, typename F1>
+        void bdd_mgr::fork_join([[maybe_unused]] const size_t size, F0&& f0, F1&& f1)
+        {
+#ifdef LBDD_CONCURRENT
+            if(task_pool_ != nullptr && size >= parallel_cutoff_ && bdd_task_pool::nesting() < parallel_levels_)
+                return task_pool_->fork_join(f0, f1);
+#endif
+            f0();
+            f1();
+        }
+
+    template<typename OP>
+        node_ref bdd_mgr::apply(node_ref f, node_ref g)
+        {
+            operation_scope scope(*this);
+            if(f.depth() + g.depth() > max_recursion_depth)
+                return node_ref(apply_non_rec(OP::table, f.ref, g.ref, memo_struct::symbol(OP::operation)));
+
+            if(f == g)
+                return apply_unary(OP::value(false, false), OP::value(true, true), f);
+            if constexpr(OP::commutative)
+            {
+                if(f.ref > g.ref)
+                    std::swap(f, g);
+            }
+            if(f.is_terminal())
+                return apply_unary(OP::value(f.is_topsink(), false), OP::value(f.is_topsink(), true), g);
+            if(g.is_terminal())
+                return apply_unary(OP::value(false, g.is_topsink()), OP::value(true, g.is_topsink()), f);
+
+            node* const symbol = memo_struct::symbol(OP::operation);
+            node* m = memo_.cache_lookup(f.ref, g.ref, symbol);
+            if(m != nullptr)
+                return node_ref(m);
+
+            const size_t v = std::min(f.level(), g.level());
+            node_ref r0, r1;
+            fork_join(f.depth() + g.depth(),
+                    [&]() { r0 = apply<OP>(f.level() == v ? f.low() : f, g.level() == v ? g.low() : g); },
+                    [&]() { r1 = apply<OP>(f.level() == v ? f.high() : f, g.level() == v ? g.high() : g); });
+            assert(r0.ref != nullptr);
+            assert(r1.ref != nullptr);
+
+            node* r = vars[v].unique_find(r0.ref, r1.ref);
+            assert(r != nullptr);
+            memo_.cache_insert(f.ref, g.ref, symbol, r);
+            return node_ref(r);
+        }
+
     template<typename VAR_MAP>
     node_ref bdd_mgr::rebase(node_ref p, const VAR_MAP& var_map)
     {
@@ -105,52 +342,46 @@ namespace BDD {
         for(size_t i=nr_variables(); i<=last_var; ++i)
             add_variable();
 
-        // copy nodes one by one in postordering
-        const auto postorder = p.address()->nodes_postorder();
-        std::unordered_map<node*, node*> node_map;
-        node_map.insert({node_cache_.botsink(), node_cache_.botsink()});
-        node_map.insert({node_cache_.topsink(), node_cache_.topsink()});
-        for(node* p : postorder) {
-            const size_t v_orig = p->index;
-            assert(var_map.count(v_orig) > 0);
-            const size_t v_new = var_map.find(v_orig)->second;
-
-            assert(node_map.count(p->lo) > 0);
-            assert(node_map.count(p->hi) > 0);
-            node* lo_mapped = node_map.find(p->lo)->second;
-            node* hi_mapped = node_map.find(p->hi)->second;
-            node_map.insert({p, vars[v_new].unique_find(lo_mapped, hi_mapped)});
+        std::vector<size_t> var_map_vector(nr_variables());
+        std::iota(var_map_vector.begin(), var_map_vector.end(), 0);
+        for(const auto [x,y] : var_map)
+        {
+            if(x >= var_map_vector.size())
+                continue; // not occurring in any bdd
+            var_map_vector[x] = y;
         }
-
-        return node_ref(node_map.find(p.address())->second);
+        return rebase_variables(p, var_map_vector);
     }
 
     template<typename ITERATOR>
     node_ref bdd_mgr::rebase(node_ref p, ITERATOR var_map_begin, ITERATOR var_map_end)
     {
         const size_t nr_vars = std::distance(var_map_begin, var_map_end);
-        assert(p.variables().back() <= nr_vars);
+        assert(p.is_terminal() || p.variables().back() <= nr_vars);
         const size_t last_var = *std::max_element(var_map_begin, var_map_end);
         for(size_t i=nr_variables(); i<=last_var; ++i)
             add_variable();
 
-        const auto postorder = p.address()->nodes_postorder();
-        std::unordered_map<node*, node*> node_map;
-        node_map.insert({node_cache_.botsink(), node_cache_.botsink()});
-        node_map.insert({node_cache_.topsink(), node_cache_.topsink()});
-        for(node* p : postorder) {
-            const size_t v_orig = p->index;
-            assert(v_orig < nr_vars);
-            const size_t v_new = *(var_map_begin + v_orig);
-
-            assert(node_map.count(p->lo) > 0);
-            assert(node_map.count(p->hi) > 0);
-            node* lo_mapped = node_map.find(p->lo)->second;
-            node* hi_mapped = node_map.find(p->hi)->second;
-            node_map.insert({p, vars[v_new].unique_find(lo_mapped, hi_mapped)});
-        }
+        return rebase_variables(p, std::vector<size_t>(var_map_begin, var_map_end));
+    }
 
-        return node_ref(node_map.find(p.address())->second);
+    template<typename ITERATOR>
+    node_ref bdd_mgr::cube(ITERATOR var_begin, ITERATOR var_end)
+    {
+        std::vector<size_t> cube_vars(var_begin, var_end);
+        if(cube_vars.size() > 0)
+            for(size_t i=nr_variables(); i<=*std::max_element(cube_vars.begin(), cube_vars.end()); ++i)
+                add_variable();
+        for(size_t& v : cube_vars)
+            v = level(v);
+        std::sort(cube_vars.begin(), cube_vars.end());
+        cube_vars.erase(std::unique(cube_vars.begin(), cube_vars.end()), cube_vars.end());
+
+        // build bottom-up from the last level
+        node_ref c = topsink();
+        for(auto it=cube_vars.rbegin(); it!=cube_vars.rend(); ++it)
+            c = level_find(*it, botsink(), c);
+        return c;
     }
 
     //remplate<class... NODES, class = std::conjunction<std::is_same<node*, NODES>...>
@@ -171,8 +402,10 @@ namespace BDD {
             else if(n == 3)
                 return and_rec(*nodes_begin, and_rec(*(nodes_begin+1), *(nodes_begin+2))); 
 
-            node_ref a1(and_rec(nodes_begin, nodes_begin+n/2));
-            node_ref a2(and_rec(nodes_begin+n/2, nodes_end));
+            node_ref a1, a2;
+            fork_join(std::numeric_limits<size_t>::max(),
+                    [&]() { a1 = and_rec(nodes_begin, nodes_begin+n/2); },
+                    [&]() { a2 = and_rec(nodes_begin+n/2, nodes_end); });
             return and_rec(a1, a2);
         }
 
@@ -192,8 +425,10 @@ namespace BDD {
             else if(n == 3)
                 return or_rec(*nodes_begin, or_rec(*(nodes_begin+1), *(nodes_begin+2))); 
 
-            node_ref o1(or_rec(nodes_begin, nodes_begin+n/2));
-            node_ref o2(or_rec(nodes_begin+n/2, nodes_end));
+            node_ref o1, o2;
+            fork_join(std::numeric_limits<size_t>::max(),
+                    [&]() { o1 = or_rec(nodes_begin, nodes_begin+n/2); },
+                    [&]() { o2 = or_rec(nodes_begin+n/2, nodes_end); });
             return or_rec(o1, o2);
         }
 
@@ -213,8 +448,10 @@ namespace BDD {
             else if(n == 3)
                 return xor_rec(*nodes_begin, xor_rec(*(nodes_begin+1), *(nodes_begin+2))); 
 
-            node_ref o1(xor_rec(nodes_begin, nodes_begin+n/2));
-            node_ref o2(xor_rec(nodes_begin+n/2, nodes_end));
+            node_ref o1, o2;
+            fork_join(std::numeric_limits<size_t>::max(),
+                    [&]() { o1 = xor_rec(nodes_begin, nodes_begin+n/2); },
+                    [&]() { o2 = xor_rec(nodes_begin+n/2, nodes_end); });
             return xor_rec(o1, o2);
         } 
 
@@ -244,9 +481,31 @@ namespace BDD {
         return mgr->negate(a);
     }
 
+    template<typename BDD_ITERATOR>
+        bool bdd_mgr::literals(BDD_ITERATOR begin, BDD_ITERATOR end, std::vector<std::pair<size_t,bool>>& lits) const
+        {
+            lits.clear();
+            for(auto it=begin; it!=end; ++it)
+            {
+                const node* f = it->address();
+                if(f->is_terminal())
+                    return false;
+                const node* lo = f->lo;
+                const node* hi = f->hi;
+                if(!lo->is_terminal() || !hi->is_terminal())
+                    return false;
+                lits.push_back({f->index, hi->is_topsink()});
+            }
+            std::sort(lits.begin(), lits.end());
+            return std::adjacent_find(lits.begin(), lits.end(), [](const auto& a, const auto& b) { return a.first == b.first; }) == lits.end();
+        }
+
     template<typename BDD_ITERATOR>
         node_ref bdd_mgr::all_false(BDD_ITERATOR begin, BDD_ITERATOR end)
         {
+            std::vector<std::pair<size_t,bool>> lits;
+            if(literals(begin, end, lits))
+                return count_literals(lits, 0, 0);
             const size_t n = std::distance(begin, end);
             assert(n > 0);
             if(n == 1)
@@ -262,6 +521,9 @@ namespace BDD {
     template<typename BDD_ITERATOR>
         node_ref bdd_mgr::simplex(BDD_ITERATOR begin, BDD_ITERATOR end)
         {
+            std::vector<std::pair<size_t,bool>> lits;
+            if(literals(begin, end, lits))
+                return count_literals(lits, 1, 1);
             assert(std::distance(begin, end) > 0);
             if(std::distance(begin,end) == 1)
                 return *begin;
@@ -278,6 +540,9 @@ namespace BDD {
     template<typename BDD_ITERATOR>
         node_ref bdd_mgr::at_most_one(BDD_ITERATOR begin, BDD_ITERATOR end)
         {
+            std::vector<std::pair<size_t,bool>> lits;
+            if(literals(begin, end, lits))
+                return count_literals(lits, 0, 1);
             assert(std::distance(begin, end) > 0);
             const size_t n = std::distance(begin, end);
             if(n == 1)
@@ -304,12 +569,18 @@ namespace BDD {
     template<typename BDD_ITERATOR>
         node_ref bdd_mgr::at_least_one(BDD_ITERATOR begin, BDD_ITERATOR end)
         {
+            std::vector<std::pair<size_t,bool>> lits;
+            if(literals(begin, end, lits))
+                return count_literals(lits, 1, lits.size());
             return negate(all_false(begin, end));
         }
 
     template<typename BDD_ITERATOR>
         node_ref bdd_mgr::at_least(BDD_ITERATOR begin, BDD_ITERATOR end, const size_t b)
         {
+            std::vector<std::pair<size_t,bool>> lits;
+            if(literals(begin, end, lits))
+                return count_literals(lits, b, lits.size());
             assert(std::distance(begin, end) > 0);
             const size_t n = std::distance(begin, end);
 
@@ -342,11 +613,14 @@ namespace BDD {
     template<typename BDD_ITERATOR>
         node_ref bdd_mgr::at_most(BDD_ITERATOR begin, BDD_ITERATOR end, const size_t b)
         {
+            std::vector<std::pair<size_t,bool>> lits;
+            if(literals(begin, end, lits))
+                return count_literals(lits, 0, b);
             assert(std::distance(begin, end) > 0);
             const size_t n = std::distance(begin, end);
 
             if(n < b)
-                return node_cache_.botsink();
+                return node_cache_.topsink();
 
             if(n == 1 && b == 1)
                 return node_cache_.topsink();
@@ -376,6 +650,9 @@ namespace BDD {
     template<typename BDD_ITERATOR>
         node_ref bdd_mgr::cardinality(BDD_ITERATOR begin, BDD_ITERATOR end, const size_t b)
         {
+            std::vector<std::pair<size_t,bool>> lits;
+            if(literals(begin, end, lits))
+                return count_literals(lits, b, b);
             assert(std::distance(begin, end) > 0);
             const size_t n = std::distance(begin, end);
 
@@ -406,4 +683,59 @@ namespace BDD {
 
             return or_rec(combine.begin(), combine.end()); 
         }
+
+    template<typename BDD_ITERATOR, typename COEFFICIENT_ITERATOR>
+        node_ref bdd_mgr::linear_at_most(BDD_ITERATOR begin, BDD_ITERATOR end, COEFFICIENT_ITERATOR coefficient_begin, const std::int64_t bound)
+        {
+            return linear_constraint(begin, end, coefficient_begin, bound, false);
+        }
+
+    template<typename BDD_ITERATOR, typename COEFFICIENT_ITERATOR>
+        node_ref bdd_mgr::linear_equal(BDD_ITERATOR begin, BDD_ITERATOR end, COEFFICIENT_ITERATOR coefficient_begin, const std::int64_t bound)
+        {
+            return linear_constraint(begin, end, coefficient_begin, bound, true);
+        }
+
+    template<typename BDD_ITERATOR, typename COEFFICIENT_ITERATOR>
+        node_ref bdd_mgr::linear_constraint(BDD_ITERATOR begin, BDD_ITERATOR end, COEFFICIENT_ITERATOR coefficient_begin, std::int64_t bound, const bool equality)
+        {
+            // a*f = -a*(not f) + a brings negative coefficients to positive ones
+            std::vector<node_ref> operands;
+            std::vector<std::int64_t> coefficients;
+            auto coefficient_it = coefficient_begin;
+            for(auto it=begin; it!=end; ++it, ++coefficient_it)
+            {
+                const std::int64_t a = *coefficient_it;
+                if(a > 0)
+                {
+                    operands.push_back(*it);
+                    coefficients.push_back(a);
+                }
+                else if(a < 0)
+                {
+                    operands.push_back(negate(*it));
+                    coefficients.push_back(-a);
+                    bound -= a;
+                }
+            }
+
+            std::vector<std::pair<size_t,bool>> lits;
+            const bool direct = literals(operands.begin(), operands.end(), lits);
+            if(direct)
+            {
+                std::vector<size_t> order(operands.size());
+                std::iota(order.begin(), order.end(), 0);
+                std::sort(order.begin(), order.end(), [&](const size_t i, const size_t j) { return operands[i].address()->index < operands[j].address()->index; });
+                std::vector<node_ref> sorted_operands;
+                std::vector<std::int64_t> sorted_coefficients;
+                for(const size_t i : order)
+                {
+                    sorted_operands.push_back(operands[i]);
+                    sorted_coefficients.push_back(coefficients[i]);
+                }
+                std::swap(operands, sorted_operands);
+                std::swap(coefficients, sorted_coefficients);
+            }
+            return linear_constraint(operands, coefficients, bound, equality, direct);
+        }
 }
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "bdd_big_uint.h"
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+namespace BDD {
+
+    // model count given by its binary logarithm, for counts beyond the range of double
+    struct log2_count {
+        double value = -std::numeric_limits<double>::infinity();
+    };
+
+    // arithmetic on model counts. Counts are double, log2_count or big_uint
+    template<typename COUNT>
+        struct count_arithmetic;
+
+    template<>
+        struct count_arithmetic<double> {
+            static double zero() { return 0.0; }
+            static double one() { return 1.0; }
+            static double add(const double a, const double b) { return a + b; }
+            static double sub(const double a, const double b) { return a - b; }
+            static double mul(const double a, const double b) { return a * b; }
+            static double mul_pow2(const double a, const std::size_t k) { return k > std::size_t(std::numeric_limits<int>::max()) ? a * std::numeric_limits<double>::infinity() : std::ldexp(a, int(k)); }
+        };
+
+    template<>
+        struct count_arithmetic<log2_count> {
+            static log2_count zero() { return {}; }
+            static log2_count one() { return {0.0}; }
+            static log2_count add(const log2_count a, const log2_count b)
+            {
+                if(std::isinf(a.value))
+                    return b;
+                if(std::isinf(b.value))
+                    return a;
+                const double m = std::max(a.value, b.value);
+                return {m + std::log2(std::exp2(a.value - m) + std::exp2(b.value - m))};
+            }
+            // b must not be larger
+            static log2_count sub(const log2_count a, const log2_count b)
+            {
+                if(std::isinf(b.value))
+                    return a;
+                const double d = 1.0 - std::exp2(b.value - a.value);
+                if(d <= 0.0) // equal up to rounding
+                    return zero();
+                return {a.value + std::log2(d)};
+            }
+            static log2_count mul(const log2_count a, const log2_count b) { return {a.value + b.value}; }
+            static log2_count mul_pow2(const log2_count a, const std::size_t k) { return {a.value + double(k)}; }
+        };
+
+    template<>
+        struct count_arithmetic<big_uint> {
+            static big_uint zero() { return big_uint(0); }
+            static big_uint one() { return big_uint(1); }
+            static big_uint add(const big_uint& a, const big_uint& b) { return a + b; }
+            static big_uint sub(const big_uint& a, const big_uint& b) { return a - b; }
+            static big_uint mul(const big_uint& a, const big_uint& b) { return a * b; }
+            static big_uint mul_pow2(const big_uint& a, const std::size_t k) { return a << k; }
+        };
+
+    // Model counting on a bdd laid out in topological order: root at position 0, descendants at larger positions.
+    // BDD provides size(), variable(i), lo(i), hi(i), is_topsink(i) and is_botsink(i). Counts are taken over variables 0,...,nr_vars-1, variables skipped by arcs are free.
+    namespace detail {
+
+        template<typename BDD>
+            std::size_t count_level(const BDD& bdd, const std::size_t i, const std::size_t nr_vars)
+            {
+                if(bdd.is_topsink(i) || bdd.is_botsink(i))
+                    return nr_vars;
+                assert(bdd.variable(i) < nr_vars);
+                return bdd.variable(i);
+            }
+
+        // number of models of the variables from the level of each node on, by one reverse sweep
+        template<typename COUNT, typename BDD>
+            std::vector<COUNT> upward_counts(const BDD& bdd, const std::size_t nr_vars)
+            {
+                using arith = count_arithmetic<COUNT>;
+                std::vector<COUNT> up(bdd.size(), arith::zero());
+                for(std::ptrdiff_t i=bdd.size()-1; i>=0; --i)
+                {
+                    if(bdd.is_topsink(i))
+                        up[i] = arith::one();
+                    else if(!bdd.is_botsink(i))
+                    {
+                        const std::size_t x = bdd.variable(i);
+                        const std::size_t lo = bdd.lo(i);
+                        const std::size_t hi = bdd.hi(i);
+                        assert(lo > std::size_t(i) && hi > std::size_t(i));
+                        up[i] = arith::add(
+                                arith::mul_pow2(up[lo], count_level(bdd, lo, nr_vars) - x - 1),
+                                arith::mul_pow2(up[hi], count_level(bdd, hi, nr_vars) - x - 1));
+                    }
+                }
+                return up;
+            }
+
+        template<typename COUNT, typename BDD>
+            COUNT model_count(const BDD& bdd, const std::size_t nr_vars)
+            {
+                assert(bdd.size() > 0);
+                const std::vector<COUNT> up = upward_counts<COUNT>(bdd, nr_vars);
+                return count_arithmetic<COUNT>::mul_pow2(up[0], count_level(bdd, 0, nr_vars));
+            }
+
+        // For each variable the number of models setting it to 1. A forward sweep counts the paths into each node, combined with the upward counts of hi arcs.
+        // Models crossing a level on an arc that skips it take both values there, half of them count. These contributions are spread over the skipped levels by a difference array.
+        template<typename COUNT, typename BDD>
+            std::vector<COUNT> positive_counts(const BDD& bdd, const std::size_t nr_vars)
+            {
+                using arith = count_arithmetic<COUNT>;
+                assert(bdd.size() > 0);
+                const std::vector<COUNT> up = upward_counts<COUNT>(bdd, nr_vars);
+                std::vector<COUNT> down(bdd.size(), arith::zero());
+                std::vector<COUNT> positive(nr_vars, arith::zero());
+                std::vector<COUNT> skip_begin(nr_vars+1, arith::zero());
+                std::vector<COUNT> skip_end(nr_vars+1, arith::zero());
+
+                auto skip = [&](const std::size_t first, const std::size_t last, const COUNT& c) {
+                    skip_begin[first] = arith::add(skip_begin[first], c);
+                    skip_end[last] = arith::add(skip_end[last], c);
+                };
+
+                const std::size_t root_level = count_level(bdd, 0, nr_vars);
+                down[0] = arith::mul_pow2(arith::one(), root_level);
+                if(root_level > 0)
+                    skip(0, root_level, arith::mul_pow2(up[0], root_level - 1));
+
+                for(std::size_t i=0; i<bdd.size(); ++i)
+                {
+                    if(bdd.is_topsink(i) || bdd.is_botsink(i))
+                        continue;
+                    const std::size_t x = bdd.variable(i);
+                    for(const std::size_t c : {bdd.lo(i), bdd.hi(i)})
+                    {
+                        const std::size_t gap = count_level(bdd, c, nr_vars) - x - 1;
+                        down[c] = arith::add(down[c], arith::mul_pow2(down[i], gap));
+                        if(gap > 0)
+                            skip(x+1, x+1+gap, arith::mul(down[i], arith::mul_pow2(up[c], gap - 1)));
+                    }
+                    const std::size_t hi = bdd.hi(i);
+                    positive[x] = arith::add(positive[x], arith::mul(down[i], arith::mul_pow2(up[hi], count_level(bdd, hi, nr_vars) - x - 1)));
+                }
+
+                COUNT crossing = arith::zero();
+                for(std::size_t x=0; x<nr_vars; ++x)
+                {
+                    crossing = arith::add(crossing, skip_begin[x]);
+                    crossing = arith::sub(crossing, skip_end[x]);
+                    positive[x] = arith::add(positive[x], crossing);
+                }
+                return positive;
+            }
+
+    }
+
+}
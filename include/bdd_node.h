@@ -3,16 +3,52 @@
 #include <random>
 #include <cassert>
 #include <vector>
+#include <array>
+#include <iterator>
 #include <functional>
+#include <cstdint>
+#include <limits>
+#include "bdd_model_count.h"
 
 namespace BDD {
 
+// With LBDD_COMPACT_NODES, nodes take 16 bytes: lo and hi are 32 bit offsets into a process-wide node arena and variable index, mark and depth share one 32 bit word.
+// Otherwise nodes take 32 bytes and up to 2^41 variables are supported.
+#ifdef LBDD_COMPACT_NODES
+constexpr static std::size_t logvarsize = 22;
+constexpr static std::size_t lognodedepthsize = 9;
+#else
 constexpr static std::size_t logvarsize = 41;
+constexpr static std::size_t lognodedepthsize = 32;
+#endif
 constexpr static std::size_t maxvarsize = static_cast<std::size_t>(1) << logvarsize;
+constexpr static std::size_t max_node_depth = (static_cast<std::size_t>(1) << lognodedepthsize) - 1;
 constexpr static std::size_t unique_table_hash_size = 22;
 constexpr static std::size_t hashtablesize = static_cast<std::size_t>(1) << unique_table_hash_size;
+// nodes per page of a node cache, the first node of each page is its header, see node_struct::page_header
+constexpr static std::size_t bdd_node_page_size = 4096;
 
 class bdd_mgr;
+class node_struct;
+
+// values of one variable in 64*WORDS assignments for batch evaluation, bit k of word w belongs to assignment 64*w+k
+template<std::size_t WORDS = 1>
+using assignment_batch = std::array<std::uint64_t, WORDS>;
+
+#ifdef LBDD_COMPACT_NODES
+// first node of the node arena. All nodes of all bdd managers are allocated in this arena, see bdd_node_cache.
+extern node_struct* compact_node_base;
+
+// 32 bit reference to a node in the node arena that behaves like a node pointer
+struct node_link
+{
+    std::uint32_t offset;
+
+    operator node_struct*() const;
+    node_struct* operator->() const;
+    node_link& operator=(node_struct* p);
+};
+#endif
 
 class node_struct
 {
@@ -29,16 +65,36 @@ class node_struct
     void recursively_revive();
     void recursively_kill();
     void deref();
-    bool dead() const { return xref <= 0; }
-
+    bool dead() const { return reference_count() <= 0; }
+    // reference count access, atomic in concurrent mode
+    int reference_count() const;
+    void inc_xref();
+    void dec_xref();
+    std::size_t depth() const { return depth_; }
+
+    // variables gives the variable of each level as returned by level_variables, nullptr if levels and variables coincide
+    template<typename ITERATOR>
+    bool evaluate(ITERATOR var_begin, ITERATOR var_end, const std::size_t* variables = nullptr);
+    // iterators point to one assignment_batch per variable, bit k of the result tells whether assignment k is satisfying.
+    // The batch is split along the paths it takes, so at most one path per assignment is visited.
     template<typename ITERATOR>
-    bool evaluate(ITERATOR var_begin, ITERATOR var_end);
+    typename std::iterator_traits<ITERATOR>::value_type evaluate_batch(ITERATOR var_begin, ITERATOR var_end, const std::size_t* variables = nullptr);
+    // variable at each level of the manager of this node, nullptr as long as the variables have not been reordered.
+    // Constant time while no manager has moved variables, else linear in the depth of the node
+    const std::size_t* level_variables();
 
     size_t nr_nodes();
     std::vector<node_struct*> nodes_postorder();
     std::vector<node_struct*> nodes_bfs();
+    // levels of the nodes, ascending
     std::vector<size_t> variables();
     bool exactly_one_solution();
+    // number of satisfying assignments of variables 0,...,nr_vars-1 and, for each variable, the number of those setting it to 1. COUNT is double, log2_count or big_uint
+    // Counts are taken over variables, also after reordering
+    template<typename COUNT>
+    COUNT model_count(const std::size_t nr_vars);
+    template<typename COUNT>
+    std::vector<COUNT> positive_counts(const std::size_t nr_vars);
 
     void init_botsink(bdd_mgr* mgr);
     bool is_botsink() const;
@@ -46,28 +102,48 @@ class node_struct
     bool is_topsink() const;
     bool is_terminal() const { return is_topsink() || is_botsink(); }
 
-    union { node_struct* lo; bdd_mgr* bdd_mgr_1; node_struct* next_available; };
+#ifdef LBDD_COMPACT_NODES
+    union { struct { node_link lo; node_link hi; }; bdd_mgr* bdd_mgr_1; node_struct* next_available; std::ptrdiff_t* dead_nodes; };
+
+    // hash of the position in the node arena, takes the place of a random hash key
+    std::size_t hash_key() const { return (std::uint32_t(this - compact_node_base) * std::uint32_t(2654435761)) >> (32 - unique_table_hash_size); }
+    std::uint32_t offset() const { return std::uint32_t(this - compact_node_base); }
+
+    std::uint32_t index : logvarsize;
+    std::uint32_t marked_ : 1;
+    // length of longest path to a terminal, saturating at max_node_depth
+    std::uint32_t depth_ : lognodedepthsize;
+	int xref = 0;
+#else
+    union { node_struct* lo; bdd_mgr* bdd_mgr_1; node_struct* next_available; std::ptrdiff_t* dead_nodes; };
     union { node_struct* hi; bdd_mgr* bdd_mgr_2; };
 	//node_struct* lo = nullptr;
     //node_struct* hi = nullptr;
     // TODO: make enum
     //node_struct* next_available = nullptr;
-    
-    // TODO: possibly put away with hash_key field and combine index, marked and xref into one 64 bit field.
+
+    std::size_t hash_key() const { return hash_key_; }
     
     std::size_t index : logvarsize;
-    std::size_t hash_key : unique_table_hash_size; // make const
+    std::size_t hash_key_ : unique_table_hash_size; // make const
     std::size_t marked_ : 1;
-    //std::size_t large_subtree : 1; // subtree is large enough so that recursively visiting nodes would exceed stack
 	int xref = 0;
+    // length of longest path to a terminal, saturating at max_node_depth. Occupies the padding after xref, so that nodes do not grow.
+    unsigned int depth_ = 0;
+#endif
 
     constexpr static size_t botsink_index = std::pow(2,logvarsize)-1;
     constexpr static size_t topsink_index = std::pow(2,logvarsize)-2;
+    // index of nodes reclaimed by incremental garbage collection that may still be referenced by memos, see bdd_node_cache::retire_node
+    constexpr static size_t retired_index = std::pow(2,logvarsize)-3;
+    bool is_retired() const { return index == retired_index; }
 
     template<typename STREAM>
         void print(STREAM& s);
 
     bdd_mgr* find_bdd_mgr();
+    // first node of the page holding this node, whose dead_nodes points to the number of dead nodes of the owning node cache
+    node_struct* page_header();
 
     private:
     size_t nr_nodes_impl();
@@ -81,6 +157,40 @@ class node_struct
 
 using node = node_struct;
 
+#ifdef LBDD_COMPACT_NODES
+inline node_struct* node_struct::page_header() { return compact_node_base + (offset() & ~std::uint32_t(bdd_node_page_size - 1)); }
+#else
+inline node_struct* node_struct::page_header()
+{
+    // pages are aligned to their size, see bdd_node_page
+    return reinterpret_cast<node_struct*>(reinterpret_cast<std::uintptr_t>(this) & ~std::uintptr_t(bdd_node_page_size * sizeof(node_struct) - 1));
+}
+#endif
+
+#ifdef LBDD_CONCURRENT
+inline int node_struct::reference_count() const { return __atomic_load_n(&xref, __ATOMIC_RELAXED); }
+inline void node_struct::inc_xref() { __atomic_fetch_add(&xref, 1, __ATOMIC_RELAXED); }
+inline void node_struct::dec_xref() { __atomic_fetch_sub(&xref, 1, __ATOMIC_RELAXED); }
+#else
+inline int node_struct::reference_count() const { return xref; }
+inline void node_struct::inc_xref() { if(xref++ == 0) --*page_header()->dead_nodes; }
+inline void node_struct::dec_xref() { if(--xref == 0) ++*page_header()->dead_nodes; }
+#endif
+
+#ifdef LBDD_COMPACT_NODES
+static_assert(sizeof(node) == 16);
+
+inline node_link::operator node_struct*() const { return compact_node_base + offset; }
+inline node_struct* node_link::operator->() const { return compact_node_base + offset; }
+
+inline node_link& node_link::operator=(node_struct* p)
+{
+    assert(p >= compact_node_base);
+    offset = p->offset();
+    return *this;
+}
+#endif
+
 class node_ref {
     public:
     node_ref(const node_ref& o);
@@ -97,17 +207,26 @@ class node_ref {
     bool is_terminal() const { return ref->is_terminal(); }
     size_t nr_nodes() const { return ref->nr_nodes(); }
     bool exactly_one_solution() const { return ref->exactly_one_solution(); }
+    template<typename COUNT = double>
+    COUNT model_count(const size_t nr_vars) const { return ref->model_count<COUNT>(nr_vars); }
+    template<typename COUNT = double>
+    std::vector<COUNT> positive_counts(const size_t nr_vars) const { return ref->positive_counts<COUNT>(nr_vars); }
     bdd_mgr* find_bdd_mgr() { return ref->find_bdd_mgr(); }
     node_ref botsink();
     node_ref topsink();
 
-    size_t reference_count() const { return ref->xref; }
+    size_t reference_count() const { return ref->reference_count(); }
 
+    // assignments, variable and variables are given by variable, also after the manager has reordered them
     template<typename ITERATOR>
-    bool evaluate(ITERATOR var_begin, ITERATOR var_end) { return ref->evaluate(var_begin, var_end); }
+    bool evaluate(ITERATOR var_begin, ITERATOR var_end) { return ref->evaluate(var_begin, var_end, ref->level_variables()); }
+    template<typename ITERATOR>
+    typename std::iterator_traits<ITERATOR>::value_type evaluate_batch(ITERATOR var_begin, ITERATOR var_end) { return ref->evaluate_batch(var_begin, var_end, ref->level_variables()); }
 
-    size_t variable() const { return ref->index; }
-    std::vector<size_t> variables() { return ref->variables(); }
+    size_t variable() const;
+    size_t depth() const { return ref->depth(); }
+    // ascending
+    std::vector<size_t> variables();
 
     template<typename STREAM>
         void print(STREAM& s) { return ref->print(s); }
@@ -127,23 +246,70 @@ class node_ref {
     void unmark_rec() { ref->unmark(); }
 
     private:
+    // position of the variable in the current order, used by the synthesis algorithms of bdd_mgr
+    size_t level() const { return ref->index; }
     node* ref = nullptr;
 };
 
 template<typename ITERATOR>
-bool node_struct::evaluate(ITERATOR var_begin, ITERATOR var_end)
+bool node_struct::evaluate(ITERATOR var_begin, ITERATOR var_end, const std::size_t* variables)
 {
-    if(this->is_botsink())
-        return false;
-    if(this->is_topsink())
-        return true;
-    assert(index < std::distance(var_begin, var_end));
-    const bool x = *(var_begin + this->index);
-    if(x == true)
-        return hi->evaluate(var_begin, var_end);
-    else
-        return lo->evaluate(var_begin, var_end);
+    node_struct* p = this;
+    while(!p->is_terminal())
+    {
+        const std::size_t var = variables == nullptr ? p->index : variables[p->index];
+        assert(var < std::size_t(std::distance(var_begin, var_end)));
+        if(*(var_begin + var))
+            p = p->hi;
+        else
+            p = p->lo;
+    }
+    return p->is_topsink();
+}
 
+template<typename ITERATOR>
+typename std::iterator_traits<ITERATOR>::value_type node_struct::evaluate_batch(ITERATOR var_begin, ITERATOR var_end, const std::size_t* variables)
+{
+    using batch = typename std::iterator_traits<ITERATOR>::value_type;
+    constexpr std::size_t words = std::tuple_size<batch>::value;
+
+    // parts of the batch still to be propagated, by node they have reached
+    static thread_local std::vector<std::pair<node_struct*, batch>> stack;
+    const std::size_t stack_base = stack.size();
+    batch all;
+    all.fill(~std::uint64_t(0));
+    stack.push_back({this, all});
+    batch result = {};
+    while(stack.size() > stack_base)
+    {
+        const auto [p, mask] = stack.back();
+        stack.pop_back();
+        if(p->is_topsink())
+        {
+            for(std::size_t w=0; w<words; ++w)
+                result[w] |= mask[w];
+            continue;
+        }
+        if(p->is_botsink())
+            continue;
+        const std::size_t var = variables == nullptr ? p->index : variables[p->index];
+        assert(var < std::size_t(std::distance(var_begin, var_end)));
+        const batch& x = *(var_begin + var);
+        batch lo_mask, hi_mask;
+        std::uint64_t lo_any = 0, hi_any = 0;
+        for(std::size_t w=0; w<words; ++w)
+        {
+            lo_mask[w] = mask[w] & ~x[w];
+            hi_mask[w] = mask[w] & x[w];
+            lo_any |= lo_mask[w];
+            hi_any |= hi_mask[w];
+        }
+        if(hi_any != 0)
+            stack.push_back({p->hi, hi_mask});
+        if(lo_any != 0)
+            stack.push_back({p->lo, lo_mask});
+    }
+    return result;
 }
 
 template<typename STREAM>
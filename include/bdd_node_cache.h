@@ -2,41 +2,95 @@
 
 #include <memory>
 #include <random>
+#include <array>
+#include <vector>
+#ifdef LBDD_CONCURRENT
+#include <mutex>
+#endif
 #include "bdd_node.h"
 
 namespace BDD {
 
-constexpr static std::size_t bdd_node_page_size = 4096;
-
+#ifdef LBDD_COMPACT_NODES
 struct bdd_node_page
+#else
+// aligned to its size, so that node_struct::page_header can find the first node of the page
+struct alignas(bdd_node_page_size * sizeof(node)) bdd_node_page
+#endif
 {
     std::array<node,bdd_node_page_size> data;
-    std::unique_ptr<bdd_node_page> next;
 };
 
+#ifdef LBDD_COMPACT_NODES
+// maximal number of nodes addressable by node_link
+constexpr static std::size_t log_compact_node_arena_size = 32;
+constexpr static std::size_t compact_node_arena_size = static_cast<std::size_t>(1) << log_compact_node_arena_size;
+
+// Process-wide virtual memory region holding the nodes of all bdd managers, so that nodes can be addressed by 32 bit offsets.
+// Address space is reserved at once, physical memory is only committed for pages in use.
+class compact_node_arena
+{
+    public:
+        static bdd_node_page* reserve_page();
+        static void free_page(bdd_node_page* p);
+};
+#endif
+
 class bdd_mgr;
+#ifdef LBDD_CONCURRENT
+struct node_magazine;
+#endif
 
 class bdd_node_cache
 {
     public:
         bdd_node_cache(bdd_mgr* mgr);
+        ~bdd_node_cache();
+        bdd_node_cache(const bdd_node_cache&) = delete;
         node* reserve_node(void);
         void free_node(node*p);
-        std::size_t nr_nodes() const { return total_nodes; }
+        // Like free_node, but the node is only handed out again after release_retired_nodes.
+        // Until then it is marked as retired, so that memos still pointing to it can be recognized as stale.
+        void retire_node(node* p);
+        void release_retired_nodes();
+        std::size_t nr_nodes() const;
+        std::size_t peak_nr_nodes() const; // maximal nr of nodes in use at any time
+        std::size_t nr_nodes_created() const; // nr of node reservations over the lifetime of the cache
+#ifndef LBDD_CONCURRENT
+        // nodes with reference count zero, not tracked in concurrent mode
+        std::size_t nr_dead_nodes() const;
+#endif
         node* botsink() const { return botsink_; }
         node* topsink() const { return topsink_; }
+        std::size_t nr_pages() const; // pages allocated for nodes
 
     private:
-        void increase_cache(); // double size of node cache
+        void increase_cache(); // add one page to node cache
+        void init_page_header(bdd_node_page* p); // first node of each page points to deadnodes
+#ifdef LBDD_CONCURRENT
+        // in concurrent mode each thread takes nodes from its own magazine of each cache, which is refilled with node_magazine_size nodes at once from the shared cache.
+        // Freed nodes beyond two refills go back to the shared free list, as do all nodes of a magazine when its thread exits.
+        constexpr static std::size_t node_magazine_size = 256;
+        friend struct thread_magazines;
+        node_magazine& thread_magazine(); // magazine of calling thread for this cache, created on first use
+        void refill_magazine(node_magazine& m);
+        // move freed and unused nodes of magazine to the shared free list
+        void return_nodes(node_magazine& m, const std::size_t nr_avail);
+        mutable std::mutex mutex_; // guards shared free list, pages and statistics
+        const std::size_t id_; // distinguishes caches in thread local magazines, never reused
+#endif
 
-        std::unique_ptr<bdd_node_page> mem_node;
-        node* nodeavail; // smallest unused node in mem_node
-        node* nodeptr; // stack of nodes available for reuse
+        std::vector<bdd_node_page*> mem_node; // last page is the one currently filled
+        node* nodeavail; // stack of nodes available for reuse
+        node* retired_ = nullptr; // stack of retired nodes not yet available for reuse
+        node* nodeptr; // smallest unused node in last page of mem_node
         // sink nodes
         node* botsink_;
         node* topsink_; 
         std::size_t total_nodes = 2; // nr nodes currently in use
-        std::size_t deadnodes = 0; // nr nodes currently having xref < 0
+        std::size_t peak_nodes = 2;
+        std::size_t nodes_created = 0;
+        std::ptrdiff_t deadnodes = 0; // nr nodes currently having xref <= 0, updated through the page headers
 };
 
 }
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "bdd_memo_cache.h"
+
+namespace BDD {
+
+    // Binary Boolean operators given by their truth table, bit 2*a + b holds a op b.
+    // The apply kernels of bdd_mgr and bdd_collection derive their terminal cases and whether to normalize operand order from the table at compile time.
+    template<unsigned TABLE, memo_operation OPERATION>
+        struct binary_operator {
+            static_assert(TABLE < 16, "truth table of a binary operator has four entries");
+            constexpr static unsigned char table = TABLE;
+            constexpr static memo_operation operation = OPERATION;
+            constexpr static bool value(const bool a, const bool b) { return (TABLE >> (2*a + b)) & 1; }
+            constexpr static bool commutative = value(false, true) == value(true, false);
+        };
+
+    using and_operator = binary_operator<0b1000, memo_operation::and_op>;
+    using or_operator = binary_operator<0b1110, memo_operation::or_op>;
+    using xor_operator = binary_operator<0b0110, memo_operation::xor_op>;
+    using nand_operator = binary_operator<0b0111, memo_operation::nand_op>;
+    // a implies b
+    using implies_operator = binary_operator<0b1011, memo_operation::implies_op>;
+    // a and not b
+    using diff_operator = binary_operator<0b0100, memo_operation::diff_op>;
+    using equiv_operator = binary_operator<0b1001, memo_operation::equiv_op>;
+
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "bdd_collection.h"
+#include <vector>
+#include <iterator>
+#include <cstdint>
+#include <cassert>
+
+namespace BDD {
+
+    // Bdds stored as roots into shared reduced instruction DAGs, so subgraphs common to several bdds are held once.
+    // Each call to add_bdds imports all its roots by one marked traversal and appends one block: its non-terminal instructions in reverse postorder, followed by botsink and topsink.
+    // Arcs are positions in the whole instruction vector as in bdd_collection, nodes are shared within a block but not between blocks.
+    // A node reachable from roots of two calls is stored twice, so roots sharing subgraphs must be imported together. For this reason there is no add_bdd for a single root.
+    class bdd_shared_collection {
+        public:
+            // instructions reachable from one root in topological order, the root first and botsink and topsink last.
+            // Their arcs are positions in the whole instruction vector, not in the view, see export_bdd for making them relative. Views stay valid until bdds are added or cleared.
+            class bdd_view {
+                public:
+                    class iterator {
+                        public:
+                            using iterator_category = std::forward_iterator_tag;
+                            using value_type = bdd_instruction;
+                            using difference_type = std::ptrdiff_t;
+                            using pointer = const bdd_instruction*;
+                            using reference = const bdd_instruction&;
+
+                            iterator(const bdd_instruction* instructions, const size_t* it) : instructions_(instructions), it_(it) {}
+                            reference operator*() const { return instructions_[*it_]; }
+                            pointer operator->() const { return &instructions_[*it_]; }
+                            iterator& operator++() { ++it_; return *this; }
+                            iterator operator++(int) { iterator i = *this; ++it_; return i; }
+                            bool operator==(const iterator& o) const { return it_ == o.it_; }
+                            bool operator!=(const iterator& o) const { return it_ != o.it_; }
+
+                        private:
+                            const bdd_instruction* instructions_;
+                            const size_t* it_;
+                    };
+
+                    iterator begin() const { return iterator(instructions_, positions_begin_); }
+                    iterator end() const { return iterator(instructions_, positions_end_); }
+                    size_t size() const { return positions_end_ - positions_begin_; }
+                    // positions of the instructions in the shared instruction vector, ascending
+                    const size_t* positions_begin() const { return positions_begin_; }
+                    const size_t* positions_end() const { return positions_end_; }
+
+                private:
+                    friend class bdd_shared_collection;
+                    bdd_view(const bdd_instruction* instructions, const std::vector<size_t>& positions) : instructions_(instructions), positions_begin_(positions.data()), positions_end_(positions.data() + positions.size()) {}
+                    const bdd_instruction* instructions_;
+                    const size_t* positions_begin_;
+                    const size_t* positions_end_;
+            };
+
+            // import by one marked traversal of all roots, returns the number of the first one. Must not run concurrently with operations of the bdd_mgr
+            template<typename NODE_REF_ITERATOR>
+                size_t add_bdds(NODE_REF_ITERATOR root_begin, NODE_REF_ITERATOR root_end);
+            node_ref export_bdd(bdd_mgr& mgr, const size_t bdd_nr) const;
+
+            size_t nr_bdds() const { return roots.size(); }
+            size_t size() const { return nr_bdds(); }
+            // instructions of all blocks, each shared node once
+            size_t nr_instructions() const { return bdd_instructions.size(); }
+            // number of instructions reachable from the root including the terminals, the first call per bdd computes its view
+            size_t nr_bdd_nodes(const size_t bdd_nr) const { return get_bdd_instructions(bdd_nr).size(); }
+            // position of the root instruction
+            size_t root(const size_t bdd_nr) const { assert(bdd_nr < nr_bdds()); return roots[bdd_nr]; }
+            size_t offset(const bdd_instruction& instr) const;
+            const bdd_instruction& operator()(const size_t position) const { assert(position < bdd_instructions.size()); return bdd_instructions[position]; }
+            // the reachable positions are searched once per bdd and kept, so this must not run concurrently with itself
+            bdd_view get_bdd_instructions(const size_t bdd_nr) const;
+
+            template<typename ITERATOR>
+                bool evaluate(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const;
+            // as bdd_collection::evaluate_batch, the sweep covers the instructions of the view only. Computes the view as get_bdd_instructions does
+            template<typename ITERATOR>
+                typename std::iterator_traits<ITERATOR>::value_type evaluate_batch(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const;
+
+            // remove all bdds, memory is kept
+            void clear() { bdd_instructions.clear(); block_delimiters.resize(1); roots.clear(); root_blocks.clear(); bdd_positions.clear(); bdd_view_instructions.clear(); }
+
+        private:
+            // append one block holding the nodes reachable from import_roots
+            void add_block();
+
+            std::vector<bdd_instruction> bdd_instructions;
+            std::vector<size_t> block_delimiters = {0};
+            std::vector<size_t> roots; // position of the root of each bdd
+            std::vector<size_t> root_blocks; // block of each bdd
+            // ascending positions reachable from each root, computed by the first get_bdd_instructions for it and empty before
+            mutable std::vector<std::vector<size_t>> bdd_positions;
+            // instructions of each view with arcs relative to it, computed together with bdd_positions
+            mutable std::vector<std::vector<bdd_instruction>> bdd_view_instructions;
+
+            // temporary memory for importing bdds: non-terminal nodes in postorder, the traversal stack and the roots of the current import
+            std::vector<node*> import_nodes;
+            std::vector<node*> import_stack;
+            std::vector<node*> import_roots;
+#ifdef LBDD_COMPACT_NODES
+            // compact nodes have no field to spare for the postorder position
+            flat_hash_map<node*, size_t, std::hash<node*>> import_positions;
+#endif
+    };
+
+    template<typename NODE_REF_ITERATOR>
+        size_t bdd_shared_collection::add_bdds(NODE_REF_ITERATOR root_begin, NODE_REF_ITERATOR root_end)
+        {
+            const size_t first_bdd_nr = nr_bdds();
+            assert(import_roots.empty());
+            for(auto it=root_begin; it!=root_end; ++it)
+            {
+                assert(!it->is_terminal());
+                import_roots.push_back(it->address());
+            }
+            add_block();
+            import_roots.clear();
+            return first_bdd_nr;
+        }
+
+    template<typename ITERATOR>
+        bool bdd_shared_collection::evaluate(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const
+        {
+            assert(bdd_nr < nr_bdds());
+            return detail::evaluate_instructions(bdd_instructions.data(), roots[bdd_nr], var_begin, var_end);
+        }
+
+    template<typename ITERATOR>
+        typename std::iterator_traits<ITERATOR>::value_type bdd_shared_collection::evaluate_batch(const size_t bdd_nr, ITERATOR var_begin, ITERATOR var_end) const
+        {
+            assert(bdd_nr < nr_bdds());
+            get_bdd_instructions(bdd_nr);
+            const std::vector<bdd_instruction>& instructions = bdd_view_instructions[bdd_nr];
+            return detail::evaluate_instructions_batch(instructions.data(), 0, instructions.size(), var_begin, var_end);
+        }
+
+}
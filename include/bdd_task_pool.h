@@ -0,0 +1,92 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+namespace BDD {
+
+    // Fork-join thread pool with work stealing for parallel synthesis in concurrent mode.
+    // Each thread owns a deque of tasks, it pushes and pops at the back while idle threads steal from the front of other deques.
+    // Threads not belonging to the pool share one additional deque.
+    class bdd_task_pool {
+        public:
+            bdd_task_pool(const size_t nr_threads);
+            ~bdd_task_pool();
+            bdd_task_pool(const bdd_task_pool&) = delete;
+            size_t nr_threads() const { return workers.size() + 1; }
+
+            // run f0 and f1, possibly in parallel, and return after both have finished
+            template<typename F0, typename F1>
+                void fork_join(F0&& f0, F1&& f1);
+            // number of fork_join calls enclosing the calling code, also for tasks run by other threads
+            static size_t nesting();
+
+        private:
+            struct task {
+                void (*run)(void*);
+                void* data;
+                size_t nesting;
+                std::atomic<bool> done{false};
+            };
+
+            struct task_deque {
+                std::mutex mutex;
+                std::deque<task*> tasks;
+            };
+
+            void push(task* t);
+            task* pop_back();
+            task* steal(); // from front of any deque
+            void execute(task* t);
+            static void set_nesting(const size_t n);
+            void worker_loop(const size_t i);
+            task_deque& own_deque();
+
+            std::vector<std::unique_ptr<task_deque>> deques; // last one for threads not in pool
+            std::vector<std::thread> workers;
+            std::atomic<size_t> nr_queued{0};
+            std::atomic<bool> stop{false};
+            std::mutex sleep_mutex;
+            std::condition_variable sleep_cv;
+    };
+
+    template<typename F0, typename F1>
+        void bdd_task_pool::fork_join(F0&& f0, F1&& f1)
+        {
+            task t;
+            t.run = [](void* f) { (*static_cast<std::remove_reference_t<F1>*>(f))(); };
+            t.data = &f1;
+            t.nesting = nesting() + 1;
+            push(&t);
+
+            set_nesting(t.nesting);
+            f0();
+            set_nesting(t.nesting - 1);
+
+            // if not stolen meanwhile, t lies at the back of our deque, since nested forks have been joined
+            task* b = pop_back();
+            if(b == &t)
+            {
+                execute(&t);
+                return;
+            }
+            if(b != nullptr)
+                execute(b);
+
+            // help with other tasks until t is finished
+            while(!t.done.load(std::memory_order_acquire))
+            {
+                task* o = steal();
+                if(o != nullptr)
+                    execute(o);
+                else
+                    std::this_thread::yield();
+            }
+        }
+
+}
@@ -3,6 +3,10 @@
 #include <memory>
 #include <array>
 #include <vector>
+#ifdef LBDD_CONCURRENT
+#include <mutex>
+#include <shared_mutex>
+#endif
 #include "bdd_node.h"
 #include "bdd_node_cache.h"
 
@@ -46,6 +50,9 @@ class unique_table_page_cache {
 
     private: 
         void increase_cache();
+#ifdef LBDD_CONCURRENT
+        std::mutex mutex; // unique tables of different variables may grow concurrently
+#endif
         unique_table_page<PAGE_SIZE>* page_avail; // stack of pages for reuse
         std::vector<unique_table_page<PAGE_SIZE>*> pages;
 }; 
@@ -85,8 +92,20 @@ class var_struct {
         node* unique_table_lookup(node* l, node* h);
         node* unique_find(const std::size_t index, node* l,node* h); 
         node* unique_find(node* l,node* h); 
+        // In concurrent mode unique_find may be called from several threads. Adding variables and removing dead nodes must not run concurrently to it.
         //node* projection() const;
-        void remove_dead_nodes();
+        // retire instead of freeing dead nodes during incremental garbage collection, see bdd_node_cache::retire_node
+        void remove_dead_nodes(const bool retire = false);
+
+        // for variable reordering: move nodes out of and into the unique table without creating or freeing them
+        void extract_nodes(std::vector<node*>& nodes);
+        void insert_node(node* p);
+        template<typename F>
+            void for_each_node(F&& f) const;
+        std::size_t nr_nodes() const { return hash_table_size() - free; }
+        // variable currently at the level of this unique table
+        std::size_t variable() const { return name; }
+        void set_variable(const std::size_t v) { name = v; }
 
     private:
         const size_t var;
@@ -123,13 +142,14 @@ class var_struct {
         std::size_t next_free_slot(const std::size_t hash) const;
         void store_node(const size_t k, node* p);
         void double_cache();
+#ifdef LBDD_CONCURRENT
+        node* unique_find_concurrent(const std::size_t index, node* l, node* h);
+#endif
 
         size_t mask = 0; // number of pages for the unique table minus 1 
         size_t free = 0; // number of unused slots in the unique table for v
-        //std::size_t dead_nodes = 0;
         std::size_t timer = 0;
-        constexpr static std::size_t timerinterval = 1024;
-        constexpr static double dead_fraction = 1.0;
+        constexpr static std::size_t timerinterval = 1024; // nr of node creations between garbage collection steps
         //std::array<unique_table_page*, nr_unique_table_pages> base = {}; // base addresses for its pages
         std::size_t name; // user's name (subscript) for this variable
         unsigned int timestamp; // time stamp for composition
@@ -137,10 +157,21 @@ class var_struct {
         struct var_struct *up, *down; // the neighboring active variables
 
         bdd_mgr& bdd_mgr_;
+#ifdef LBDD_CONCURRENT
+        std::unique_ptr<std::shared_mutex> table_mutex; // taken exclusively only for resizing the unique table
+#endif
 };
 
 using var = var_struct;
 
+    template<typename F>
+void var_struct::for_each_node(F&& f) const
+{
+    for(std::size_t k=0; k<=mask; ++k)
+        if(base[k] != nullptr)
+            f(base[k]);
+}
+
     template<size_t PAGE_SIZE, size_t NR_SIMUL_ALLOC>
 unique_table_page_cache<PAGE_SIZE, NR_SIMUL_ALLOC>::unique_table_page_cache()
 {
@@ -167,23 +198,26 @@ void unique_table_page_cache<PAGE_SIZE, NR_SIMUL_ALLOC>::increase_cache()
     template<size_t PAGE_SIZE, size_t NR_SIMUL_ALLOC>
 unique_table_page<PAGE_SIZE>* unique_table_page_cache<PAGE_SIZE, NR_SIMUL_ALLOC>::reserve_page()
 {
-    unique_table_page<PAGE_SIZE>* r = page_avail;
-    if(r != nullptr)
-    {
+    unique_table_page<PAGE_SIZE>* r = [&]() {
+#ifdef LBDD_CONCURRENT
+        std::lock_guard<std::mutex> lock(mutex);
+#endif
+        if(page_avail == nullptr)
+            increase_cache();
+        unique_table_page<PAGE_SIZE>* p = page_avail;
         page_avail = page_avail->next_available;
-        std::fill(r->data.begin(), r->data.end(), nullptr);
-        return r;
-    }
-    else
-    {
-        increase_cache();
-        return reserve_page();
-    }
+        return p;
+    }();
+    std::fill(r->data.begin(), r->data.end(), nullptr);
+    return r;
 }
 
     template<size_t PAGE_SIZE, size_t NR_SIMUL_ALLOC>
 void unique_table_page_cache<PAGE_SIZE, NR_SIMUL_ALLOC>::free_page(unique_table_page<PAGE_SIZE>* p)
 {
+#ifdef LBDD_CONCURRENT
+    std::lock_guard<std::mutex> lock(mutex);
+#endif
     p->next_available = page_avail;
     page_avail= p;
 }
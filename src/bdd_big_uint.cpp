@@ -0,0 +1,198 @@
+#include "bdd_big_uint.h"
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace BDD {
+
+    big_uint::big_uint(const std::uint64_t x)
+    {
+        if(x != 0)
+            limbs_.push_back(std::uint32_t(x));
+        if(x >> 32 != 0)
+            limbs_.push_back(std::uint32_t(x >> 32));
+    }
+
+    void big_uint::trim()
+    {
+        while(!limbs_.empty() && limbs_.back() == 0)
+            limbs_.pop_back();
+    }
+
+    big_uint& big_uint::operator+=(const big_uint& o)
+    {
+        if(limbs_.size() < o.limbs_.size())
+            limbs_.resize(o.limbs_.size(), 0);
+        std::uint64_t carry = 0;
+        for(std::size_t i=0; i<limbs_.size(); ++i)
+        {
+            if(i >= o.limbs_.size() && carry == 0)
+                break;
+            const std::uint64_t s = std::uint64_t(limbs_[i]) + (i < o.limbs_.size() ? o.limbs_[i] : 0) + carry;
+            limbs_[i] = std::uint32_t(s);
+            carry = s >> 32;
+        }
+        if(carry != 0)
+            limbs_.push_back(std::uint32_t(carry));
+        return *this;
+    }
+
+    big_uint& big_uint::operator-=(const big_uint& o)
+    {
+        assert(!(*this < o));
+        std::int64_t borrow = 0;
+        for(std::size_t i=0; i<limbs_.size(); ++i)
+        {
+            if(i >= o.limbs_.size() && borrow == 0)
+                break;
+            std::int64_t d = std::int64_t(limbs_[i]) - (i < o.limbs_.size() ? std::int64_t(o.limbs_[i]) : 0) - borrow;
+            borrow = d < 0;
+            if(d < 0)
+                d += std::int64_t(1) << 32;
+            limbs_[i] = std::uint32_t(d);
+        }
+        assert(borrow == 0);
+        trim();
+        return *this;
+    }
+
+    big_uint& big_uint::operator<<=(const std::size_t k)
+    {
+        if(is_zero())
+            return *this;
+        const std::size_t limb_shift = k / 32;
+        const std::size_t bit_shift = k % 32;
+        if(bit_shift != 0)
+        {
+            std::uint32_t carry = 0;
+            for(std::uint32_t& l : limbs_)
+            {
+                const std::uint32_t next_carry = l >> (32 - bit_shift);
+                l = (l << bit_shift) | carry;
+                carry = next_carry;
+            }
+            if(carry != 0)
+                limbs_.push_back(carry);
+        }
+        limbs_.insert(limbs_.begin(), limb_shift, 0);
+        return *this;
+    }
+
+    big_uint& big_uint::operator>>=(const std::size_t k)
+    {
+        const std::size_t limb_shift = k / 32;
+        const std::size_t bit_shift = k % 32;
+        if(limb_shift >= limbs_.size())
+        {
+            limbs_.clear();
+            return *this;
+        }
+        limbs_.erase(limbs_.begin(), limbs_.begin() + limb_shift);
+        if(bit_shift != 0)
+        {
+            for(std::size_t i=0; i<limbs_.size(); ++i)
+            {
+                const std::uint32_t next = i+1 < limbs_.size() ? limbs_[i+1] : 0;
+                limbs_[i] = (limbs_[i] >> bit_shift) | (next << (32 - bit_shift));
+            }
+        }
+        trim();
+        return *this;
+    }
+
+    big_uint operator*(const big_uint& a, const big_uint& b)
+    {
+        big_uint r;
+        if(a.is_zero() || b.is_zero())
+            return r;
+        r.limbs_.resize(a.limbs_.size() + b.limbs_.size(), 0);
+        for(std::size_t i=0; i<a.limbs_.size(); ++i)
+        {
+            std::uint64_t carry = 0;
+            for(std::size_t j=0; j<b.limbs_.size(); ++j)
+            {
+                const std::uint64_t p = std::uint64_t(a.limbs_[i]) * b.limbs_[j] + r.limbs_[i+j] + carry;
+                r.limbs_[i+j] = std::uint32_t(p);
+                carry = p >> 32;
+            }
+            for(std::size_t k=i+b.limbs_.size(); carry != 0; ++k)
+            {
+                const std::uint64_t s = std::uint64_t(r.limbs_[k]) + carry;
+                r.limbs_[k] = std::uint32_t(s);
+                carry = s >> 32;
+            }
+        }
+        r.trim();
+        return r;
+    }
+
+    bool big_uint::operator<(const big_uint& o) const
+    {
+        if(limbs_.size() != o.limbs_.size())
+            return limbs_.size() < o.limbs_.size();
+        return std::lexicographical_compare(limbs_.rbegin(), limbs_.rend(), o.limbs_.rbegin(), o.limbs_.rend());
+    }
+
+    std::size_t big_uint::bit_width() const
+    {
+        if(is_zero())
+            return 0;
+        std::size_t w = 32 * (limbs_.size() - 1);
+        for(std::uint32_t top = limbs_.back(); top != 0; top >>= 1)
+            ++w;
+        return w;
+    }
+
+    double big_uint::to_double() const
+    {
+        double d = 0.0;
+        for(auto it = limbs_.rbegin(); it != limbs_.rend(); ++it)
+        {
+            d = d * 4294967296.0 + double(*it);
+            if(std::isinf(d))
+                return std::numeric_limits<double>::infinity();
+        }
+        return d;
+    }
+
+    double big_uint::log2() const
+    {
+        if(is_zero())
+            return -std::numeric_limits<double>::infinity();
+        // the leading 64 bits determine the logarithm to double precision
+        const std::size_t w = bit_width();
+        const std::size_t shift = w > 64 ? w - 64 : 0;
+        return std::log2((*this >> shift).to_double()) + double(shift);
+    }
+
+    std::string big_uint::to_string() const
+    {
+        if(is_zero())
+            return "0";
+        // repeated division by 10^9, collecting decimal digits from the least significant block
+        std::vector<std::uint32_t> n = limbs_;
+        std::vector<std::uint32_t> blocks;
+        while(!n.empty())
+        {
+            std::uint64_t rem = 0;
+            for(auto it = n.rbegin(); it != n.rend(); ++it)
+            {
+                const std::uint64_t cur = (rem << 32) | *it;
+                *it = std::uint32_t(cur / 1000000000);
+                rem = cur % 1000000000;
+            }
+            blocks.push_back(std::uint32_t(rem));
+            while(!n.empty() && n.back() == 0)
+                n.pop_back();
+        }
+        std::string s = std::to_string(blocks.back());
+        for(auto it = blocks.rbegin()+1; it != blocks.rend(); ++it)
+        {
+            const std::string block = std::to_string(*it);
+            s += std::string(9 - block.size(), '0') + block;
+        }
+        return s;
+    }
+
+}
@@ -1,5 +1,11 @@
 #include "bdd_collection.h"
+#include "bdd_mapped_collection.h"
+#include "bdd_linear_constraint.h"
+#include <fstream>
+#include <stdexcept>
+#include <cstring>
 #include <deque>
+#include <algorithm>
 #include <cassert>
 #include <unordered_set>
 #include <iostream> // TODO: remove
@@ -15,266 +21,138 @@ namespace BDD {
 
     size_t bdd_collection::bdd_and(const size_t i, const size_t j, const size_t node_limit)
     {
-        assert(i < nr_bdds());
-        assert(j < nr_bdds());
+        return bdd_apply<and_operator>(i, j, node_limit);
+    }
+
+    size_t bdd_collection::bdd_or(const size_t i, const size_t j, const size_t node_limit)
+    {
+        return bdd_apply<or_operator>(i, j, node_limit);
+    }
+
+    size_t bdd_collection::bdd_xor(const size_t i, const size_t j, const size_t node_limit)
+    {
+        return bdd_apply<xor_operator>(i, j, node_limit);
+    }
+
+    size_t bdd_collection::append_stack(const size_t root_idx)
+    {
+        if(root_idx == std::numeric_limits<size_t>::max())
+        {
+            last_result_ = result_kind::node_limit_exceeded;
+            return std::numeric_limits<size_t>::max();
+        }
+        // terminal roots are constant results
+        if(root_idx < 2)
+        {
+            last_result_ = root_idx == 0 ? result_kind::constant_false : result_kind::constant_true;
+            return std::numeric_limits<size_t>::max();
+        }
+        last_result_ = result_kind::bdd;
+        assert(stack.size() > 2);
+        assert(root_idx == stack.size()-1);
+        const size_t offset = bdd_delimiters.back();
+        for(ptrdiff_t s = stack.size()-1; s>=0; --s)
+        {
+            const bdd_instruction bdd_stack = stack[s];
+            const size_t lo = offset + stack.size() - bdd_stack.lo - 1;
+            const size_t hi = offset + stack.size() - bdd_stack.hi - 1;
+            bdd_instructions.push_back({lo, hi, stack[s].index});
+        }
+        bdd_delimiters.push_back(bdd_instructions.size());
+        assert(is_bdd(bdd_delimiters.size()-2));
+        return bdd_delimiters.size()-2;
+    }
+
+    size_t bdd_collection::bdd_and(std::vector<size_t> bdds, const size_t node_limit)
+    {
+        // a bdd given twice would be melded with itself
+        std::sort(bdds.begin(), bdds.end());
+        bdds.erase(std::unique(bdds.begin(), bdds.end()), bdds.end());
+        if(bdds.size() < 3)
+            return bdd_and(bdds.begin(), bdds.end(), node_limit);
+        for(const size_t bdd_nr : bdds)
+        {
+            assert(bdd_nr < nr_bdds());
+        }
         assert(stack.empty());
-        assert(generated_nodes.empty());
         assert(reduction.empty());
+        assert(meld_arena.empty());
+        assert(meld_tuples.empty());
         assert(node_limit > 2);
 
         // generate terminal vertices
         stack.push_back(bdd_instruction::botsink());
         stack.push_back(bdd_instruction::topsink());
-        const size_t root_idx = bdd_and_impl(bdd_delimiters[i], bdd_delimiters[j], node_limit);
+        for(const size_t bdd_nr : bdds)
+            meld_arena.push_back(bdd_delimiters[bdd_nr]);
+        const size_t bdd_nr = append_stack(bdd_and_impl(0, bdds.size(), node_limit));
 
-        if(root_idx != std::numeric_limits<size_t>::max())
-        {
-            assert(stack.size() > 2);
-            const size_t offset = bdd_delimiters.back();
-            for(ptrdiff_t s = stack.size()-1; s>=0; --s)
-            {
-                const bdd_instruction bdd_stack = stack[s];
-                const size_t lo = offset + stack.size() - bdd_stack.lo - 1;
-                const size_t hi = offset + stack.size() - bdd_stack.hi - 1;
-                bdd_instructions.push_back({lo, hi, stack[s].index});
-            }
-            bdd_delimiters.push_back(bdd_instructions.size());
-            assert(is_bdd(bdd_delimiters.size()-2));
-        }
-
-        generated_nodes.clear();
+        meld_arena.clear();
+        meld_tuples.clear();
         reduction.clear();
         stack.clear();
-        if(root_idx == std::numeric_limits<size_t>::max())
-            return std::numeric_limits<size_t>::max();
-        return bdd_delimiters.size()-2;
+        return bdd_nr;
     }
 
-    // given two bdd_instructions indices, compute new melded node, if it has not yet been created. Return index on stack.
-    size_t bdd_collection::bdd_and_impl(const size_t f_i, const size_t g_i, const size_t node_limit)
+    // Meld the tuple of non-terminal instructions at meld_arena[tuple_begin, tuple_begin + tuple_size). Return index on stack.
+    // Cofactor tuples are written behind the arena and kept if they are new, hence tuples of enclosing calls stay in place.
+    size_t bdd_collection::bdd_and_impl(const size_t tuple_begin, const size_t tuple_size, const size_t node_limit)
     {
-        // first, check whether node has been generated already
-        if(generated_nodes.count({f_i,g_i}) > 0)
-            return generated_nodes.find({f_i,g_i})->second;
-
-        const bdd_instruction& f = bdd_instructions[f_i];
-        const bdd_instruction& g = bdd_instructions[g_i];
-
-        // check if instructions are terminals
-        // TODO: more efficient
-        if(f.is_terminal() && g.is_terminal())
-            if(f.is_topsink() && g.is_topsink())
-                return 1; //topsink position on stack
-            else
-                return 0; //botsink position on stack
-        else if(f.is_terminal() && !g.is_terminal())
-            if(f.is_botsink())
-                return 0; //botsink position on stack
-            else if(!f.is_terminal() && g.is_terminal())
-                if(g.is_botsink())
-                    return 0; //botsink position on stack 
-
-        // compute lo and hi and see if they are present already. It not, add new branch instruction
-        const size_t v = std::min(f.index, g.index);
-        const size_t lo = bdd_and_impl(
-                v == f.index ? f.lo : f_i,
-                v == g.index ? g.lo : g_i,
-                node_limit
-                );
-        if(lo == std::numeric_limits<size_t>::max())
-            return std::numeric_limits<size_t>::max();
-        const size_t hi = bdd_and_impl(
-                v == f.index ? f.hi : f_i,
-                v == g.index ? g.hi : g_i,
-                node_limit
-                );
-        if(hi == std::numeric_limits<size_t>::max())
-            return std::numeric_limits<size_t>::max();
-
-        if(lo == hi)
-            return lo;
-
-        if(reduction.count({lo,hi,v}) > 0)
-            return reduction.find({lo,hi,v})->second;
+        size_t v = std::numeric_limits<size_t>::max();
+        for(size_t k=0; k<tuple_size; ++k)
+            v = std::min(v, bdd_instructions[meld_arena[tuple_begin + k]].index);
 
-        stack.push_back({lo, hi, v});
-        if(stack.size() > node_limit)
-            return std::numeric_limits<size_t>::max();
-        const size_t meld_idx = stack.size()-1;
-        generated_nodes.insert(std::make_pair(std::array<size_t,2>{f_i,g_i}, meld_idx));
-        reduction.insert(std::make_pair(bdd_instruction{lo,hi,v}, meld_idx));
-
-        return meld_idx;
-    }
-
-    template<size_t N>
-        size_t bdd_collection::bdd_and(const std::array<size_t,N>& bdds, const size_t node_limit)
-        {
-            for(const size_t bdd_nr : bdds)
-            {
-                assert(bdd_nr < nr_bdds());
-            }
-            assert(stack.empty());
-            assert(generated_nodes.empty());
-            assert(reduction.empty());
-            assert(node_limit > 2);
-
-            std::array<size_t,N> bdd_indices;
-            for(size_t i=0; i<N; ++i)
-                bdd_indices[i] = bdd_delimiters[bdds[i]];
-
-            // generate terminal vertices
-            stack.push_back(bdd_instruction::botsink());
-            stack.push_back(bdd_instruction::topsink());
-            std::unordered_map<std::array<size_t,N>,size_t,array_hasher<N>> generated_nodes;
-            const size_t root_idx = bdd_and_impl(bdd_indices, generated_nodes, node_limit);
-
-            if(root_idx != std::numeric_limits<size_t>::max())
+        auto cofactor = [&](const bool hi) -> size_t {
+            const size_t begin = meld_arena.size();
+            size_t hash = 14695981039346656037ULL;
+            for(size_t k=0; k<tuple_size; ++k)
             {
-                assert(stack.size() > 2);
-                const size_t offset = bdd_delimiters.back();
-                for(ptrdiff_t s = stack.size()-1; s>=0; --s)
+                const size_t f_idx = meld_arena[tuple_begin + k];
+                const bdd_instruction& f = bdd_instructions[f_idx];
+                const size_t g_idx = f.index != v ? f_idx : (hi ? f.hi : f.lo);
+                const bdd_instruction& g = bdd_instructions[g_idx];
+                if(g.is_botsink())
                 {
-                    const bdd_instruction bdd_stack = stack[s];
-                    const size_t lo = offset + stack.size() - bdd_stack.lo - 1;
-                    const size_t hi = offset + stack.size() - bdd_stack.hi - 1;
-                    bdd_instructions.push_back({lo, hi, stack[s].index});
+                    meld_arena.resize(begin);
+                    return 0;
                 }
-                bdd_delimiters.push_back(bdd_instructions.size());
-                assert(is_bdd(bdd_delimiters.size()-2));
+                if(g.is_topsink())
+                    continue;
+                meld_arena.push_back(g_idx);
+                hash = (hash ^ g_idx) * 1099511628211ULL;
             }
+            const meld_tuple t = {&meld_arena, begin, meld_arena.size() - begin, hash};
+            if(t.size == 0)
+                return 1;
+            if(const size_t* meld_idx = meld_tuples.find(t))
+            {
+                meld_arena.resize(begin);
+                return *meld_idx;
+            }
+            const size_t meld_idx = bdd_and_impl(begin, t.size, node_limit);
+            if(meld_idx != std::numeric_limits<size_t>::max())
+                meld_tuples.insert(t, meld_idx);
+            return meld_idx;
+        };
 
-            //generated_nodes.clear();
-            reduction.clear();
-            stack.clear();
-            if(root_idx == std::numeric_limits<size_t>::max())
-                return std::numeric_limits<size_t>::max();
-            return bdd_delimiters.size()-2;
-        }
-
-    // explicit instantiation of bdd_and
-    template size_t bdd_collection::bdd_and<3>(const std::array<size_t,3>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<4>(const std::array<size_t,4>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<5>(const std::array<size_t,5>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<6>(const std::array<size_t,6>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<7>(const std::array<size_t,7>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<8>(const std::array<size_t,8>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<9>(const std::array<size_t,9>& bdds, const size_t node_limit);
-
-    template size_t bdd_collection::bdd_and<10>(const std::array<size_t,10>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<11>(const std::array<size_t,11>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<12>(const std::array<size_t,12>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<13>(const std::array<size_t,13>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<14>(const std::array<size_t,14>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<15>(const std::array<size_t,15>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<16>(const std::array<size_t,16>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<17>(const std::array<size_t,17>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<18>(const std::array<size_t,18>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<19>(const std::array<size_t,19>& bdds, const size_t node_limit);
-
-    template size_t bdd_collection::bdd_and<20>(const std::array<size_t,20>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<21>(const std::array<size_t,21>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<22>(const std::array<size_t,22>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<23>(const std::array<size_t,23>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<24>(const std::array<size_t,24>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<25>(const std::array<size_t,25>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<26>(const std::array<size_t,26>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<27>(const std::array<size_t,27>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<28>(const std::array<size_t,28>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<29>(const std::array<size_t,29>& bdds, const size_t node_limit);
-
-    template size_t bdd_collection::bdd_and<30>(const std::array<size_t,30>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<31>(const std::array<size_t,31>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<32>(const std::array<size_t,32>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<33>(const std::array<size_t,33>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<34>(const std::array<size_t,34>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<35>(const std::array<size_t,35>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<36>(const std::array<size_t,36>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<37>(const std::array<size_t,37>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<38>(const std::array<size_t,38>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<39>(const std::array<size_t,39>& bdds, const size_t node_limit);
-
-    template size_t bdd_collection::bdd_and<40>(const std::array<size_t,40>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<41>(const std::array<size_t,41>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<42>(const std::array<size_t,42>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<43>(const std::array<size_t,43>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<44>(const std::array<size_t,44>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<45>(const std::array<size_t,45>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<46>(const std::array<size_t,46>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<47>(const std::array<size_t,47>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<48>(const std::array<size_t,48>& bdds, const size_t node_limit);
-    template size_t bdd_collection::bdd_and<49>(const std::array<size_t,49>& bdds, const size_t node_limit);
-
-    // given two bdd_instructions indices, compute new melded node, if it has not yet been created. Return index on stack.
-    template<size_t N>
-    size_t bdd_collection::bdd_and_impl(const std::array<size_t,N>& bdds, std::unordered_map<std::array<size_t,N>,size_t,array_hasher<N>>& generated_nodes, const size_t node_limit)
-    {
-        // first, check whether node has been generated already
-        if(generated_nodes.count(bdds) > 0)
-            return generated_nodes.find(bdds)->second;
-
-        std::array<bdd_instruction,N> bdd_instrs;
-        for(size_t i=0; i<N; ++i)
-            bdd_instrs[i] = bdd_instructions[bdds[i]];
-
-        // check if all instructions are true
-        const bool all_true_terminal = [&]() {
-            for(bdd_instruction& f : bdd_instrs)
-                if(!f.is_topsink())
-                    return false;
-            return true;
-        }();
-        if(all_true_terminal)
-            return 1;
-
-        const bool one_false_terminal = [&]() {
-            for(bdd_instruction& f : bdd_instrs)
-                if(f.is_botsink())
-                    return true;
-            return false; 
-        }();
-        if(one_false_terminal)
-            return 0;
-
-        const size_t v = [&]() {
-            size_t idx = std::numeric_limits<size_t>::max();
-            for(const bdd_instruction& f : bdd_instrs)
-                idx = std::min(idx, f.index);
-            return idx;
-        }();
-
-        std::array<size_t,N> lo_nodes;
-        for(size_t i=0; i<N; ++i)
-        {
-            const bdd_instruction& f = bdd_instrs[i];
-            lo_nodes[i] = f.index == v ? f.lo : bdds[i];
-        }
-        const size_t lo = bdd_and_impl(lo_nodes, generated_nodes, node_limit);
+        const size_t lo = cofactor(false);
         if(lo == std::numeric_limits<size_t>::max())
             return std::numeric_limits<size_t>::max();
-
-        std::array<size_t,N> hi_nodes;
-        for(size_t i=0; i<N; ++i)
-        {
-            const bdd_instruction& f = bdd_instrs[i];
-            hi_nodes[i] = f.index == v ? f.hi : bdds[i];
-        }
-        const size_t hi = bdd_and_impl(hi_nodes, generated_nodes, node_limit);
+        const size_t hi = cofactor(true);
         if(hi == std::numeric_limits<size_t>::max())
             return std::numeric_limits<size_t>::max();
 
         if(lo == hi)
             return lo;
 
-        if(reduction.count({lo,hi,v}) > 0)
-            return reduction.find({lo,hi,v})->second;
+        if(const size_t* reduced_idx = reduction.find({lo,hi,v}))
+            return *reduced_idx;
 
         stack.push_back({lo, hi, v});
         if(stack.size() > node_limit)
             return std::numeric_limits<size_t>::max();
         const size_t meld_idx = stack.size()-1;
-        generated_nodes.insert(std::make_pair(bdds, meld_idx));
-        reduction.insert(std::make_pair(bdd_instruction{lo,hi,v}, meld_idx));
+        reduction.insert({lo,hi,v}, meld_idx);
 
         return meld_idx;
     }
@@ -282,111 +160,166 @@ namespace BDD {
     size_t bdd_collection::add_bdd(node_ref root)
     {
         assert(bdd_delimiters.back() == bdd_instructions.size());
-
-        auto nodes = root.nodes_postorder();
-        std::reverse(nodes.begin(), nodes.end());
-        for(size_t i=0; i<nodes.size(); ++i)
+        assert(!root.is_terminal());
+        assert(import_nodes.empty() && import_stack.empty());
+
+        // The postorder position of each visited node is stored in its depth field, which is recomputed from the children afterwards.
+        // Compact nodes have too few depth bits, their positions go to a hash map.
+#ifdef LBDD_COMPACT_NODES
+        auto set_position = [&](node* p, const size_t pos) { import_positions.insert(p, pos); };
+        auto position = [&](node* p) { return *import_positions.find(p); };
+#else
+        auto set_position = [](node* p, const size_t pos) { assert(pos <= max_node_depth); p->depth_ = pos; };
+        auto position = [](node* p) -> size_t { return p->depth_; };
+#endif
+
+        // iterative depth first search, a node is finished once both children are
+        auto visit = [&](node* p) {
+            if(p->is_terminal() || p->marked_)
+                return false;
+            p->marked_ = 1;
+            import_stack.push_back(p);
+            return true;
+        };
+        visit(root.address());
+        while(!import_stack.empty())
         {
-            assert(!nodes[i].is_terminal());
-            node_ref_hash.insert({nodes[i], bdd_instructions.size()});
-            bdd_instructions.push_back(bdd_instruction{std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max(), nodes[i].variable()});
+            node* p = import_stack.back();
+            if(visit(p->lo) || visit(p->hi))
+                continue;
+            import_stack.pop_back();
+            set_position(p, import_nodes.size());
+            import_nodes.push_back(p);
         }
 
-        // TODO: not most efficient, record top and botsink above
-        node_ref_hash.insert({nodes.back().botsink(), bdd_instructions.size()});
-        bdd_instructions.push_back(bdd_instruction::botsink());
-        assert(bdd_instructions.back().is_botsink());
-
-        node_ref_hash.insert({nodes.back().topsink(), bdd_instructions.size()});
-        bdd_instructions.push_back(bdd_instruction::topsink());
-        assert(bdd_instructions.back().is_topsink());
-
-        const size_t offset = bdd_delimiters.back();
-        for(size_t i=0; i<nodes.size(); ++i)
+        // instructions in reverse postorder, followed by botsink and topsink. Nodes are kept by level, instructions hold their variables
+        const size_t offset = bdd_instructions.size();
+        const size_t n = import_nodes.size();
+        const bdd_mgr& mgr = *root.address()->find_bdd_mgr();
+        const bool reordered = mgr.variables_reordered();
+        auto instruction_index = [&](node* p) -> size_t {
+            if(p->is_botsink())
+                return offset + n;
+            if(p->is_topsink())
+                return offset + n + 1;
+            return offset + n - 1 - position(p);
+        };
+        bdd_instructions.resize(offset + n + 2);
+        for(size_t pos=0; pos<n; ++pos)
         {
-            assert(node_ref_hash.count(nodes[i].low()) > 0);
-            assert(node_ref_hash.count(nodes[i].high()) > 0);
-            assert(i < node_ref_hash.find(nodes[i].low())->second);
-            assert(i < node_ref_hash.find(nodes[i].high())->second);
-            bdd_instructions[offset + i].lo = node_ref_hash.find(nodes[i].low())->second;
-            bdd_instructions[offset + i].hi = node_ref_hash.find(nodes[i].high())->second;
+            node* p = import_nodes[pos];
+            bdd_instructions[offset + n - 1 - pos] = bdd_instruction{instruction_index(p->lo), instruction_index(p->hi), reordered ? mgr.variable(p->index) : p->index};
         }
-
+        bdd_instructions[offset + n] = bdd_instruction::botsink();
+        bdd_instructions[offset + n + 1] = bdd_instruction::topsink();
         bdd_delimiters.push_back(bdd_instructions.size());
 
-        // clean-up
-        node_ref_hash.clear();
+        // clean-up. In postorder the depths of the children are restored before those of their parents
+        for(node* p : import_nodes)
+        {
+            p->marked_ = 0;
+#ifndef LBDD_COMPACT_NODES
+            const std::size_t max_depth = std::max(p->lo->depth(), p->hi->depth());
+            p->depth_ = max_depth == max_node_depth ? max_depth : max_depth + 1;
+#endif
+        }
+#ifdef LBDD_COMPACT_NODES
+        import_positions.clear();
+#endif
+        import_nodes.clear();
+
         assert(is_bdd(bdd_delimiters.size()-2));
-        assert(nr_bdd_nodes(bdd_delimiters.size()-2) == nodes.size()+2);
+        assert(nr_bdd_nodes(bdd_delimiters.size()-2) == n+2);
         return bdd_delimiters.size()-2;
     }
 
-    node_ref bdd_collection::export_bdd(bdd_mgr& mgr, const size_t bdd_nr) const
+    size_t bdd_collection::add_linear_constraint(std::vector<std::pair<size_t,std::int64_t>>& terms, std::int64_t bound, const bool equality)
     {
-        assert(bdd_nr < nr_bdds());
-        assert(nr_bdd_nodes(bdd_nr) > 2);
-        // TODO: use vector and shift indices by offset
-        std::unordered_map<size_t, node_ref> bdd_instr_hash;
-        assert(bdd_instructions[bdd_delimiters[bdd_nr+1]-2].is_terminal());
-        assert(bdd_instructions[bdd_delimiters[bdd_nr+1]-1].is_terminal());
-        for(ptrdiff_t i=bdd_delimiters[bdd_nr+1]-3; i>=ptrdiff_t(bdd_delimiters[bdd_nr]); --i)
+        assert(bdd_delimiters.back() == bdd_instructions.size());
+        // merge repeated variables, then bring negative coefficients to positive ones by a*x = -a*(not x) + a
+        std::sort(terms.begin(), terms.end());
+        std::vector<size_t> variables;
+        std::vector<bool> positive;
+        std::vector<std::int64_t> coefficients;
+        for(size_t i=0; i<terms.size();)
         {
-            const bdd_instruction& bdd_instr = bdd_instructions[i];
-            assert(!bdd_instr.is_terminal());
-            auto get_node_ref = [&](const size_t i) -> node_ref {
-                assert(i < bdd_instructions.size());
-
-                if(bdd_instructions[i].is_botsink())
-                {
-                    return mgr.botsink();
-                }
-
-                if(bdd_instructions[i].is_topsink())
-                {
-                    return mgr.topsink();
-                }
+            const size_t var = terms[i].first;
+            std::int64_t a = 0;
+            for(; i<terms.size() && terms[i].first == var; ++i)
+                a += terms[i].second;
+            if(a == 0)
+                continue;
+            variables.push_back(var);
+            positive.push_back(a > 0);
+            coefficients.push_back(a > 0 ? a : -a);
+            if(a < 0)
+                bound -= a;
+        }
 
-                assert(i >= bdd_delimiters[bdd_nr]);
-                assert(i < bdd_delimiters[bdd_nr+1]);
-                assert(bdd_instr_hash.count(i) > 0);
-                return bdd_instr_hash.find(i)->second;
-            };
-
-            node_ref lo = get_node_ref(bdd_instr.lo);
-            node_ref hi = get_node_ref(bdd_instr.hi);
-            node_ref bdd = mgr.unique_find(bdd_instr.index, lo, hi);
-            assert(bdd_instr_hash.count(i) == 0);
-            bdd_instr_hash.insert({i, bdd});
+        detail::linear_constraint_compiler compiler;
+        const size_t root = equality ? compiler.compile_equal(coefficients, bound) : compiler.compile_at_most(coefficients, bound);
+        if(root == detail::linear_constraint_compiler::botsink || root == detail::linear_constraint_compiler::topsink)
+        {
+            last_result_ = root == detail::linear_constraint_compiler::botsink ? result_kind::constant_false : result_kind::constant_true;
+            return std::numeric_limits<size_t>::max();
+        }
+        last_result_ = result_kind::bdd;
+
+        // the compiler numbers children before parents and the root last, instructions come in reverse, followed by botsink and topsink
+        const auto& nodes = compiler.nodes();
+        const size_t n = nodes.size();
+        assert(root == n + 1);
+        const size_t offset = bdd_instructions.size();
+        auto instruction_index = [&](const size_t i) -> size_t {
+            if(i == detail::linear_constraint_compiler::botsink)
+                return offset + n;
+            if(i == detail::linear_constraint_compiler::topsink)
+                return offset + n + 1;
+            return offset + n + 1 - i;
+        };
+        bdd_instructions.resize(offset + n + 2);
+        for(size_t i=0; i<n; ++i)
+        {
+            const size_t l = nodes[i].literal;
+            const size_t false_child = instruction_index(nodes[i].false_child);
+            const size_t true_child = instruction_index(nodes[i].true_child);
+            bdd_instructions[instruction_index(i+2)] = positive[l]
+                ? bdd_instruction{false_child, true_child, variables[l]}
+                : bdd_instruction{true_child, false_child, variables[l]};
         }
-        assert(bdd_instr_hash.count(bdd_delimiters[bdd_nr]) > 0);
-        return bdd_instr_hash.find(bdd_delimiters[bdd_nr])->second;
+        bdd_instructions[offset + n] = bdd_instruction::botsink();
+        bdd_instructions[offset + n + 1] = bdd_instruction::topsink();
+        bdd_delimiters.push_back(bdd_instructions.size());
+
+        assert(is_bdd(nr_bdds()-1));
+        return nr_bdds()-1;
     }
 
-    size_t bdd_collection::add_bdd_impl(node_ref bdd)
-    {
-        if(node_ref_hash.count(bdd) > 0)
-            return node_ref_hash.find(bdd)->second;
+    namespace detail {
 
-        const size_t bdd_idx = bdd_instructions.size();
-        bdd_instructions.push_back(bdd_instruction{std::numeric_limits<size_t>::max(), std::numeric_limits<size_t>::max(), bdd.variable()});
-        node_ref_hash.insert({bdd, bdd_idx});
-        if(!bdd.is_terminal())
+        std::vector<size_t> instruction_variables(const bdd_instruction* instructions, const size_t begin, const size_t end)
         {
-            const size_t lo_idx = add_bdd_impl(bdd.low());
-            const size_t hi_idx = add_bdd_impl(bdd.high());
-            assert(lo_idx != hi_idx); 
-            bdd_instructions[bdd_idx].lo = lo_idx;
-            bdd_instructions[bdd_idx].hi = hi_idx;
-        }
-        else if(bdd.is_botsink())
-            bdd_instructions[bdd_idx] = bdd_instruction::botsink();
-        else    
-        {
-            assert(bdd.is_topsink());
-            bdd_instructions[bdd_idx] = bdd_instruction::topsink();
+            std::vector<size_t> vars;
+            for(size_t i=begin; i<end-2; ++i)
+            {
+                if(vars.size() > 0 && instructions[i].index == vars.back())
+                    continue;
+                vars.push_back(instructions[i].index);
+            }
+
+            assert(vars.size() > 0);
+            std::sort(vars.begin(), vars.end());
+            vars.erase( std::unique(vars.begin(), vars.end() ), vars.end());
+            return vars;
         }
 
-        return bdd_idx;
+    }
+
+    node_ref bdd_collection::export_bdd(bdd_mgr& mgr, const size_t bdd_nr) const
+    {
+        assert(bdd_nr < nr_bdds());
+        assert(nr_bdd_nodes(bdd_nr) > 2);
+        return mgr.add_bdd(bdd_instructions.data(), bdd_delimiters[bdd_nr], bdd_delimiters[bdd_nr+1]);
     }
 
     size_t bdd_collection::nr_bdd_nodes(const size_t i) const
@@ -405,6 +338,30 @@ namespace BDD {
         return nr_occurrences;
     }
 
+    template<typename COUNT>
+        COUNT bdd_collection::model_count(const size_t bdd_nr, const size_t nr_vars) const
+        {
+            assert(bdd_nr < nr_bdds());
+            const detail::instruction_count_view view{&bdd_instructions[bdd_delimiters[bdd_nr]], &bdd_instructions[0] + bdd_delimiters[bdd_nr+1], bdd_delimiters[bdd_nr]};
+            return detail::model_count<COUNT>(view, nr_vars);
+        }
+
+    template<typename COUNT>
+        std::vector<COUNT> bdd_collection::positive_counts(const size_t bdd_nr, const size_t nr_vars) const
+        {
+            assert(bdd_nr < nr_bdds());
+            const detail::instruction_count_view view{&bdd_instructions[bdd_delimiters[bdd_nr]], &bdd_instructions[0] + bdd_delimiters[bdd_nr+1], bdd_delimiters[bdd_nr]};
+            return detail::positive_counts<COUNT>(view, nr_vars);
+        }
+
+    // explicit instantiation of model counting
+    template double bdd_collection::model_count<double>(const size_t bdd_nr, const size_t nr_vars) const;
+    template log2_count bdd_collection::model_count<log2_count>(const size_t bdd_nr, const size_t nr_vars) const;
+    template big_uint bdd_collection::model_count<big_uint>(const size_t bdd_nr, const size_t nr_vars) const;
+    template std::vector<double> bdd_collection::positive_counts<double>(const size_t bdd_nr, const size_t nr_vars) const;
+    template std::vector<log2_count> bdd_collection::positive_counts<log2_count>(const size_t bdd_nr, const size_t nr_vars) const;
+    template std::vector<big_uint> bdd_collection::positive_counts<big_uint>(const size_t bdd_nr, const size_t nr_vars) const;
+
     bool bdd_collection::is_bdd(const size_t bdd_nr) const
     {
         assert(bdd_nr < nr_bdds());
@@ -527,18 +484,27 @@ namespace BDD {
     std::vector<size_t> bdd_collection::variables(const size_t bdd_nr) const
     {
         assert(bdd_nr < nr_bdds());
-        std::vector<size_t> vars;
-        for(size_t i=bdd_delimiters[bdd_nr]; i<bdd_delimiters[bdd_nr+1]-2; ++i)
-        {
-            if(vars.size() > 0 && bdd_instructions[i].index == vars.back())
-                continue;
-            vars.push_back(bdd_instructions[i].index);
-        }
-
-        assert(vars.size() > 0);
-        std::sort(vars.begin(), vars.end());
-        vars.erase( std::unique(vars.begin(), vars.end() ), vars.end());
-        return vars;
+        return detail::instruction_variables(bdd_instructions.data(), bdd_delimiters[bdd_nr], bdd_delimiters[bdd_nr+1]);
+    }
+
+    void bdd_collection::save(const std::string& filename) const
+    {
+        std::ofstream f(filename, std::ios::binary | std::ios::trunc);
+        if(!f)
+            throw std::runtime_error("cannot open bdd collection file " + filename);
+        bdd_collection_file_header header;
+        std::memcpy(header.magic, bdd_collection_file_header::file_magic, sizeof(header.magic));
+        header.version = bdd_collection_file_header::current_version;
+        header.byte_order = bdd_collection_file_header::byte_order_mark;
+        header.word_size = sizeof(size_t);
+        header.instruction_size = sizeof(bdd_instruction);
+        header.nr_bdds = nr_bdds();
+        header.nr_instructions = bdd_delimiters.back();
+        f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        f.write(reinterpret_cast<const char*>(bdd_delimiters.data()), bdd_delimiters.size() * sizeof(size_t));
+        f.write(reinterpret_cast<const char*>(bdd_instructions.data()), bdd_delimiters.back() * sizeof(bdd_instruction));
+        if(!f.flush())
+            throw std::runtime_error("cannot write bdd collection file " + filename);
     }
 
     bdd_collection_entry bdd_collection::operator[](const size_t bdd_nr)
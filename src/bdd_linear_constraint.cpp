@@ -0,0 +1,90 @@
+#include "bdd_linear_constraint.h"
+#include <limits>
+#include <algorithm>
+#include <cassert>
+
+namespace BDD {
+
+    namespace detail {
+
+        constexpr static std::int64_t minus_infinity = std::numeric_limits<std::int64_t>::min();
+        constexpr static std::int64_t plus_infinity = std::numeric_limits<std::int64_t>::max();
+
+        void linear_constraint_compiler::init(const std::vector<std::int64_t>& coefficients)
+        {
+            assert(std::all_of(coefficients.begin(), coefficients.end(), [](const std::int64_t a) { return a > 0; }));
+            coefficients_ = coefficients;
+            suffix_sums_.assign(coefficients.size()+1, 0);
+            for(size_t i=coefficients.size(); i-- > 0;)
+                suffix_sums_[i] = suffix_sums_[i+1] + coefficients[i];
+            memo_.clear();
+            memo_.resize(coefficients.size());
+            nodes_.clear();
+        }
+
+        size_t linear_constraint_compiler::make_node(const size_t i, const size_t false_child, const size_t true_child)
+        {
+            if(false_child == true_child)
+                return false_child;
+            nodes_.push_back({i, false_child, true_child});
+            return nodes_.size() + 1;
+        }
+
+        size_t linear_constraint_compiler::compile_at_most(const std::vector<std::int64_t>& coefficients, const std::int64_t bound)
+        {
+            init(coefficients);
+            return at_most(0, bound).node;
+        }
+
+        size_t linear_constraint_compiler::compile_equal(const std::vector<std::int64_t>& coefficients, const std::int64_t bound)
+        {
+            init(coefficients);
+            return equal(0, bound).node;
+        }
+
+        // the returned interval holds all bounds for which the constraint on literals i,... is the returned node
+        linear_constraint_compiler::interval linear_constraint_compiler::at_most(const size_t i, const std::int64_t bound)
+        {
+            if(bound < 0)
+                return {minus_infinity, -1, botsink};
+            if(suffix_sums_[i] <= bound)
+                return {suffix_sums_[i], plus_infinity, topsink};
+
+            auto it = memo_[i].upper_bound(bound);
+            if(it != memo_[i].begin() && bound <= std::prev(it)->second.upper)
+                return std::prev(it)->second;
+
+            const std::int64_t a = coefficients_[i];
+            const interval f = at_most(i+1, bound);
+            const interval t = at_most(i+1, bound - a);
+            interval r;
+            r.lower = std::max(f.lower, t.lower == minus_infinity ? minus_infinity : t.lower + a);
+            r.upper = std::min(f.upper, t.upper == plus_infinity ? plus_infinity : t.upper + a);
+            r.node = make_node(i, f.node, t.node);
+            assert(r.lower <= bound && bound <= r.upper);
+            memo_[i].insert({r.lower, r});
+            return r;
+        }
+
+        // bounds with the same satisfiable constraint coincide, so only equal bounds are memoized
+        linear_constraint_compiler::interval linear_constraint_compiler::equal(const size_t i, const std::int64_t bound)
+        {
+            if(bound < 0 || bound > suffix_sums_[i])
+                return {bound, bound, botsink};
+            if(i == coefficients_.size())
+                return {bound, bound, topsink};
+
+            auto it = memo_[i].find(bound);
+            if(it != memo_[i].end())
+                return it->second;
+
+            const interval f = equal(i+1, bound);
+            const interval t = equal(i+1, bound - coefficients_[i]);
+            const interval r = {bound, bound, make_node(i, f.node, t.node)};
+            memo_[i].insert({bound, r});
+            return r;
+        }
+
+    }
+
+}
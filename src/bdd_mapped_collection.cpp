@@ -0,0 +1,136 @@
+#include "bdd_mapped_collection.h"
+#include <stdexcept>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace BDD {
+
+    mapped_bdd_collection::mapped_bdd_collection(const std::string& filename)
+    {
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if(fd < 0)
+            throw std::runtime_error("cannot open bdd collection file " + filename);
+        struct stat st;
+        if(fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(bdd_collection_file_header))
+        {
+            close(fd);
+            throw std::runtime_error("bdd collection file " + filename + " is too short");
+        }
+        data_size_ = st.st_size;
+        data_ = mmap(nullptr, data_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // the mapping stays valid
+        if(data_ == MAP_FAILED)
+        {
+            data_ = nullptr;
+            throw std::runtime_error("cannot map bdd collection file " + filename);
+        }
+
+        auto fail = [&](const std::string& reason) {
+            unmap();
+            throw std::runtime_error("bdd collection file " + filename + ": " + reason);
+        };
+
+        const bdd_collection_file_header& header = *static_cast<const bdd_collection_file_header*>(data_);
+        if(std::memcmp(header.magic, bdd_collection_file_header::file_magic, sizeof(header.magic)) != 0)
+            fail("not a bdd collection");
+        if(header.version != bdd_collection_file_header::current_version)
+            fail("unsupported version " + std::to_string(header.version));
+        if(header.byte_order != bdd_collection_file_header::byte_order_mark)
+            fail("written with other byte order");
+        if(header.word_size != sizeof(size_t) || header.instruction_size != sizeof(bdd_instruction))
+            fail("written with other word size");
+        const size_t max_entries = data_size_ / sizeof(size_t);
+        if(header.nr_bdds >= max_entries || header.nr_instructions >= max_entries
+                || data_size_ != sizeof(bdd_collection_file_header) + (header.nr_bdds+1) * sizeof(size_t) + header.nr_instructions * sizeof(bdd_instruction))
+            fail("size does not match header");
+
+        nr_bdds_ = header.nr_bdds;
+        delimiters_ = reinterpret_cast<const size_t*>(static_cast<const char*>(data_) + sizeof(bdd_collection_file_header));
+        instructions_ = reinterpret_cast<const bdd_instruction*>(delimiters_ + nr_bdds_ + 1);
+        if(delimiters_[0] != 0 || delimiters_[nr_bdds_] != header.nr_instructions)
+            fail("delimiters do not match header");
+
+        // one pass over delimiters and instructions, so that no accessor can leave the mapping: every bdd is non-empty and its arcs point forward into it
+        for(size_t bdd_nr=0; bdd_nr<nr_bdds_; ++bdd_nr)
+        {
+            const size_t begin = delimiters_[bdd_nr];
+            const size_t end = delimiters_[bdd_nr+1];
+            if(end <= begin || end > header.nr_instructions)
+                fail("delimiters of bdd " + std::to_string(bdd_nr) + " out of order");
+            for(size_t i=begin; i<end; ++i)
+            {
+                const bdd_instruction& instr = instructions_[i];
+                if(instr.is_terminal() ? !(instr.is_botsink() || instr.is_topsink()) : (instr.lo <= i || instr.lo >= end || instr.hi <= i || instr.hi >= end))
+                    fail("instruction " + std::to_string(i) + " of bdd " + std::to_string(bdd_nr) + " has invalid arcs");
+            }
+        }
+    }
+
+    mapped_bdd_collection::~mapped_bdd_collection()
+    {
+        unmap();
+    }
+
+    mapped_bdd_collection::mapped_bdd_collection(mapped_bdd_collection&& o)
+    {
+        *this = std::move(o);
+    }
+
+    mapped_bdd_collection& mapped_bdd_collection::operator=(mapped_bdd_collection&& o)
+    {
+        if(this != &o)
+        {
+            unmap();
+            std::swap(data_, o.data_);
+            std::swap(data_size_, o.data_size_);
+            std::swap(nr_bdds_, o.nr_bdds_);
+            std::swap(delimiters_, o.delimiters_);
+            std::swap(instructions_, o.instructions_);
+        }
+        return *this;
+    }
+
+    void mapped_bdd_collection::unmap()
+    {
+        if(data_ != nullptr)
+            munmap(data_, data_size_);
+        data_ = nullptr;
+        data_size_ = 0;
+        nr_bdds_ = 0;
+        delimiters_ = nullptr;
+        instructions_ = nullptr;
+    }
+
+    size_t mapped_bdd_collection::nr_bdd_nodes(const size_t bdd_nr, const size_t variable) const
+    {
+        assert(bdd_nr < nr_bdds());
+        size_t nr_occurrences = 0;
+        for(size_t i=delimiters_[bdd_nr]; i<delimiters_[bdd_nr+1]; ++i)
+            if(instructions_[i].index == variable)
+                ++nr_occurrences;
+        return nr_occurrences;
+    }
+
+    std::vector<size_t> mapped_bdd_collection::variables(const size_t bdd_nr) const
+    {
+        assert(bdd_nr < nr_bdds());
+        return detail::instruction_variables(instructions_, delimiters_[bdd_nr], delimiters_[bdd_nr+1]);
+    }
+
+    node_ref mapped_bdd_collection::export_bdd(bdd_mgr& mgr, const size_t bdd_nr) const
+    {
+        assert(bdd_nr < nr_bdds());
+        assert(nr_bdd_nodes(bdd_nr) > 2);
+        return mgr.add_bdd(instructions_, delimiters_[bdd_nr], delimiters_[bdd_nr+1]);
+    }
+
+    detail::instruction_count_view mapped_bdd_collection::count_view(const size_t bdd_nr) const
+    {
+        assert(bdd_nr < nr_bdds());
+        return {instructions_ + delimiters_[bdd_nr], instructions_ + delimiters_[bdd_nr+1], delimiters_[bdd_nr]};
+    }
+
+}
@@ -1,7 +1,6 @@
 #include "bdd_memo_cache.h"
 #include <cassert>
 #include <algorithm>
-#include <iostream> // TODO: delete
 
 namespace BDD {
 
@@ -15,196 +14,237 @@ namespace BDD {
         return !(*this == m);
     }
 
-    memo_cache::memo_cache(bdd_node_cache& _node_cache)
-        : node_cache(_node_cache)
+    memo_operation_statistics memo_cache_statistics::total() const
     {
-        init_cache();
+        memo_operation_statistics t;
+        for(const auto& o : ops)
+        {
+            t.hits += o.hits;
+            t.misses += o.misses;
+            t.inserts += o.inserts;
+            t.evictions += o.evictions;
+        }
+        return t;
     }
 
-    size_t memo_cache::cache_hash(node* f, node* g, node* h)
+    memo_cache::memo_cache(bdd_node_cache& _node_cache, const size_t memory_budget)
+        : memory_budget_(memory_budget),
+        node_cache(_node_cache)
     {
-        //const std::size_t f_hash = f->index;
-        //const std::size_t g_hash = (h == nullptr) ? (g->index << 1) : (reinterpret_cast<size_t>(g) << 1);
-        //const std::size_t h_hash = reinterpret_cast<size_t>(h) << 2;
+        resize(1);
+    }
 
-        const size_t f_hash = f->hash_key;
+    size_t memo_cache::cache_hash(node* f, node* g, node* h)
+    {
+        const size_t f_hash = f->hash_key();
         assert(g != nullptr);
-        const size_t g_hash = g->hash_key << 1;
+        const size_t g_hash = g->hash_key() << 1;
         const size_t h_hash = reinterpret_cast<size_t>(h) << 2;
 
         size_t hash = f_hash;
         hash ^= g_hash + 0x9e3779b9 + (hash << 6) + (hash >> 2);
         hash ^= h_hash + 0x9e3779b9 + (hash << 6) + (hash >> 2);
-        //return f_hash ^ g_hash ^ h_hash; 
         return hash;
     }
 
-    memo_struct& memo_cache::get_memo(const size_t slot)
+    memo_cache::memo_set& memo_cache::get_set(const size_t hash)
     {
-        assert(memos_mask + 1 == memos.size());
-        const size_t n = slot & memos_mask;
-        assert(n < memos.size());
-        //std::cout << "memo slot = " << n << ", memos size = " << memos.size() << ", cache mask = " << memos_mask << "\n";
-        return memos[n];
+        assert(sets_mask + 1 == sets.size());
+        return sets[hash & sets_mask];
     }
 
-    node* memo_cache::cache_lookup(node* f, node* g, node* h)
+#ifdef LBDD_CONCURRENT
+    std::mutex& memo_cache::set_mutex(const size_t hash)
     {
-        /*
-        if(memos2.count({f,g,h}) == 0)
-            return nullptr;
+        // hashes sharing a set must share a lock
+        return set_mutexes[(hash & sets_mask) % set_mutexes.size()];
+    }
+#endif
 
-        auto it = memos2.find({f,g,h})->second;
-        std::get<1>(it->second)++;
-        node* r = std::get<0>(it->second);
-        if(cache_inserts++ > threshold)
-        {
-            cache_inserts = 0;
-            for(auto [k, v] : memos)
-            {
-                const size_t ts = std::get<1>(v);
+    memo_cache_statistics::operation memo_cache::operation(node* h)
+    {
+        if(memo_struct::is_and_exists_key(h))
+            return memo_cache_statistics::operation::and_exists_op;
+        if(!memo_struct::is_operation_symbol(h))
+            return memo_cache_statistics::operation::ite_op;
+        switch(memo_struct::operation(h)) {
+            case memo_operation::and_op: return memo_cache_statistics::operation::and_op;
+            case memo_operation::or_op: return memo_cache_statistics::operation::or_op;
+            case memo_operation::xor_op: return memo_cache_statistics::operation::xor_op;
+            case memo_operation::exists_op: return memo_cache_statistics::operation::exists_op;
+            case memo_operation::forall_op: return memo_cache_statistics::operation::forall_op;
+            case memo_operation::nand_op: return memo_cache_statistics::operation::nand_op;
+            case memo_operation::implies_op: return memo_cache_statistics::operation::implies_op;
+            case memo_operation::diff_op: return memo_cache_statistics::operation::diff_op;
+            case memo_operation::equiv_op: return memo_cache_statistics::operation::equiv_op;
+        }
+        assert(false);
+        return memo_cache_statistics::operation::ite_op;
+    }
 
-            }
+    void memo_cache::count(size_t& counter)
+    {
+#ifdef LBDD_CONCURRENT
+        __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED);
+#else
+        ++counter;
+#endif
+    }
 
-        }
-        return r;
-        */
-        ////////
-
-        const size_t slot = cache_hash(f,g,h);
-        const memo_struct& m = get_memo(slot); 
-        if(m.r == nullptr)
-            return nullptr;
-        if(m.f == f && m.g == g && m.h == h) 
+    node* memo_cache::cache_lookup(node* f, node* g, node* h)
+    {
+        const size_t hash = cache_hash(f,g,h);
+        memo_operation_statistics& stats = statistics_.ops[size_t(operation(h))];
+#ifdef LBDD_CONCURRENT
+        std::shared_lock<std::shared_mutex> resize_lock(resize_mutex);
+        std::lock_guard<std::mutex> set_lock(set_mutex(hash));
+#endif
+        memo_set& s = get_set(hash);
+        for(size_t i=0; i<memo_cache_ways && s[i].r != nullptr; ++i)
         {
-            assert(m.r != nullptr);
-            if(m.r->xref < 0)
+            if(s[i].f == f && s[i].g == g && s[i].h == h) 
             {
-                assert(false);
-                m.r->recursively_revive();
-                return m.r;
+                node* r = s[i].r;
+                // result reclaimed by an ongoing incremental garbage collection
+                if(r->is_retired())
+                    break;
+                assert(r->reference_count() >= 0);
+                // make youngest
+                std::rotate(s.begin(), s.begin() + i, s.begin() + i + 1);
+                count(stats.hits);
+                return r;
             }
-            //m.r->xref++;
-            return m.r;
         }
+        count(stats.misses);
         return nullptr;
     }
 
     void memo_cache::cache_insert(node* f, node* g, node* h, node* r)
     {
-        //memos2.insert(std::make_pair(std::array<node*,3>({f,g,h}),{r,insert_time_stamp++}));
-        //return;
-        ////////
-
-        const size_t slot = cache_hash(f,g,h);
-        if(++cache_inserts >= threshold)
+        assert(r != nullptr);
+        const size_t hash = cache_hash(f,g,h);
+        memo_operation_statistics& stats = statistics_.ops[size_t(operation(h))];
+        count(stats.inserts);
+
+#ifdef LBDD_CONCURRENT
+        std::shared_lock<std::shared_mutex> resize_lock(resize_mutex);
+        if(__atomic_add_fetch(&cache_inserts, 1, __ATOMIC_RELAXED) >= sets.size() * memo_cache_ways && sets.size() < max_nr_sets())
+        {
+            resize_lock.unlock();
+            {
+                std::unique_lock<std::shared_mutex> exclusive_lock(resize_mutex);
+                if(cache_inserts >= sets.size() * memo_cache_ways && sets.size() < max_nr_sets())
+                    double_cache();
+            }
+            resize_lock.lock();
+        }
+        std::lock_guard<std::mutex> set_lock(set_mutex(hash));
+#else
+        if(++cache_inserts >= sets.size() * memo_cache_ways && sets.size() < max_nr_sets())
             double_cache();
-        memo_struct& m = get_memo(cache_hash(f,g,h));
-        m.f = f;
-        m.g = g;
-        m.h = h;
-        m.r = r;
+#endif
+
+        memo_set& s = get_set(hash);
+        size_t i = 0;
+        for(; i+1<memo_cache_ways && s[i].r != nullptr; ++i)
+            if(s[i].f == f && s[i].g == g && s[i].h == h)
+                break;
+        // i is now the matching memo, the first empty one or the oldest one
+        if(s[i].r != nullptr && !(s[i].f == f && s[i].g == g && s[i].h == h))
+            count(stats.evictions);
+        std::rotate(s.begin(), s.begin() + i, s.begin() + i + 1);
+        s[0] = memo_struct{f, g, h, r};
     }
 
-    void memo_cache::init_cache()
+    size_t memo_cache::max_nr_sets() const
     {
-        assert(memos.size() == 0);
-        memos.resize(1);
-        memos_mask = 0;
+        size_t n = 1;
+        while(2 * n * sizeof(memo_set) <= memory_budget_)
+            n *= 2;
+        return n;
     }
 
     void memo_cache::double_cache()
     {
-        //std::cout << "double cache size\n";
-        if(memos.size() >= 2<<21)
-            return;
+        resize(2 * sets.size());
+    }
+
+    void memo_cache::resize(const size_t new_nr_sets)
+    {
+        assert(new_nr_sets > 0 && (new_nr_sets & (new_nr_sets-1)) == 0);
+        std::vector<memo_set> old_sets(new_nr_sets);
+        std::swap(old_sets, sets);
+        sets_mask = new_nr_sets - 1;
         cache_inserts = 0;
-        threshold = 1 + memos.size();
-        assert(memos.size() > 0);
-        memos.resize(2 * memos.size());
-        memos_mask = memos.size()-1;
-        //std::cout << "new cache size = " << memos.size() << "\n";
-
-        // rehash items on bottom half
-        size_t occupied_slots = 0;
-        for(size_t k = 0; k < memos.size()/2; ++k)
+        statistics_.nr_slots = new_nr_sets * memo_cache_ways;
+
+        // reinsert from oldest to youngest, so that age order is preserved. When shrinking, the oldest memos are dropped.
+        for(const memo_set& old_set : old_sets)
         {
-            memo& m = memos[k];
-            if(m.r != nullptr)
+            for(size_t i=memo_cache_ways; i>0; --i)
             {
-                ++occupied_slots;
-                memo& mm = get_memo(cache_hash(m.f, m.g, m.h));
-                if(mm != m)
-                {
-                    mm = m;
-                    m.r = nullptr;
-                } 
-            } 
-        } 
-        cache_inserts = occupied_slots;
+                const memo_struct& m = old_set[i-1];
+                if(m.r == nullptr)
+                    continue;
+                memo_set& s = get_set(cache_hash(m.f, m.g, m.h));
+                std::rotate(s.begin(), s.end() - 1, s.end());
+                s[0] = m;
+                ++cache_inserts;
+            }
+        }
+    }
+
+    void memo_cache::set_memory_budget(const size_t bytes)
+    {
+#ifdef LBDD_CONCURRENT
+        std::unique_lock<std::shared_mutex> exclusive_lock(resize_mutex);
+#endif
+        memory_budget_ = bytes;
+        if(sets.size() > max_nr_sets())
+            resize(max_nr_sets());
+    }
+
+    void memo_cache::reset_statistics()
+    {
+        const size_t nr_slots = statistics_.nr_slots;
+        statistics_ = memo_cache_statistics();
+        statistics_.nr_slots = nr_slots;
     }
 
     bool memo_struct::can_be_purged() const
     {
         if(r == nullptr)
             return true; // TODO: or false?
-        if(r->xref < 0)
+        if(r->dead() || f->dead() || g->dead())
             return true;
-        if(f->xref < 0)
-            return true;
-        if(h != nullptr && g->xref < 0)
+        // h is either an operation symbol, a node for ite or a tagged cube for and_exists
+        if(is_and_exists_key(h))
+            return and_exists_cube(h)->dead();
+        if(!is_operation_symbol(h) && h->dead())
             return true;
         return false;
     }
 
-    size_t memo_cache::choose_cache_size(const size_t items) const
+    void memo_cache::purge()
     {
-        // size shall be power of 2 such that not more than a quarter of slots are taken
-        size_t count = 0;
-        size_t c = items;
-        while(c != 0)
+        // remove memos referring to dead nodes and keep the remaining ones in age order at the front of their set
+        cache_inserts = 0;
+        for(memo_set& s : sets)
         {
-            c >>= 1;  
-            count += 1;  
-        }  
-        size_t n = 1 << count+2;  
-        assert(4*items >= n);
-        assert(8*items <= n);
-        return n;
-    }
-
-    size_t memo_cache::nr_occupied_slots() const
-    {
-        return std::count_if(memos.begin(), memos.end(), [](const auto& m) { return !m.can_be_purged(); });
+            size_t k = 0;
+            for(size_t i=0; i<memo_cache_ways; ++i)
+                if(!s[i].can_be_purged())
+                    s[k++] = s[i];
+            cache_inserts += k;
+            for(; k<memo_cache_ways; ++k)
+                s[k] = memo_struct();
+        }
     }
 
-    void memo_cache::purge()
+    void memo_cache::clear()
     {
-        size_t items = 0;
-        for(size_t k = 0; k < memos.size(); ++k)
-            if(memos[k].can_be_purged())
-                memos[k].r = nullptr;
-            else
-                ++items;
-
-        return;
-        // TODO: resize memo cache? A resize will often not physically deallocate freed memory.
-        cache_inserts = items;
-        const size_t new_cache_size = choose_cache_size(items);
-
-        if(new_cache_size < memos.size())
-        {
-            size_t memos_mask = new_cache_size - 1;
-            for(size_t k = 0; k < memos.size(); ++k)
-            {
-                if(memos[k].r != nullptr && memos[k].h != nullptr)
-                {
-                    const size_t new_slot = cache_hash(memos[k].f, memos[k].g, memos[k].h) & memos_mask;
-                    if(new_slot != k)
-                        memos[new_slot] = memos[k];
-                }
-            }
-            memos.resize(new_cache_size);
-        }
+        cache_inserts = 0;
+        for(memo_set& s : sets)
+            s.fill(memo_struct());
     }
 }
@@ -1,7 +1,10 @@
 #include "bdd_mgr.h"
 #include "bdd_collection.h"
+#include "bdd_linear_constraint.h"
 #include <cassert>
 #include <stack>
+#include <numeric>
+#include <algorithm>
 
 namespace BDD {
 
@@ -14,12 +17,16 @@ namespace BDD {
     {
         for(size_t i=0; i<vars.size(); ++i)
             vars[i].release_nodes(); 
+        if(nr_moved_variables_ > 0)
+            nr_reordered_mgrs_.fetch_sub(1, std::memory_order_relaxed);
     }
 
     size_t bdd_mgr::add_variable()
     {
         assert(vars.size() < maxvarsize);
         vars.emplace_back(vars.size(), *this);
+        levels_.push_back(vars.size()-1);
+        variables_.push_back(vars.size()-1);
         return vars.size()-1;
     }
 
@@ -28,25 +35,28 @@ namespace BDD {
         for(size_t i=vars.size(); i<=var; ++i)
             add_variable();
         assert(var < vars.size());
-        return node_ref(vars[var].unique_find(node_cache_.botsink(), node_cache_.topsink()));
+        return node_ref(vars[level(var)].unique_find(node_cache_.botsink(), node_cache_.topsink()));
         //return vars[var].projection();
     }
 
     node_ref bdd_mgr::neg_projection(const size_t var)
     {
         assert(var < vars.size());
-        return node_ref(vars[var].unique_find(node_cache_.topsink(), node_cache_.botsink())); 
+        return node_ref(vars[level(var)].unique_find(node_cache_.topsink(), node_cache_.botsink())); 
     }
 
     node_ref bdd_mgr::negate(node_ref p)
     {
+        operation_scope scope(*this);
+        if(p.depth() > max_recursion_depth)
+            return xor_non_rec(topsink(), p);
         if(p.is_botsink())
             return node_ref(node_cache_.topsink());
         if(p.is_topsink())
             return node_ref(node_cache_.botsink());
         else
         {
-            const std::size_t v = p.variable();
+            const std::size_t v = p.level();
             assert(v < nr_variables());
             return node_ref(vars[v].unique_find( negate(p.low()).ref, negate(p.high()).ref));
         }
@@ -55,54 +65,30 @@ namespace BDD {
     node_ref bdd_mgr::unique_find(const size_t var, node_ref lo, node_ref hi)
     {
         assert(var < nr_variables());
-        return node_ref(vars[var].unique_find(lo.address(), hi.address()));
+        return level_find(level(var), lo, hi);
     }
 
-    node_ref bdd_mgr::and_rec(node_ref f, node_ref g)
+    node_ref bdd_mgr::level_find(const size_t l, node_ref lo, node_ref hi)
     {
-        if(f == g)
-            return f;
-
-        if(f.ref > g.ref)
-            return and_rec(g,f);
-
-        if(f.ref == node_cache_.topsink())
-            return g;
-        else if(f.ref == node_cache_.botsink())
-            return node_ref(node_cache_.botsink());
-        else if(g.ref == node_cache_.topsink())
-            return f;
-        else if(g.ref == node_cache_.botsink())
-            return node_ref(node_cache_.botsink()); 
-
-        node* m = memo_.cache_lookup(f.ref, g.ref, memo_struct::and_symb());
-        if(m != nullptr)
-            return node_ref(m);
+        assert(l < nr_variables());
+        return node_ref(vars[l].unique_find(lo.address(), hi.address()));
+    }
 
-        var& f_var = vars[f.variable()];
-        var& g_var = vars[g.variable()];
-        var& v = [&]() -> var& {
-            if(&f_var < &g_var)
-                return f_var;
-            else 
-                return g_var;
-        }();
+    node_ref bdd_mgr::apply_unary(const bool on_false, const bool on_true, node_ref p)
+    {
+        if(on_false == on_true)
+            return on_true ? topsink() : botsink();
+        return on_true ? p : negate(p);
+    }
 
-        node_ref r0 = and_rec(&v == &f_var ? f.low() : f, &v == &g_var ? g.low() : g);
-        assert(r0.ref != nullptr);
-        node_ref r1 = and_rec(&v == &f_var ? f.high() : f, &v == &g_var ? g.high() : g);
-        assert(r1.ref != nullptr);
-        
-        node* r = v.unique_find(r0.ref, r1.ref);
-        assert(r != nullptr);
-        //if(r != nullptr)
-        memo_.cache_insert(f.ref, g.ref, memo_struct::and_symb(), r);
-        return node_ref(r); 
+    node_ref bdd_mgr::and_rec(node_ref f, node_ref g)
+    {
+        return apply<and_operator>(f, g);
     }
 
-    // return
     std::tuple<node_ref,size_t> bdd_mgr::and_rec_limited(node_ref f, node_ref g, const size_t node_limit)
     {
+        operation_scope scope(*this);
         if(f == g)
         {
             const size_t nr_nodes = f.nr_nodes();
@@ -134,8 +120,8 @@ namespace BDD {
                     return {node_ref(nullptr), std::numeric_limits<size_t>::max()};
         }
 
-        var& f_var = vars[f.variable()];
-        var& g_var = vars[g.variable()];
+        var& f_var = vars[f.level()];
+        var& g_var = vars[g.level()];
         var& v = [&]() -> var& {
             if(&f_var < &g_var)
                 return f_var;
@@ -163,100 +149,40 @@ namespace BDD {
 
     node_ref bdd_mgr::or_rec(node_ref f, node_ref g)
     {
-        // trivial cases
-        if(f == g)
-        {
-            return f;
-        }
-
-        if(f.ref > g.ref)
-            return or_rec(g,f);
-            //std::swap(f,g);
-
-        if(f.ref == node_cache_.topsink())
-        {
-            return node_ref(node_cache_.topsink());
-        }
-        else if(f.ref == node_cache_.botsink())
-        {
-            return g;
-        }
-        else if(g.ref == node_cache_.topsink())
-        {
-            return node_ref(node_cache_.topsink()); 
-        }
-        else if(g.ref == node_cache_.botsink())
-        {
-            return f;
-        }
-
-        node* m = memo_.cache_lookup(f.ref, g.ref, memo_struct::or_symb());
-        if(m != nullptr)
-            return m;
-
-        // find recursively
-        var& f_var = vars[f.variable()];
-        var& g_var = vars[g.variable()];
-        var& v = [&]() -> var& {
-            if(&f_var < &g_var)
-                return f_var;
-            else 
-                return g_var;
-        }();
-
-        node_ref r0 = or_rec(&v == &f_var ? f.low() : f, &v == &g_var ? g.low() : g);
-        assert(r0.ref != nullptr);
-        node_ref r1 = or_rec(&v == &f_var ? f.high() : f, &v == &g_var ? g.high() : g);
-        assert(r1.ref != nullptr);
-        
-        node* r = v.unique_find(r0.ref, r1.ref);
-        if(r != nullptr)
-            memo_.cache_insert(f.ref, g.ref, memo_struct::or_symb(), r);
-        return node_ref(r); 
+        return apply<or_operator>(f, g);
     }
 
     node_ref bdd_mgr::xor_rec(node_ref f, node_ref g)
     {
-        // trivial cases
-        if(f == g)
-            return node_ref(node_cache_.botsink());
-
-        if(f.ref > g.ref)
-            return xor_rec(g,f);
+        return apply<xor_operator>(f, g);
+    }
 
-        if(f.ref == node_cache_.botsink())
-            return g;
-        else if(g.ref == node_cache_.botsink())
-            return f;
-        else if(f.ref == node_cache_.topsink())
-            return negate(g);
-        else if(g.ref == node_cache_.topsink())
-            return negate(f);
+    node_ref bdd_mgr::nand_rec(node_ref f, node_ref g)
+    {
+        return apply<nand_operator>(f, g);
+    }
 
-        node* m = memo_.cache_lookup(f.ref, g.ref, memo_struct::xor_symb());
-        if(m != nullptr)
-            return node_ref(m);
+    node_ref bdd_mgr::implies_rec(node_ref f, node_ref g)
+    {
+        return apply<implies_operator>(f, g);
+    }
 
-        // find recursively
-        assert(f.variable() < nr_variables());
-        var& vf = vars[f.variable()];
-        assert(g.variable() < nr_variables());
-        var& vg = vars[g.variable()];
-        var& v = *std::max(&vg,&vf);
+    node_ref bdd_mgr::diff_rec(node_ref f, node_ref g)
+    {
+        return apply<diff_operator>(f, g);
+    }
 
-        node_ref r0 = xor_rec(&v == &vf ? f.low() : f, &v == &vg ? g.low() : g);
-        assert(r0.ref != nullptr);
-        node_ref r1 = xor_rec(&v == &vf ? f.high() : f, &v == &vg ? g.high() : g);
-        assert(r1.ref != nullptr);
-        
-        node* r = v.unique_find(r0.ref, r1.ref);
-        if(r != nullptr)
-            memo_.cache_insert(f.ref, g.ref, memo_struct::xor_symb(), r);
-        return node_ref(r); 
+    node_ref bdd_mgr::equiv_rec(node_ref f, node_ref g)
+    {
+        return apply<equiv_operator>(f, g);
     }
 
     node_ref bdd_mgr::ite_rec(node_ref f, node_ref g, node_ref h)
     {
+        operation_scope scope(*this);
+        if(f.depth() + g.depth() + h.depth() > max_recursion_depth)
+            return ite_non_rec(f,g,h);
+
         // trivial cases
         if(f.is_topsink())
             return g;
@@ -278,24 +204,22 @@ namespace BDD {
         if(m != nullptr)
             return node_ref(m);
 
-        var& vf = vars[f.variable()];
-        var& vg = g.is_terminal() ? vars.back() : vars[g.variable()];
-        var& vh = h.is_terminal() ? vars.back() : vars[h.variable()];
-
-        //var& v = *std::min({&vf,&vg,&vh}); // compilation error on gcc-8.1?
-        var& v = *std::min(std::min(&vf,&vg),&vh);
+        // terminals have indices larger than all variables
+        const size_t v_idx = std::min({f.level(), g.level(), h.level()});
+        assert(v_idx < nr_variables());
+        var& v = vars[v_idx];
 
         node_ref r0 = ite_rec(
-                (&vf == &v ? f.low() : f),
-                (&vg == &v ? g.low() : g),
-                (&vh == &v ? h.low() : h)
+                (f.level() == v_idx ? f.low() : f),
+                (g.level() == v_idx ? g.low() : g),
+                (h.level() == v_idx ? h.low() : h)
                 );
         assert(r0.ref != nullptr);
 
         node_ref r1 = ite_rec(
-                (&vf == &v ? f.high() : f),
-                (&vg == &v ? g.high() : g),
-                (&vh == &v ? h.high() : h)
+                (f.level() == v_idx ? f.high() : f),
+                (g.level() == v_idx ? g.high() : g),
+                (h.level() == v_idx ? h.high() : h)
                 );
         assert(r1.ref != nullptr);
 
@@ -305,127 +229,687 @@ namespace BDD {
         return node_ref(r); 
     }
 
-    /*
-    node_ref bdd_mgr::ite_non_rec(node_ref f, node_ref g, node_ref h, std::stack<>& stack2)
+    node_ref bdd_mgr::exists(node_ref f, node_ref cube)
     {
-        using instruction_type = unsigned char;
+        operation_scope scope(*this);
+        if(f.is_terminal())
+            return f;
+        // variables of the cube above f do not occur in f
+        while(!cube.is_topsink() && cube.level() < f.level())
+            cube = cube.high();
+        if(cube.is_topsink())
+            return f;
+        assert(cube.low().is_botsink());
 
-        static constexpr instruction_type xor_instr = 0;
-        static constexpr instruction_type or_instr = 1;
-        static constexpr instruction_type and_instr = 2;
-        static constexpr instruction_type ite_instr = 3;
+        node* m = memo_.cache_lookup(f.ref, cube.ref, memo_struct::exists_symb());
+        if(m != nullptr)
+            return node_ref(m);
 
-        struct instruction {
-            instruction_type instr;
-            node_ref f;
-            node_ref g;
-            node_ref h; 
-        };
+        const size_t v = f.level();
+        node_ref r;
+        if(v == cube.level())
+        {
+            node_ref r0 = exists(f.low(), cube.high());
+            // disjunction with topsink need not be computed
+            if(r0.is_topsink())
+                r = r0;
+            else
+                r = or_rec(r0, exists(f.high(), cube.high()));
+        }
+        else
+        {
+            node_ref r0, r1;
+            fork_join(f.depth(),
+                    [&]() { r0 = exists(f.low(), cube); },
+                    [&]() { r1 = exists(f.high(), cube); });
+            r = node_ref(vars[v].unique_find(r0.ref, r1.ref));
+        }
+        assert(r.ref != nullptr);
+        memo_.cache_insert(f.ref, cube.ref, memo_struct::exists_symb(), r.ref);
+        return r;
+    }
+
+    node_ref bdd_mgr::forall(node_ref f, node_ref cube)
+    {
+        operation_scope scope(*this);
+        if(f.is_terminal())
+            return f;
+        while(!cube.is_topsink() && cube.level() < f.level())
+            cube = cube.high();
+        if(cube.is_topsink())
+            return f;
+        assert(cube.low().is_botsink());
 
-        std::stack<instruction> stack;
-        std::stack<> result_stack;
+        node* m = memo_.cache_lookup(f.ref, cube.ref, memo_struct::forall_symb());
+        if(m != nullptr)
+            return node_ref(m);
 
-        while(!stack.empty())
+        const size_t v = f.level();
+        node_ref r;
+        if(v == cube.level())
         {
-            const instruction_type instr = stack.top().instr;
-            node_ref f = stack.top().f;
-            node_ref g = stack.top().g;
-            node_ref h = stack.top().h;
-            stack.pop();
-
+            node_ref r0 = forall(f.low(), cube.high());
+            // conjunction with botsink need not be computed
+            if(r0.is_botsink())
+                r = r0;
+            else
+                r = and_rec(r0, forall(f.high(), cube.high()));
         }
+        else
+        {
+            node_ref r0, r1;
+            fork_join(f.depth(),
+                    [&]() { r0 = forall(f.low(), cube); },
+                    [&]() { r1 = forall(f.high(), cube); });
+            r = node_ref(vars[v].unique_find(r0.ref, r1.ref));
+        }
+        assert(r.ref != nullptr);
+        memo_.cache_insert(f.ref, cube.ref, memo_struct::forall_symb(), r.ref);
+        return r;
+    }
 
+    node_ref bdd_mgr::and_exists(node_ref f, node_ref g, node_ref cube)
+    {
+        operation_scope scope(*this);
         // trivial cases
+        if(f.is_botsink() || g.is_botsink())
+            return node_ref(node_cache_.botsink());
         if(f.is_topsink())
-            return g;
-        if(f.is_botsink())
-            return h;
-
-        if(g == f || g.is_topsink())
-            return or_rec(f,h);
-        if(h == f || h.is_botsink())
-            return and_rec(f,g);
+            return exists(g, cube);
+        if(g.is_topsink() || f == g)
+            return exists(f, cube);
 
-        if(g == h)
-            return g;
+        if(f.ref > g.ref)
+            return and_exists(g, f, cube);
 
-        if(g.is_botsink() && h.is_topsink())
-            return xor_rec(node_ref(get_node_cache().topsink()), f);
+        const size_t v = std::min(f.level(), g.level());
+        while(!cube.is_topsink() && cube.level() < v)
+            cube = cube.high();
+        if(cube.is_topsink())
+            return and_rec(f, g);
+        assert(cube.low().is_botsink());
 
-        node* m = memo_.cache_lookup(f.ref, g.ref, h.ref);
+        node* m = memo_.cache_lookup(f.ref, g.ref, memo_struct::and_exists_key(cube.ref));
         if(m != nullptr)
             return node_ref(m);
 
-        var& vf = vars[f.variable()];
-        var& vg = g.is_terminal() ? vars.back() : vars[g.variable()];
-        var& vh = h.is_terminal() ? vars.back() : vars[h.variable()];
+        node_ref r;
+        if(v == cube.level())
+        {
+            node_ref r0 = and_exists(f.level() == v ? f.low() : f, g.level() == v ? g.low() : g, cube.high());
+            // disjunction with topsink need not be computed
+            if(r0.is_topsink())
+                r = r0;
+            else
+                r = or_rec(r0, and_exists(f.level() == v ? f.high() : f, g.level() == v ? g.high() : g, cube.high()));
+        }
+        else
+        {
+            node_ref r0, r1;
+            fork_join(f.depth() + g.depth(),
+                    [&]() { r0 = and_exists(f.level() == v ? f.low() : f, g.level() == v ? g.low() : g, cube); },
+                    [&]() { r1 = and_exists(f.level() == v ? f.high() : f, g.level() == v ? g.high() : g, cube); });
+            r = node_ref(vars[v].unique_find(r0.ref, r1.ref));
+        }
+        assert(r.ref != nullptr);
+        memo_.cache_insert(f.ref, g.ref, memo_struct::and_exists_key(cube.ref), r.ref);
+        return r;
+    }
 
-        //var& v = *std::min({&vf,&vg,&vh}); // compilation error on gcc-8.1?
-        var& v = *std::min(std::min(&vf,&vg),&vh);
+    namespace {
 
-        node_ref r0 = ite_rec(
-                (&vf == &v ? f.low() : f),
-                (&vg == &v ? g.low() : g),
-                (&vh == &v ? h.low() : h)
-                );
-        assert(r0.ref != nullptr);
+        // work item of the non-recursive apply engine. For binary operations h holds the operation symbol, so that (f,g,h) is always the memo key.
+        struct apply_frame {
+            node* f;
+            node* g;
+            node* h;
+            unsigned char op;
+            bool expanded; // cofactor frames have been pushed, result is assembled once both are on the result stack
+        };
 
-        node_ref r1 = ite_rec(
-                (&vf == &v ? f.high() : f),
-                (&vg == &v ? g.high() : g),
-                (&vh == &v ? h.high() : h)
-                );
-        assert(r1.ref != nullptr);
+        // frames and intermediate results are kept in a per-thread pool that is reused across calls
+        struct apply_frame_pool {
+            std::vector<apply_frame> frames;
+            std::vector<node*> results;
+        };
 
-        node* r = v.unique_find(r0.ref, r1.ref);
-        assert(r != nullptr);
-        memo_.cache_insert(f.ref, g.ref, h.ref, r);
-        return node_ref(r); 
+        thread_local apply_frame_pool apply_pool;
+    }
+
+    node_ref bdd_mgr::and_non_rec(node_ref f, node_ref g)
+    {
+        return node_ref(apply_non_rec(and_operator::table, f.ref, g.ref, memo_struct::and_symb()));
+    }
+
+    node_ref bdd_mgr::or_non_rec(node_ref f, node_ref g)
+    {
+        return node_ref(apply_non_rec(or_operator::table, f.ref, g.ref, memo_struct::or_symb()));
+    }
+
+    node_ref bdd_mgr::xor_non_rec(node_ref f, node_ref g)
+    {
+        return node_ref(apply_non_rec(xor_operator::table, f.ref, g.ref, memo_struct::xor_symb()));
+    }
+
+    node_ref bdd_mgr::ite_non_rec(node_ref f, node_ref g, node_ref h)
+    {
+        return node_ref(apply_non_rec(ite_op, f.ref, g.ref, h.ref));
+    }
+
+    // Operates on raw node pointers without touching reference counts. Intermediate nodes are referenced by their parents once the result is assembled, automatic garbage collection is suspended in between.
+    node* bdd_mgr::apply_non_rec(const unsigned char op, node* f, node* g, node* h)
+    {
+        // f, g and h are held by node_refs of the caller, reordering keeps their functions
+        operation_scope scope(*this);
+        gc_suspension gc_guard(*this);
+        node* const botsink = node_cache_.botsink();
+        node* const topsink = node_cache_.topsink();
+
+        // trivial cases. Returns nullptr if frame needs to be expanded. Ite frames may be rewritten into binary operations.
+        auto terminal_case = [&](apply_frame& fr) -> node* {
+            if(fr.op == ite_op)
+            {
+                if(fr.f == topsink)
+                    return fr.g;
+                if(fr.f == botsink)
+                    return fr.h;
+                if(fr.g == fr.f || fr.g == topsink)
+                    fr = {fr.f, fr.h, memo_struct::or_symb(), or_operator::table, false};
+                else if(fr.h == fr.f || fr.h == botsink)
+                    fr = {fr.f, fr.g, memo_struct::and_symb(), and_operator::table, false};
+                else if(fr.g == fr.h)
+                    return fr.g;
+                else if(fr.g == botsink && fr.h == topsink)
+                    fr = {topsink, fr.f, memo_struct::xor_symb(), xor_operator::table, false};
+                else
+                    return nullptr;
+            }
+
+            // binary operation, as in apply. Negations of an operand are expanded like any other operation and hence memoized
+            auto value = [op = fr.op](const bool a, const bool b) -> bool { return (op >> (2*a + b)) & 1; };
+            auto unary = [&](const bool on_false, const bool on_true, node* p) -> node* {
+                if(on_false == on_true)
+                    return on_true ? topsink : botsink;
+                return on_true ? p : nullptr;
+            };
+            auto is_terminal = [&](node* p) { return p == botsink || p == topsink; };
+            if(is_terminal(fr.f) && is_terminal(fr.g))
+                return value(fr.f == topsink, fr.g == topsink) ? topsink : botsink;
+            if(fr.f == fr.g)
+                return unary(value(false, false), value(true, true), fr.f);
+            if(value(false, true) == value(true, false) && fr.f > fr.g)
+                std::swap(fr.f, fr.g);
+            if(is_terminal(fr.f))
+                return unary(value(fr.f == topsink, false), value(fr.f == topsink, true), fr.g);
+            if(is_terminal(fr.g))
+                return unary(value(false, fr.g == topsink), value(true, fr.g == topsink), fr.f);
+            return nullptr;
+        };
+
+        auto top_variable = [&](const apply_frame& fr) -> size_t {
+            // terminals have indices larger than all variables
+            size_t v = std::min(fr.f->index, fr.g->index);
+            if(fr.op == ite_op)
+                v = std::min(v, size_t(fr.h->index));
+            assert(v < nr_variables());
+            return v;
+        };
+
+        auto& stack = apply_pool.frames;
+        auto& results = apply_pool.results;
+        // nested calls on the same thread get a fresh pool
+        const size_t stack_base = stack.size();
+        [[maybe_unused]] const size_t results_base = results.size();
+
+        stack.push_back({f, g, h, static_cast<unsigned char>(op), false});
+        while(stack.size() > stack_base)
+        {
+            if(stack.back().expanded)
+            {
+                const apply_frame fr = stack.back();
+                stack.pop_back();
+                node* r1 = results.back();
+                results.pop_back();
+                node* r0 = results.back();
+                results.pop_back();
+
+                node* r = vars[top_variable(fr)].unique_find(r0, r1);
+                assert(r != nullptr);
+                memo_.cache_insert(fr.f, fr.g, fr.h, r);
+                results.push_back(r);
+                continue;
+            }
+
+            node* r = terminal_case(stack.back());
+            if(r == nullptr)
+            {
+                const apply_frame& fr = stack.back();
+                r = memo_.cache_lookup(fr.f, fr.g, fr.h);
+            }
+            if(r != nullptr)
+            {
+                stack.pop_back();
+                results.push_back(r);
+                continue;
+            }
 
+            stack.back().expanded = true;
+            const apply_frame fr = stack.back();
+            const size_t v = top_variable(fr);
+            auto lo = [v](node* p) { return p->index == v ? p->lo : p; };
+            auto hi = [v](node* p) { return p->index == v ? p->hi : p; };
+            const bool ite = fr.op == ite_op;
 
+            // push hi before lo, so that lo is computed first and lies below hi on the result stack
+            stack.push_back({hi(fr.f), hi(fr.g), ite ? hi(fr.h) : fr.h, fr.op, false});
+            stack.push_back({lo(fr.f), lo(fr.g), ite ? lo(fr.h) : fr.h, fr.op, false});
+        }
+
+        assert(results.size() == results_base + 1);
+        node* r = results.back();
+        results.pop_back();
+        return r;
     }
-*/
+
+#ifdef LBDD_CONCURRENT
+    void bdd_mgr::set_nr_threads(const size_t nr_threads)
+    {
+        if(nr_threads <= 1)
+            task_pool_.reset();
+        else
+            task_pool_ = std::make_unique<bdd_task_pool>(nr_threads);
+        parallel_levels_ = 4;
+        while((size_t(1) << (parallel_levels_ - 4)) < nr_threads)
+            ++parallel_levels_;
+    }
+#endif
 
     void bdd_mgr::collect_garbage()
     {
         for(size_t i=0; i<vars.size(); ++i)
             vars[i].remove_dead_nodes();
 
+        finish_garbage_collection_cycle();
+    }
+
+#ifndef LBDD_CONCURRENT
+    void bdd_mgr::set_garbage_collection_policy(const double growth, const size_t vars_per_step)
+    {
+        assert(growth >= 0.0);
+        assert(vars_per_step > 0);
+        gc_growth_ = growth;
+        gc_vars_per_step_ = vars_per_step;
+    }
+#endif
+
+    bool bdd_mgr::garbage_collection_due()
+    {
+        if(!automatic_gc_ || gc_suspended_ > 0)
+            return false;
+        if(gc_cycle_active_)
+            return true;
+#ifdef LBDD_CONCURRENT
+        return false;
+#else
+        const size_t threshold = std::max(gc_min_nodes, size_t((1.0 + gc_growth_) * double(gc_nodes_after_cycle_)));
+        return nr_nodes() >= threshold && node_cache_.nr_dead_nodes() > 0;
+#endif
+    }
+
+    // Variables are swept in order, so that nodes dying by freeing their parents are reclaimed in the same cycle.
+    // Memos may refer to nodes retired in earlier steps, those are recognized as stale by the memo cache until the purge at the end of the cycle.
+    void bdd_mgr::garbage_collection_step()
+    {
+        assert(gc_suspended_ == 0);
+        if(!gc_cycle_active_)
+        {
+            gc_cycle_active_ = true;
+            gc_cursor_ = 0;
+        }
+
+        const size_t last = std::min(vars.size(), gc_cursor_ + gc_vars_per_step_);
+        for(; gc_cursor_ < last; ++gc_cursor_)
+            vars[gc_cursor_].remove_dead_nodes(true);
+
+        if(gc_cursor_ == vars.size())
+            finish_garbage_collection_cycle();
+    }
+
+    void bdd_mgr::finish_garbage_collection_cycle()
+    {
         memo_.purge();
+        node_cache_.release_retired_nodes();
+        gc_cycle_active_ = false;
+        gc_cursor_ = 0;
+        gc_nodes_after_cycle_ = nr_nodes();
     }
 
-    node_ref bdd_mgr::add_bdd(bdd_collection& bdd_col, const size_t bdd_nr)
+    bool bdd_mgr::reordering_due() const
     {
-        assert(bdd_nr < bdd_col.nr_bdds());
-        auto [bdd_begin, bdd_end] = bdd_col.get_bdd_instructions(bdd_nr);
-        std::unordered_map<size_t, node_ref> bdd_map;
-        for(auto bdd_it=bdd_end; bdd_it!=bdd_begin; --bdd_it)
+        return automatic_reordering_ && gc_suspended_ == 0 && nr_nodes() >= reordering_threshold_;
+    }
+
+    void bdd_mgr::set_reordering_policy(const size_t threshold, const double max_growth)
+    {
+        assert(max_growth >= 1.0);
+        reordering_threshold_ = threshold;
+        reordering_max_growth_ = max_growth;
+    }
+
+    // Nodes of level l with a child at level l+1 are rewritten as nodes of the variable moving up, their children become nodes of the variable moving down.
+    // The other nodes of level l move to level l+1 and those of level l+1 to level l unchanged. Nodes of level l+1 losing their last parent are freed.
+    void bdd_mgr::swap_levels(const size_t l)
+    {
+        assert(l+1 < nr_variables());
+        gc_suspension gc_guard(*this);
+        var& upper = vars[l];
+        var& lower = vars[l+1];
+        swap_upper_.clear();
+        swap_lower_.clear();
+        upper.extract_nodes(swap_upper_);
+        lower.extract_nodes(swap_lower_);
+
+        // dead nodes left over from earlier swaps would keep their children alive
+        auto free_dead_nodes = [&](std::vector<node*>& nodes) {
+            size_t k = 0;
+            for(node* p : nodes)
+                if(p->dead())
+                    node_cache_.free_node(p);
+                else
+                    nodes[k++] = p;
+            nodes.resize(k);
+        };
+        free_dead_nodes(swap_upper_);
+        free_dead_nodes(swap_lower_);
+
+        const auto independent = std::partition(swap_upper_.begin(), swap_upper_.end(), [l](node* p) { return p->lo->index == l+1 || p->hi->index == l+1; });
+        for(auto it=independent; it!=swap_upper_.end(); ++it)
         {
-            const auto& bdd = *std::prev(bdd_it);
-            if(bdd.is_botsink())
+            (*it)->index = l+1;
+            lower.insert_node(*it);
+        }
+        for(node* p : swap_lower_)
+            p->index = l;
+
+        const size_t x = upper.variable();
+        const size_t y = lower.variable();
+        upper.set_variable(y);
+        lower.set_variable(x);
+        levels_[x] = l+1;
+        levels_[y] = l;
+        const bool was_reordered = variables_reordered();
+        nr_moved_variables_ -= (variables_[l] != l) + (variables_[l+1] != l+1);
+        variables_[l] = y;
+        variables_[l+1] = x;
+        nr_moved_variables_ += (variables_[l] != l) + (variables_[l+1] != l+1);
+        if(!was_reordered && variables_reordered())
+            nr_reordered_mgrs_.fetch_add(1, std::memory_order_relaxed);
+        else if(was_reordered && !variables_reordered())
+            nr_reordered_mgrs_.fetch_sub(1, std::memory_order_relaxed);
+
+        for(auto it=swap_upper_.begin(); it!=independent; ++it)
+        {
+            node* p = *it;
+            node* f0 = p->lo;
+            node* f1 = p->hi;
+            // cofactors with respect to y, whose nodes are at level l now
+            node* f00 = f0->index == l ? static_cast<node*>(f0->lo) : f0;
+            node* f01 = f0->index == l ? static_cast<node*>(f0->hi) : f0;
+            node* f10 = f1->index == l ? static_cast<node*>(f1->lo) : f1;
+            node* f11 = f1->index == l ? static_cast<node*>(f1->hi) : f1;
+            node* r0 = lower.unique_find(f00, f10);
+            node* r1 = lower.unique_find(f01, f11);
+            assert(r0 != r1);
+            r0->inc_xref();
+            r1->inc_xref();
+            f0->dec_xref();
+            f1->dec_xref();
+            p->lo = r0;
+            p->hi = r1;
+            const size_t max_depth = std::max(r0->depth(), r1->depth());
+            p->depth_ = max_depth == max_node_depth ? max_depth : max_depth + 1;
+            upper.insert_node(p);
+        }
+
+        for(node* p : swap_lower_)
+            if(p->dead())
+                node_cache_.free_node(p);
+            else
+                upper.insert_node(p);
+    }
+
+    void bdd_mgr::sift(const size_t var)
+    {
+        size_t l = level(var);
+        size_t best_size = nr_nodes();
+        size_t best_level = l;
+        auto move = [&](const bool down) {
+            while(down ? l+1 < nr_variables() : l > 0)
             {
-                bdd_map.insert({bdd_col.offset(bdd), botsink()}); 
+                swap_levels(down ? l : l-1);
+                l = down ? l+1 : l-1;
+                if(nr_nodes() < best_size)
+                {
+                    best_size = nr_nodes();
+                    best_level = l;
+                }
+                else if(double(nr_nodes()) > reordering_max_growth_ * double(best_size))
+                    break;
             }
-            else if(bdd.is_topsink())
+        };
+
+        // towards the nearer end first
+        const bool down_first = 2*l >= nr_variables();
+        move(down_first);
+        move(!down_first);
+        for(; l < best_level; ++l)
+            swap_levels(l);
+        for(; l > best_level; --l)
+            swap_levels(l-1);
+    }
+
+    void bdd_mgr::reorder()
+    {
+        collect_garbage();
+        // swaps free nodes without retiring them
+        memo_.clear();
+
+        std::vector<size_t> order(nr_variables());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](const size_t v, const size_t w) { return vars[level(v)].nr_nodes() > vars[level(w)].nr_nodes(); });
+        for(const size_t v : order)
+            sift(v);
+
+        collect_garbage();
+        // paths through swapped levels may have become longer, recompute depths bottom-up
+        for(size_t l=nr_variables(); l-- > 0;)
+            vars[l].for_each_node([](node* p) {
+                    const size_t max_depth = std::max(p->lo->depth(), p->hi->depth());
+                    p->depth_ = max_depth == max_node_depth ? max_depth : max_depth + 1;
+                    });
+
+        ++nr_reorderings_;
+        reordering_threshold_ = std::max(reordering_threshold_, 2*nr_nodes());
+    }
+
+    node_ref bdd_mgr::add_bdd(bdd_collection& bdd_col, const size_t bdd_nr)
+    {
+        assert(bdd_nr < bdd_col.nr_bdds());
+        const auto [bdd_begin, bdd_end] = bdd_col.get_bdd_instructions(bdd_nr);
+        const size_t begin = bdd_col.offset(*bdd_begin);
+        return add_bdd(&*bdd_begin - begin, begin, begin + std::distance(bdd_begin, bdd_end));
+    }
+
+    node_ref bdd_mgr::count_literals(std::vector<std::pair<size_t,bool>>& lits, const size_t lower, const size_t upper)
+    {
+        assert(std::is_sorted(lits.begin(), lits.end()));
+        const size_t n = lits.size();
+        if(lower > upper || lower > n)
+            return botsink();
+        // numbers of true literals from cap on lead to the same result: above upper none is accepted, and if upper cannot be exceeded all from lower on are
+        const size_t cap = upper >= n ? lower : upper + 1;
+        // the literals are given by their levels in the current order
+        operation_scope scope(*this, false);
+
+        // next[c] is the constraint on the literals below given c true literals above
+        std::vector<node_ref> next, cur;
+        next.reserve(cap+1);
+        cur.reserve(cap+1);
+        for(size_t c=0; c<=cap; ++c)
+            next.push_back(c >= lower && c <= upper ? topsink() : botsink());
+        for(size_t i=n; i-- > 0;)
+        {
+            const auto [l, positive] = lits[i];
+            cur.clear();
+            for(size_t c=0; c<=std::min(i, cap); ++c)
             {
-                bdd_map.insert({bdd_col.offset(bdd), topsink()}); 
+                const node_ref& f_false = next[c];
+                const node_ref& f_true = next[std::min(c+1, cap)];
+                cur.push_back(positive ? level_find(l, f_false, f_true) : level_find(l, f_true, f_false));
             }
+            std::swap(cur, next);
+        }
+        return next[0];
+    }
+
+    node_ref bdd_mgr::linear_constraint(const std::vector<node_ref>& operands, const std::vector<std::int64_t>& coefficients, const std::int64_t bound, const bool equality, const bool literals)
+    {
+        assert(operands.size() == coefficients.size());
+        detail::linear_constraint_compiler compiler;
+        const size_t root = equality ? compiler.compile_equal(coefficients, bound) : compiler.compile_at_most(coefficients, bound);
+        if(root == detail::linear_constraint_compiler::botsink)
+            return botsink();
+        if(root == detail::linear_constraint_compiler::topsink)
+            return topsink();
+
+        // literals are given by their levels in the current order
+        operation_scope scope(*this, false);
+        std::vector<node_ref> nodes = {botsink(), topsink()};
+        nodes.reserve(compiler.nodes().size() + 2);
+        for(const auto& n : compiler.nodes())
+        {
+            const node_ref& f = nodes[n.false_child];
+            const node_ref& t = nodes[n.true_child];
+            const node* l = operands[n.literal].address();
+            if(!literals)
+                nodes.push_back(ite_rec(operands[n.literal], t, f));
+            else if(l->hi->is_topsink())
+                nodes.push_back(level_find(l->index, f, t));
             else
-            { 
-                assert(bdd_col.offset(bdd) < 1000); // TODO: remove
-                assert(bdd_map.count(bdd.lo) > 0);
-                node_ref lo = bdd_map.find(bdd.lo)->second;
+                nodes.push_back(level_find(l->index, t, f));
+        }
+        return nodes[root];
+    }
 
-                assert(bdd_map.count(bdd.hi) > 0);
-                node_ref hi = bdd_map.find(bdd.hi)->second;
+    node_ref bdd_mgr::rebase_variables(node_ref p, const std::vector<size_t>& var_map)
+    {
+        if(p.is_terminal())
+            return p;
+        // rename the variables of a flat copy, importing it again takes the unique table path wherever the order is kept.
+        // The copy is kept per thread, so that its buffers are reused while rebases of different managers and threads stay apart
+        thread_local bdd_collection instructions;
+        instructions.clear();
+        const size_t bdd_nr = instructions.add_bdd(p);
+
+        // maps keeping the order along every arc are carried out on the copy directly, as are maps merging variables
+        const auto [begin, end] = instructions.get_bdd_instructions(bdd_nr);
+        const size_t first = instructions.offset(*begin);
+        std::vector<char> in_support(nr_variables(), 0);
+        bool order_kept = true;
+        for(auto it=begin; it!=end; ++it)
+        {
+            if(it->is_terminal())
+                continue;
+            in_support[it->index] = 1;
+            for(const size_t child : {it->lo, it->hi})
+            {
+                const bdd_instruction& c = *(begin + (child - first));
+                order_kept = order_kept && (c.is_terminal() || level(var_map[it->index]) < level(var_map[c.index]));
+            }
+        }
+        std::vector<size_t> support;
+        std::vector<size_t> new_levels;
+        if(!order_kept)
+            for(size_t l=0; l<nr_variables(); ++l)
+                if(in_support[variable(l)])
+                {
+                    support.push_back(variable(l));
+                    new_levels.push_back(level(var_map[variable(l)]));
+                }
+        std::sort(new_levels.begin(), new_levels.end());
+        if(order_kept || std::adjacent_find(new_levels.begin(), new_levels.end()) != new_levels.end())
+        {
+            instructions.rebase(bdd_nr, var_map.begin(), var_map.end());
+            return add_bdd(instructions, bdd_nr);
+        }
+        return permute_variables(instructions, bdd_nr, support, var_map);
+    }
 
-                node_ref node = ite_rec(projection(bdd.index), hi, lo);
+    // Composing node by node with ite builds intermediate results far larger than the result when many levels are reversed.
+    // Instead the copy is imported in order into a scratch manager, whose levels are sorted by their new levels, so it can be imported back in order.
+    // Level by level, the variable belonging there is moved up to it by adjacent swaps, as in sifting. Each variable is placed once and the swaps remove one inversion each.
+    node_ref bdd_mgr::permute_variables(bdd_collection& instructions, const size_t bdd_nr, const std::vector<size_t>& support, const std::vector<size_t>& var_map)
+    {
+        bdd_mgr scratch;
+        const size_t k = support.size();
+        for(size_t i=0; i<k; ++i)
+            scratch.add_variable();
+
+        // the i-th variable of the bdd is variable i of the scratch manager
+        std::vector<size_t> to_scratch(nr_variables(), 0);
+        std::vector<size_t> by_target(k);
+        for(size_t i=0; i<k; ++i)
+        {
+            to_scratch[support[i]] = i;
+            by_target[i] = i;
+        }
+        std::sort(by_target.begin(), by_target.end(), [&](const size_t i, const size_t j) { return level(var_map[support[i]]) < level(var_map[support[j]]); });
+        instructions.rebase(bdd_nr, to_scratch.begin(), to_scratch.end());
+        node_ref q = scratch.add_bdd(instructions, bdd_nr);
+
+        for(size_t l=0; l<k; ++l)
+            for(size_t from=scratch.level(by_target[l]); from>l; --from)
+                scratch.swap_levels(from-1);
+
+        std::vector<size_t> from_scratch(k, 0);
+        for(size_t i=0; i<k; ++i)
+            from_scratch[i] = var_map[support[i]];
+        instructions.clear();
+        const size_t sorted_nr = instructions.add_bdd(q);
+        instructions.rebase(sorted_nr, from_scratch.begin(), from_scratch.end());
+        return add_bdd(instructions, sorted_nr);
+    }
 
-                bdd_map.insert({bdd_col.offset(bdd), node});
+    node_ref bdd_mgr::add_bdd(const bdd_instruction* instructions, const size_t begin, const size_t end)
+    {
+        assert(begin < end);
+        // indices of the instructions are variables, nodes are placed at their levels in the current order
+        operation_scope scope(*this, false);
+        std::vector<node_ref> nodes(end - begin);
+        for(std::ptrdiff_t i=end-1; i>=std::ptrdiff_t(begin); --i)
+        {
+            const bdd_instruction& bdd = instructions[i];
+            node_ref& f = nodes[i - begin];
+            if(bdd.is_botsink())
+                f = botsink();
+            else if(bdd.is_topsink())
+                f = topsink();
+            else
+            {
+                assert(bdd.lo > std::size_t(i) && bdd.lo < end);
+                assert(bdd.hi > std::size_t(i) && bdd.hi < end);
+                const node_ref& lo = nodes[bdd.lo - begin];
+                const node_ref& hi = nodes[bdd.hi - begin];
+                for(size_t v=nr_variables(); v<=bdd.index; ++v)
+                    add_variable();
+                const size_t l = level(bdd.index);
+                if(l < lo.level() && l < hi.level())
+                    f = level_find(l, lo, hi);
+                else // e.g. after rebasing the instructions with a map not preserving the order
+                    f = ite_rec(level_find(l, botsink(), topsink()), hi, lo);
             }
         }
-        assert(bdd_map.count(bdd_col.offset(*bdd_begin)) > 0);
-        return bdd_map.find(bdd_col.offset(*bdd_begin))->second;
+        return nodes[0];
     }
 
 
@@ -1,9 +1,11 @@
 #include "bdd_node.h"
 #include "bdd_mgr.h"
+#include "bdd_flat_hash_map.h"
 #include <cassert>
 #include <algorithm>
 #include <cstring>
 #include <deque>
+#include <limits>
 
 namespace BDD {
 
@@ -16,17 +18,24 @@ namespace BDD {
         assert(v < std::pow(2,logvarsize));
         lo = l;
         hi = h;
-        hi->xref++;
-        lo->xref++;
+        hi->inc_xref();
+        lo->inc_xref();
         index = v;
         marked_ = 0;
         xref = 0;
+#ifndef LBDD_CONCURRENT
+        ++*page_header()->dead_nodes; // nodes are born dead until referenced
+#endif
+        const std::size_t max_depth = std::max(l->depth(), h->depth());
+        depth_ = max_depth == max_node_depth ? max_depth : max_depth + 1;
 
-        static std::random_device rd;
-        static std::mt19937 unique_table_gen(rd());
-        static std::uniform_int_distribution<std::size_t> unique_table_distribution(0,hashtablesize-1);
+#ifndef LBDD_COMPACT_NODES
+        static thread_local std::random_device rd;
+        static thread_local std::mt19937 unique_table_gen(rd());
+        static thread_local std::uniform_int_distribution<std::size_t> unique_table_distribution(0,hashtablesize-1);
 
-        hash_key = unique_table_distribution(unique_table_gen);
+        hash_key_ = unique_table_distribution(unique_table_gen);
+#endif
 
     }
 
@@ -115,29 +124,39 @@ namespace BDD {
     void node::init_botsink(bdd_mgr* mgr)
     {
         this->bdd_mgr_1 = mgr;
+#ifndef LBDD_COMPACT_NODES
         this->bdd_mgr_2 = mgr;
+#endif
         this->xref = 1;
         this->index = botsink_index;
+        this->depth_ = 0;
     }
 
     bool node::is_botsink() const
     {
+#ifndef LBDD_COMPACT_NODES
         assert((this->index == topsink_index || this->index == botsink_index) == (this->lo == this->hi));
+#endif
         return (this->index == botsink_index);
     }
 
     void node::init_topsink(bdd_mgr* mgr)
     {
         this->bdd_mgr_1 = mgr;
+#ifndef LBDD_COMPACT_NODES
         this->bdd_mgr_2 = mgr;
+#endif
         this->xref = 1;
         this->index = topsink_index;
+        this->depth_ = 0;
 
     }
 
     bool node::is_topsink() const
     {
+#ifndef LBDD_COMPACT_NODES
         assert((this->index == topsink_index || this->index == botsink_index) == (this->lo == this->hi));
+#endif
         return (this->index == topsink_index);
     }
 
@@ -215,6 +234,89 @@ namespace BDD {
         return false; 
     }
 
+    namespace {
+
+        // nodes of a bdd in topological order, root first and terminals last, for model counting
+        // After reordering, nodes are given the rank of their level among the levels of variables 0,...,nr_vars-1, so that arcs skip as many counted variables as in the variable order
+        struct node_count_view {
+            node_count_view(node_struct* root, const size_t nr_vars)
+            {
+                if(!root->is_terminal())
+                {
+                    nodes = root->nodes_postorder();
+                    std::reverse(nodes.begin(), nodes.end());
+                }
+                else
+                    nodes.push_back(root);
+                mgr = root->find_bdd_mgr();
+                for(node_struct* terminal : {mgr->get_node_cache().botsink(), mgr->get_node_cache().topsink()})
+                    if(terminal != root)
+                        nodes.push_back(terminal);
+                for(size_t i=0; i<nodes.size(); ++i)
+                    positions.insert(nodes[i], i);
+
+                if(mgr->variables_reordered())
+                {
+                    const size_t n = mgr->nr_variables();
+                    std::vector<char> counted(n, 0);
+                    for(size_t v=0; v<std::min(nr_vars, n); ++v)
+                        counted[mgr->level(v)] = 1;
+                    ranks.resize(n);
+                    size_t r = 0;
+                    for(size_t l=0; l<n; ++l)
+                    {
+                        ranks[l] = r;
+                        r += counted[l];
+                    }
+                }
+            }
+
+            // rank of the level of variable var, variables beyond those of the manager keep their number
+            size_t rank(const size_t var) const { return ranks.empty() || var >= ranks.size() ? var : ranks[mgr->level(var)]; }
+
+            size_t size() const { return nodes.size(); }
+            size_t variable(const size_t i) const { return ranks.empty() ? nodes[i]->index : ranks[nodes[i]->index]; }
+            size_t lo(const size_t i) const { return *positions.find(nodes[i]->lo); }
+            size_t hi(const size_t i) const { return *positions.find(nodes[i]->hi); }
+            bool is_topsink(const size_t i) const { return nodes[i]->is_topsink(); }
+            bool is_botsink(const size_t i) const { return nodes[i]->is_botsink(); }
+
+            bdd_mgr* mgr;
+            std::vector<node_struct*> nodes;
+            mutable flat_hash_map<node_struct*, size_t, std::hash<node_struct*>> positions;
+            std::vector<size_t> ranks; // rank of each level, empty if levels and variables coincide
+        };
+
+    }
+
+    template<typename COUNT>
+    COUNT node_struct::model_count(const std::size_t nr_vars)
+    {
+        return detail::model_count<COUNT>(node_count_view(this, nr_vars), nr_vars);
+    }
+
+    template<typename COUNT>
+    std::vector<COUNT> node_struct::positive_counts(const std::size_t nr_vars)
+    {
+        const node_count_view view(this, nr_vars);
+        std::vector<COUNT> counts = detail::positive_counts<COUNT>(view, nr_vars);
+        if(view.ranks.empty())
+            return counts;
+        std::vector<COUNT> variable_counts;
+        variable_counts.reserve(nr_vars);
+        for(size_t v=0; v<nr_vars; ++v)
+            variable_counts.push_back(counts[view.rank(v)]);
+        return variable_counts;
+    }
+
+    // explicit instantiation of model counting
+    template double node_struct::model_count<double>(const std::size_t nr_vars);
+    template log2_count node_struct::model_count<log2_count>(const std::size_t nr_vars);
+    template big_uint node_struct::model_count<big_uint>(const std::size_t nr_vars);
+    template std::vector<double> node_struct::positive_counts<double>(const std::size_t nr_vars);
+    template std::vector<log2_count> node_struct::positive_counts<log2_count>(const std::size_t nr_vars);
+    template std::vector<big_uint> node_struct::positive_counts<big_uint>(const std::size_t nr_vars);
+
     // TODO: make implementations operate without stack
     void node_struct::recursively_revive()
     {
@@ -254,33 +356,35 @@ namespace BDD {
 
     bdd_mgr* node_struct::find_bdd_mgr()
     {
-        if(is_terminal())
-            return bdd_mgr_1;
-        if(lo->is_terminal())
-            return lo->bdd_mgr_1;
-        return hi->find_bdd_mgr(); 
+        // follow hi arcs down to a terminal without recursion, deep bdds would overflow the stack
+        node_struct* p = this;
+        while(!p->is_terminal() && !p->lo->is_terminal())
+            p = p->hi;
+        if(p->is_terminal())
+            return p->bdd_mgr_1;
+        return p->lo->bdd_mgr_1;
     }
 
     node_ref::node_ref(node* p)
         : ref(p)
     {
         if(ref != nullptr)
-            ref->xref++;
+            ref->inc_xref();
     }
 
     node_ref::node_ref(const node_ref& o)
         : ref(o.ref)
     {
         if(ref != nullptr)
-            ref->xref++;
+            ref->inc_xref();
     }
 
     node_ref::~node_ref()
     {
         if(ref != nullptr) 
         {
-            assert(ref->xref > 0);
-            ref->xref--;
+            assert(ref->reference_count() > 0);
+            ref->dec_xref();
         }
     }
 
@@ -296,10 +400,10 @@ namespace BDD {
     node_ref& node_ref::operator=(const node_ref& o)
     { 
         if(ref != nullptr)
-            ref->xref--;
+            ref->dec_xref();
         ref = o.ref;
         if(ref != nullptr)
-            ref->xref++;
+            ref->inc_xref();
         return *this;
     }
 
@@ -336,6 +440,37 @@ namespace BDD {
         return node_refs;
     }
 
+    // defined here and not in bdd_mgr.cpp, so that bdd_node does not pull bdd_mgr into every link
+    std::atomic<size_t> bdd_mgr::nr_reordered_mgrs_(0);
+
+    const size_t* node_struct::level_variables()
+    {
+        // finding the manager walks down to a terminal, which is only needed while some manager has moved variables
+        if(bdd_mgr::nr_reordered_mgrs_.load(std::memory_order_relaxed) == 0)
+            return nullptr;
+        return find_bdd_mgr()->level_variables();
+    }
+
+    size_t node_ref::variable() const
+    {
+        if(ref->is_terminal())
+            return ref->index;
+        const size_t* variables = ref->level_variables();
+        return variables == nullptr ? ref->index : variables[ref->index];
+    }
+
+    std::vector<size_t> node_ref::variables()
+    {
+        std::vector<size_t> v = ref->variables();
+        if(const size_t* variables = ref->level_variables())
+        {
+            for(size_t& x : v)
+                x = variables[x];
+            std::sort(v.begin(), v.end());
+        }
+        return v;
+    }
+
     node_ref node_ref::botsink() 
     { 
         return node_ref(find_bdd_mgr()->botsink()); 
@@ -1,55 +1,374 @@
 #include "bdd_node_cache.h"
 #include <cassert>
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+#ifdef LBDD_COMPACT_NODES
+#include <sys/mman.h>
+#endif
 
 namespace BDD {
 
+#ifdef LBDD_COMPACT_NODES
+    node_struct* compact_node_base = nullptr;
+
+    namespace {
+        struct compact_node_arena_state {
+            std::mutex mutex;
+            size_t nr_pages = 0; // pages handed out so far, reused pages excluded
+            std::vector<bdd_node_page*> free_pages;
+
+            compact_node_arena_state()
+            {
+                static_assert(sizeof(bdd_node_page) == bdd_node_page_size * sizeof(node));
+                void* mem = mmap(nullptr, compact_node_arena_size * sizeof(node), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+                if(mem == MAP_FAILED)
+                    throw std::runtime_error("Cannot reserve address space for compact node arena.");
+                compact_node_base = static_cast<node*>(mem);
+            }
+        };
+
+        compact_node_arena_state& arena_state()
+        {
+            static compact_node_arena_state state;
+            return state;
+        }
+    }
+
+    bdd_node_page* compact_node_arena::reserve_page()
+    {
+        compact_node_arena_state& state = arena_state();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if(!state.free_pages.empty())
+        {
+            bdd_node_page* p = state.free_pages.back();
+            state.free_pages.pop_back();
+            return p;
+        }
+        if(state.nr_pages == compact_node_arena_size / bdd_node_page_size)
+            throw std::runtime_error("Compact node arena exhausted.");
+        return reinterpret_cast<bdd_node_page*>(compact_node_base) + state.nr_pages++;
+    }
+
+    void compact_node_arena::free_page(bdd_node_page* p)
+    {
+        compact_node_arena_state& state = arena_state();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        // give physical memory back to the os
+        madvise(p, sizeof(bdd_node_page), MADV_DONTNEED);
+        state.free_pages.push_back(p);
+    }
+#endif
+
+    namespace {
+        bdd_node_page* allocate_node_page()
+        {
+#ifdef LBDD_COMPACT_NODES
+            return compact_node_arena::reserve_page();
+#else
+            return new bdd_node_page;
+#endif
+        }
+
+        void deallocate_node_page(bdd_node_page* p)
+        {
+#ifdef LBDD_COMPACT_NODES
+            compact_node_arena::free_page(p);
+#else
+            delete p;
+#endif
+        }
+    }
+
+#ifdef LBDD_CONCURRENT
+    namespace {
+        std::atomic<size_t> node_cache_counter(0);
+
+        // caches alive, exiting threads hand their magazines back only to these
+        struct node_cache_registry {
+            std::mutex mutex;
+            std::unordered_map<size_t, bdd_node_cache*> caches;
+        };
+
+        node_cache_registry& registry()
+        {
+            static node_cache_registry r;
+            return r;
+        }
+    }
+
+    // nodes reserved by one thread from one cache. Holds nodes from a contiguous range of a page and freed nodes.
+    struct node_magazine {
+        size_t cache_id;
+        node* next = nullptr; // next unused node of range
+        node* end = nullptr;
+        node* avail = nullptr; // stack of freed nodes
+        size_t nr_avail = 0;
+    };
+
+    // magazines of one thread, one per cache it has used, the most recently used first
+    struct thread_magazines {
+        std::vector<node_magazine> magazines;
+
+        ~thread_magazines()
+        {
+            node_cache_registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            for(node_magazine& m : magazines)
+            {
+                auto it = r.caches.find(m.cache_id);
+                if(it != r.caches.end())
+                    it->second->return_nodes(m, m.nr_avail);
+            }
+        }
+    };
+
+    thread_local thread_magazines magazines;
+#endif
+
     bdd_node_cache::bdd_node_cache(bdd_mgr* mgr)
+#ifdef LBDD_CONCURRENT
+        : id_(node_cache_counter++)
+#endif
     {
-        static_assert(bdd_node_page_size > 2);
-        mem_node = std::unique_ptr<bdd_node_page>(new bdd_node_page);
-        assert(mem_node.get() != nullptr);
+        static_assert(bdd_node_page_size > 3);
+        static_assert((bdd_node_page_size & (bdd_node_page_size - 1)) == 0);
+        mem_node.push_back(allocate_node_page());
+        assert(mem_node.back() != nullptr);
+        init_page_header(mem_node.back());
 
         // add terminal nodes
-        botsink_ = &mem_node.get()->data[0];
+        botsink_ = &mem_node.back()->data[1];
         botsink_->init_botsink(mgr);
 
-        topsink_ = &mem_node.get()->data[1];
+        topsink_ = &mem_node.back()->data[2];
         topsink_->init_topsink(mgr);
         
         nodeavail = nullptr;
-        nodeptr = &mem_node.get()->data[2];
+        nodeptr = &mem_node.back()->data[3];
+#ifdef LBDD_CONCURRENT
+        node_cache_registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.caches.insert({id_, this});
+#endif
+    }
+
+    bdd_node_cache::~bdd_node_cache()
+    {
+#ifdef LBDD_CONCURRENT
+        {
+            // magazines of other threads for this cache are dropped when they look up a new cache or exit
+            node_cache_registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.caches.erase(id_);
+        }
+#endif
+        for(bdd_node_page* p : mem_node)
+            deallocate_node_page(p);
     }
 
     void bdd_node_cache::increase_cache()
     {
-        std::unique_ptr<bdd_node_page> new_bdd_node_page = std::unique_ptr<bdd_node_page>(new bdd_node_page); 
-        assert(new_bdd_node_page.get() != nullptr);
-        std::swap(new_bdd_node_page.get()->next, mem_node);
-        std::swap(new_bdd_node_page, mem_node);
+        mem_node.push_back(allocate_node_page());
+        assert(mem_node.back() != nullptr);
+
+        init_page_header(mem_node.back());
 
         assert(nodeavail == nullptr);
-        nodeptr = &(mem_node.get()->data[0]);
+        nodeptr = &(mem_node.back()->data[1]);
+    }
+
+    void bdd_node_cache::init_page_header(bdd_node_page* p)
+    {
+        node& header = p->data[0];
+        assert(header.page_header() == &header);
+        header.dead_nodes = &deadnodes;
+        header.index = node::retired_index;
+    }
+
+    std::size_t bdd_node_cache::nr_pages() const
+    {
+#ifdef LBDD_CONCURRENT
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        return mem_node.size();
+    }
+
+    std::size_t bdd_node_cache::peak_nr_nodes() const
+    {
+#ifdef LBDD_CONCURRENT
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        return peak_nodes;
+    }
+
+    std::size_t bdd_node_cache::nr_nodes_created() const
+    {
+#ifdef LBDD_CONCURRENT
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        return nodes_created;
     }
 
+    std::size_t bdd_node_cache::nr_nodes() const
+    {
+#ifdef LBDD_CONCURRENT
+        return __atomic_load_n(&total_nodes, __ATOMIC_RELAXED);
+#else
+        return total_nodes;
+#endif
+    }
+
+#ifdef LBDD_CONCURRENT
+    node_magazine& bdd_node_cache::thread_magazine()
+    {
+        std::vector<node_magazine>& ms = magazines.magazines;
+        if(!ms.empty() && ms.front().cache_id == id_)
+            return ms.front();
+        for(size_t i=1; i<ms.size(); ++i)
+        {
+            if(ms[i].cache_id == id_)
+            {
+                std::swap(ms[0], ms[i]);
+                return ms[0];
+            }
+        }
+
+        // first use of this cache by the thread. Magazines of destroyed caches hold nodes of freed pages and are dropped
+        {
+            node_cache_registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            ms.erase(std::remove_if(ms.begin(), ms.end(), [&](const node_magazine& m) { return r.caches.count(m.cache_id) == 0; }), ms.end());
+        }
+        ms.insert(ms.begin(), node_magazine{id_});
+        return ms.front();
+    }
+
+    void bdd_node_cache::refill_magazine(node_magazine& m)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        assert(m.cache_id == id_);
+        assert(m.avail == nullptr && m.next == m.end);
+
+        // statistics are kept per refill and hence overestimate by at most one magazine per thread
+        auto count_reserved = [&](const size_t n) {
+            nodes_created += n;
+            peak_nodes = std::max(peak_nodes, __atomic_load_n(&total_nodes, __ATOMIC_RELAXED) + n);
+        };
+
+        // move freed nodes into magazine first
+        if(nodeavail != nullptr)
+        {
+            size_t i=0;
+            for(; i<node_magazine_size && nodeavail != nullptr; ++i)
+            {
+                node* p = nodeavail;
+                nodeavail = nodeavail->next_available;
+                p->next_available = m.avail;
+                m.avail = p;
+            }
+            m.nr_avail = i;
+            count_reserved(i);
+            return;
+        }
+
+        node* page_end = &(mem_node.back()->data[0]) + mem_node.back()->data.size();
+        if(nodeptr == page_end)
+        {
+            increase_cache();
+            page_end = &(mem_node.back()->data[0]) + mem_node.back()->data.size();
+        }
+        m.next = nodeptr;
+        m.end = std::min(nodeptr + node_magazine_size, page_end);
+        nodeptr = m.end;
+        count_reserved(std::distance(m.next, m.end));
+    }
+
+    void bdd_node_cache::return_nodes(node_magazine& m, const size_t nr_avail)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        assert(m.cache_id == id_);
+        assert(nr_avail <= m.nr_avail);
+        size_t nr_returned = 0;
+        for(; nr_returned<nr_avail; ++nr_returned)
+        {
+            node* p = m.avail;
+            m.avail = p->next_available;
+            p->next_available = nodeavail;
+            nodeavail = p;
+        }
+        m.nr_avail -= nr_avail;
+        if(m.nr_avail == 0)
+        {
+            for(; m.next != m.end; ++m.next, ++nr_returned)
+            {
+                m.next->next_available = nodeavail;
+                nodeavail = m.next;
+            }
+        }
+        // returned nodes were counted as reserved at refill
+        nodes_created -= nr_returned;
+    }
+
+    node* bdd_node_cache::reserve_node()
+    {
+        node_magazine& m = thread_magazine();
+        if(m.avail == nullptr && m.next == m.end)
+            refill_magazine(m);
+        __atomic_fetch_add(&total_nodes, 1, __ATOMIC_RELAXED);
+        if(m.avail != nullptr)
+        {
+            node* r = m.avail;
+            m.avail = r->next_available;
+            --m.nr_avail;
+            return r;
+        }
+        assert(m.next < m.end);
+        return m.next++;
+    }
+
+    void bdd_node_cache::free_node(node* p)
+    {
+        assert(p->reference_count() <= 0);
+        assert(p->lo->reference_count() > 0);
+        p->lo->dec_xref();
+        assert(p->hi->reference_count() > 0);
+        p->hi->dec_xref();
+        __atomic_fetch_sub(&total_nodes, 1, __ATOMIC_RELAXED);
+
+        // freed node goes to magazine of calling thread, a magazine holding more than two refills gives one back to the shared free list
+        node_magazine& m = thread_magazine();
+        p->next_available = m.avail;
+        m.avail = p;
+        if(++m.nr_avail > 2*node_magazine_size)
+            return_nodes(m, node_magazine_size);
+    }
+#else
     node* bdd_node_cache::reserve_node()
     {
         total_nodes++;
+        peak_nodes = std::max(peak_nodes, total_nodes);
         node* r = nodeavail;
         if(r != nullptr)
         {
             nodeavail = nodeavail->next_available;
             assert(r != nullptr);
+            ++nodes_created;
             return r;
         }
         else
         {
             r = nodeptr;
-            assert(&(mem_node.get()->data[0]) <= nodeptr);
-            assert(&(mem_node.get()->data[0]) + mem_node.get()->data.size() >= nodeptr);
-            if(std::distance(&(mem_node.get()->data[0]), nodeptr) < mem_node.get()->data.size())
+            assert(&(mem_node.back()->data[0]) <= nodeptr);
+            assert(&(mem_node.back()->data[0]) + mem_node.back()->data.size() >= nodeptr);
+            if(std::distance(&(mem_node.back()->data[0]), nodeptr) < mem_node.back()->data.size())
             {
                 nodeptr++;
                 assert(r != nullptr);
+                ++nodes_created;
                 return r;
             }
             else
@@ -67,13 +386,53 @@ namespace BDD {
     {
         assert(p->xref <= 0);
         assert(p->lo->xref > 0);
-        p->lo->xref--;
+        p->lo->dec_xref();
         assert(p->hi->xref > 0);
-        p->hi->xref--;
+        p->hi->dec_xref();
+        --*p->page_header()->dead_nodes;
         p->next_available = nodeavail;
         nodeavail = p;
         total_nodes--;
     }
 
+    std::size_t bdd_node_cache::nr_dead_nodes() const
+    {
+        return deadnodes > 0 ? deadnodes : 0;
+    }
+#endif
+
+    void bdd_node_cache::retire_node(node* p)
+    {
+        assert(p->reference_count() <= 0);
+        assert(p->lo->reference_count() > 0);
+        p->lo->dec_xref();
+        assert(p->hi->reference_count() > 0);
+        p->hi->dec_xref();
+#ifdef LBDD_CONCURRENT
+        __atomic_fetch_sub(&total_nodes, 1, __ATOMIC_RELAXED);
+        std::lock_guard<std::mutex> lock(mutex_);
+#else
+        --*p->page_header()->dead_nodes;
+        total_nodes--;
+#endif
+        p->index = node::retired_index;
+        p->next_available = retired_;
+        retired_ = p;
+    }
+
+    void bdd_node_cache::release_retired_nodes()
+    {
+#ifdef LBDD_CONCURRENT
+        std::lock_guard<std::mutex> lock(mutex_);
+#endif
+        while(retired_ != nullptr)
+        {
+            node* p = retired_;
+            retired_ = retired_->next_available;
+            p->next_available = nodeavail;
+            nodeavail = p;
+        }
+    }
+
 
 }
@@ -0,0 +1,148 @@
+#include "bdd_shared_collection.h"
+#include <algorithm>
+#include <cassert>
+
+namespace BDD {
+
+    size_t bdd_shared_collection::offset(const bdd_instruction& instr) const
+    {
+        const std::ptrdiff_t position = std::distance(bdd_instructions.data(), &instr);
+        assert(position >= 0 && size_t(position) < bdd_instructions.size());
+        return position;
+    }
+
+    void bdd_shared_collection::add_block()
+    {
+        assert(block_delimiters.back() == bdd_instructions.size());
+        assert(import_nodes.empty() && import_stack.empty());
+
+        // as in bdd_collection::add_bdd the postorder position of each visited node is stored in its depth field, or in a hash map for compact nodes
+#ifdef LBDD_COMPACT_NODES
+        auto set_position = [&](node* p, const size_t pos) { import_positions.insert(p, pos); };
+        auto position = [&](node* p) { return *import_positions.find(p); };
+#else
+        auto set_position = [](node* p, const size_t pos) { assert(pos <= max_node_depth); p->depth_ = pos; };
+        auto position = [](node* p) -> size_t { return p->depth_; };
+#endif
+
+        // one iterative depth first search from all roots, nodes reached from an earlier root are not visited again
+        auto visit = [&](node* p) {
+            if(p->is_terminal() || p->marked_)
+                return false;
+            p->marked_ = 1;
+            import_stack.push_back(p);
+            return true;
+        };
+        for(node* root : import_roots)
+        {
+            visit(root);
+            while(!import_stack.empty())
+            {
+                node* p = import_stack.back();
+                if(visit(p->lo) || visit(p->hi))
+                    continue;
+                import_stack.pop_back();
+                set_position(p, import_nodes.size());
+                import_nodes.push_back(p);
+            }
+        }
+
+        // instructions in reverse postorder, which is topological for the whole DAG, followed by botsink and topsink. Instructions hold variables as in bdd_collection::add_bdd
+        const size_t offset = bdd_instructions.size();
+        const size_t n = import_nodes.size();
+        const bdd_mgr* mgr = import_roots.empty() ? nullptr : import_roots.front()->find_bdd_mgr();
+        const bool reordered = mgr != nullptr && mgr->variables_reordered();
+        auto instruction_index = [&](node* p) -> size_t {
+            if(p->is_botsink())
+                return offset + n;
+            if(p->is_topsink())
+                return offset + n + 1;
+            return offset + n - 1 - position(p);
+        };
+        bdd_instructions.resize(offset + n + 2);
+        for(size_t pos=0; pos<n; ++pos)
+        {
+            node* p = import_nodes[pos];
+            bdd_instructions[offset + n - 1 - pos] = bdd_instruction{instruction_index(p->lo), instruction_index(p->hi), reordered ? mgr->variable(p->index) : p->index};
+        }
+        bdd_instructions[offset + n] = bdd_instruction::botsink();
+        bdd_instructions[offset + n + 1] = bdd_instruction::topsink();
+        for(node* root : import_roots)
+        {
+            roots.push_back(instruction_index(root));
+            root_blocks.push_back(block_delimiters.size()-1);
+            bdd_positions.emplace_back();
+            bdd_view_instructions.emplace_back();
+        }
+        block_delimiters.push_back(bdd_instructions.size());
+
+        // clean-up. In postorder the depths of the children are restored before those of their parents
+        for(node* p : import_nodes)
+        {
+            p->marked_ = 0;
+#ifndef LBDD_COMPACT_NODES
+            const std::size_t max_depth = std::max(p->lo->depth(), p->hi->depth());
+            p->depth_ = max_depth == max_node_depth ? max_depth : max_depth + 1;
+#endif
+        }
+#ifdef LBDD_COMPACT_NODES
+        import_positions.clear();
+#endif
+        import_nodes.clear();
+    }
+
+    bdd_shared_collection::bdd_view bdd_shared_collection::get_bdd_instructions(const size_t bdd_nr) const
+    {
+        assert(bdd_nr < nr_bdds());
+        if(!bdd_positions[bdd_nr].empty())
+            return bdd_view(bdd_instructions.data(), bdd_positions[bdd_nr]);
+
+        // reachable positions by depth first search, sorting them restores the topological order of the block
+        const size_t block_end = block_delimiters[root_blocks[bdd_nr]+1];
+        std::vector<size_t> positions = {roots[bdd_nr], block_end-2, block_end-1};
+        std::vector<size_t> stack = {roots[bdd_nr]};
+        flat_hash_map<size_t, char, std::hash<size_t>> visited;
+        visited.insert(roots[bdd_nr], 1);
+        while(!stack.empty())
+        {
+            const bdd_instruction& instr = bdd_instructions[stack.back()];
+            stack.pop_back();
+            for(const size_t child : {instr.lo, instr.hi})
+            {
+                if(bdd_instructions[child].is_terminal() || visited.find(child) != nullptr)
+                    continue;
+                visited.insert(child, 1);
+                positions.push_back(child);
+                stack.push_back(child);
+            }
+        }
+        std::sort(positions.begin(), positions.end());
+
+        // a contiguous copy of the view with arcs relative to it, for batch evaluation and export
+        auto view_index = [&](const size_t position) -> size_t {
+            return std::lower_bound(positions.begin(), positions.end(), position) - positions.begin();
+        };
+        std::vector<bdd_instruction>& instructions = bdd_view_instructions[bdd_nr];
+        instructions.reserve(positions.size());
+        for(const size_t position : positions)
+        {
+            const bdd_instruction& instr = bdd_instructions[position];
+            if(instr.is_terminal())
+                instructions.push_back(instr);
+            else
+                instructions.push_back({view_index(instr.lo), view_index(instr.hi), instr.index});
+        }
+
+        bdd_positions[bdd_nr] = std::move(positions);
+        return bdd_view(bdd_instructions.data(), bdd_positions[bdd_nr]);
+    }
+
+    node_ref bdd_shared_collection::export_bdd(bdd_mgr& mgr, const size_t bdd_nr) const
+    {
+        // the relative copy of the view is imported by one unique table lookup per node
+        get_bdd_instructions(bdd_nr);
+        const std::vector<bdd_instruction>& instructions = bdd_view_instructions[bdd_nr];
+        return mgr.add_bdd(instructions.data(), 0, instructions.size());
+    }
+
+}
@@ -0,0 +1,118 @@
+#include "bdd_task_pool.h"
+#include <cassert>
+#include <chrono>
+
+namespace BDD {
+
+    namespace {
+        // pool and index of deque the current thread works on
+        thread_local const bdd_task_pool* current_pool = nullptr;
+        thread_local size_t current_deque = 0;
+        thread_local size_t current_nesting = 0;
+    }
+
+    bdd_task_pool::bdd_task_pool(const size_t nr_threads)
+    {
+        assert(nr_threads > 0);
+        for(size_t i=0; i<nr_threads; ++i)
+            deques.push_back(std::make_unique<task_deque>());
+        for(size_t i=0; i+1<nr_threads; ++i)
+            workers.emplace_back([this, i]() { worker_loop(i); });
+    }
+
+    bdd_task_pool::~bdd_task_pool()
+    {
+        stop = true;
+        sleep_cv.notify_all();
+        for(auto& w : workers)
+            w.join();
+    }
+
+    bdd_task_pool::task_deque& bdd_task_pool::own_deque()
+    {
+        if(current_pool == this)
+            return *deques[current_deque];
+        return *deques.back();
+    }
+
+    void bdd_task_pool::push(task* t)
+    {
+        task_deque& d = own_deque();
+        {
+            std::lock_guard<std::mutex> lock(d.mutex);
+            d.tasks.push_back(t);
+        }
+        nr_queued++;
+        sleep_cv.notify_one();
+    }
+
+    bdd_task_pool::task* bdd_task_pool::pop_back()
+    {
+        task_deque& d = own_deque();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        if(d.tasks.empty())
+            return nullptr;
+        task* t = d.tasks.back();
+        d.tasks.pop_back();
+        nr_queued--;
+        return t;
+    }
+
+    bdd_task_pool::task* bdd_task_pool::steal()
+    {
+        if(nr_queued.load(std::memory_order_relaxed) == 0)
+            return nullptr;
+        const size_t start = current_pool == this ? current_deque : 0;
+        for(size_t k=0; k<deques.size(); ++k)
+        {
+            task_deque& d = *deques[(start + k) % deques.size()];
+            std::lock_guard<std::mutex> lock(d.mutex);
+            if(!d.tasks.empty())
+            {
+                task* t = d.tasks.front();
+                d.tasks.pop_front();
+                nr_queued--;
+                return t;
+            }
+        }
+        return nullptr;
+    }
+
+    size_t bdd_task_pool::nesting()
+    {
+        return current_nesting;
+    }
+
+    void bdd_task_pool::set_nesting(const size_t n)
+    {
+        current_nesting = n;
+    }
+
+    void bdd_task_pool::execute(task* t)
+    {
+        const size_t outer_nesting = current_nesting;
+        current_nesting = t->nesting;
+        t->run(t->data);
+        current_nesting = outer_nesting;
+        t->done.store(true, std::memory_order_release);
+    }
+
+    void bdd_task_pool::worker_loop(const size_t i)
+    {
+        current_pool = this;
+        current_deque = i;
+        while(!stop)
+        {
+            task* t = steal();
+            if(t != nullptr)
+            {
+                execute(t);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            // timeout guards against wake ups lost between checking and waiting
+            sleep_cv.wait_for(lock, std::chrono::milliseconds(1), [&]() { return stop || nr_queued > 0; });
+        }
+    }
+
+}
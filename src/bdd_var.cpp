@@ -38,22 +38,22 @@ namespace BDD {
     {
         unique_table_page_caches& cache = bdd_mgr_.get_unique_table_page_cache();
         switch(new_mask) {
-            case 63: return reinterpret_cast<node**>(cache.cache_128.reserve_page()); 
-            case 127: return reinterpret_cast<node**>(cache.cache_256.reserve_page());
-            case 255: return reinterpret_cast<node**>(cache.cache_512.reserve_page());
-            case 511: return reinterpret_cast<node**>(cache.cache_1024.reserve_page());
-            case 1023: return reinterpret_cast<node**>(cache.cache_2048.reserve_page());
-            case 2047: return reinterpret_cast<node**>(cache.cache_4096.reserve_page());
-            case 4095: return reinterpret_cast<node**>(cache.cache_8192.reserve_page());
-            case 8191: return reinterpret_cast<node**>(cache.cache_16384.reserve_page());
-            case 16383: return reinterpret_cast<node**>(cache.cache_32768.reserve_page());
-            case 32767: return reinterpret_cast<node**>(cache.cache_65536.reserve_page());
-            case 65535: return reinterpret_cast<node**>(cache.cache_131072.reserve_page());
-            case 131071:return reinterpret_cast<node**>(cache.cache_262144.reserve_page());
+            case 63: return reinterpret_cast<node**>(cache.cache_64.reserve_page()); 
+            case 127: return reinterpret_cast<node**>(cache.cache_128.reserve_page()); 
+            case 255: return reinterpret_cast<node**>(cache.cache_256.reserve_page());
+            case 511: return reinterpret_cast<node**>(cache.cache_512.reserve_page());
+            case 1023: return reinterpret_cast<node**>(cache.cache_1024.reserve_page());
+            case 2047: return reinterpret_cast<node**>(cache.cache_2048.reserve_page());
+            case 4095: return reinterpret_cast<node**>(cache.cache_4096.reserve_page());
+            case 8191: return reinterpret_cast<node**>(cache.cache_8192.reserve_page());
+            case 16383: return reinterpret_cast<node**>(cache.cache_16384.reserve_page());
+            case 32767: return reinterpret_cast<node**>(cache.cache_32768.reserve_page());
+            case 65535: return reinterpret_cast<node**>(cache.cache_65536.reserve_page());
+            case 131071:return reinterpret_cast<node**>(cache.cache_131072.reserve_page());
             case 262143:return reinterpret_cast<node**>(cache.cache_262144.reserve_page());
             case 524287:return reinterpret_cast<node**>(cache.cache_524288.reserve_page());
-            case 1048575: throw std::runtime_error("Cannot increase unique table page cache size.");;
-            default: assert(false);
+            case 1048575:return reinterpret_cast<node**>(cache.cache_1048576.reserve_page());
+            default: throw std::runtime_error("Cannot increase unique table page cache size.");
         } 
     }
 
@@ -115,7 +115,11 @@ namespace BDD {
 
     var_struct::var_struct(const std::size_t index, bdd_mgr& _bdd_mgr)
         : var(index),
+        name(index),
         bdd_mgr_(_bdd_mgr)
+#ifdef LBDD_CONCURRENT
+        , table_mutex(std::make_unique<std::shared_mutex>())
+#endif
     {
         base_64 = _bdd_mgr.get_unique_table_page_cache().cache_64.reserve_page();
         mask = 64-1;
@@ -135,6 +139,9 @@ namespace BDD {
         std::swap(base, o.base);
         std::swap(mask, o.mask);
         std::swap(free, o.free);
+#ifdef LBDD_CONCURRENT
+        std::swap(table_mutex, o.table_mutex);
+#endif
     } 
 
     void var_struct::release_nodes()
@@ -165,7 +172,7 @@ namespace BDD {
 
     std::size_t var_struct::hash_code(node* l, node* r) const
     {
-        return l->hash_key ^ (2*r->hash_key);
+        return l->hash_key() ^ (2*r->hash_key());
     }
 
     size_t var_struct::nr_free_slots_debug() const
@@ -194,6 +201,9 @@ namespace BDD {
 
     double var_struct::occupied_rate() const
     {
+#ifdef LBDD_CONCURRENT
+        return double(hash_table_size() - __atomic_load_n(&free, __ATOMIC_RELAXED)) / double(hash_table_size());
+#endif
         return double(hash_table_size() - free) / double(hash_table_size());
     }
 
@@ -202,79 +212,112 @@ namespace BDD {
         return double(new_page_size - free) / double(new_page_size);
     }
 
-    void var_struct::remove_dead_nodes()
+    void var_struct::remove_dead_nodes(const bool retire)
     {
+        // collect live nodes and free dead ones. Deleting from a linear probing table would require shifting back subsequent entries, rehashing is simpler.
+        std::vector<node*> live_nodes;
         for(std::size_t k = 0; k < hash_table_size(); ++k)
         {
             node* p = fetch_node(k);
-            if(p != nullptr && p->dead())
-            {
+            if(p == nullptr)
+                continue;
+            if(p->dead() && retire)
+                bdd_mgr_.get_node_cache().retire_node(p);
+            else if(p->dead())
                 bdd_mgr_.get_node_cache().free_node(p);
-                store_node(k, nullptr);
-                free++;
-                // move nodes that follow this one back if hash value indicates so
-                size_t first_free_slot = k;
-                for(size_t j = k+1;; ++j)
-                {
-                    const size_t jj = j & mask;
-                    node* p = fetch_node(jj);
-                    if(p == nullptr)
-                    {
-                        k = j;
-                        break;
-                    }
-                    if(p->dead())
-                    {
-                        store_node(jj, nullptr);
-                        free++;
-                    }
-                    else
-                    {
-                        // shift one place up if hash code says so
-                        // TODO: can be made faster.
-                        store_node(next_free_slot(hash_code(p)), p);
-                    }
-                }
-            }
+            else
+                live_nodes.push_back(p);
+            store_node(k, nullptr);
         }
 
         // reduce nr of pages if unique table too sparsely populated
-        if(mask > 63 && occupied_rate() <= min_unique_table_fill)
+        size_t new_mask = mask;
+        while(new_mask > 63 && double(live_nodes.size()) / double((new_mask+1)/2) <= min_unique_table_fill)
+            new_mask = (new_mask+1)/2 - 1;
+
+        if(new_mask != mask)
         {
-            const size_t new_mask = [&]() {
-                size_t n = (mask+1)/2 - 1;
-                while(n >= 63 && occupied_rate(n) >= min_unique_table_fill)
-                    n /= (mask+1)/2 - 1;
-                return n;
-            }();
+            free_page(base, mask);
+            mask = new_mask;
+            base = new_page(mask);
+        }
+
+        free = hash_table_size() - live_nodes.size();
+        for(node* p : live_nodes)
+            store_node(next_free_slot(base_index(hash_code(p))), p);
+        assert(free == nr_free_slots_debug());
+    }
 
-            node** new_base = new_page(new_mask);
+    void var_struct::extract_nodes(std::vector<node*>& nodes)
+    {
+        for(std::size_t k = 0; k < hash_table_size(); ++k)
+        {
+            node* p = fetch_node(k);
+            if(p == nullptr)
+                continue;
+            nodes.push_back(p);
+            store_node(k, nullptr);
+        }
+        free = hash_table_size();
+    }
 
-            for(std::size_t k = 0; k <= mask; ++k)
+    void var_struct::insert_node(node* p)
+    {
+        assert(p->index == var);
+        assert(unique_table_lookup(p->lo, p->hi) == nullptr);
+        if(occupied_rate() > max_unique_table_fill)
+            double_cache();
+        assert(free > 0);
+        --free;
+        store_node(next_free_slot(hash_code(p)), p);
+    }
+
+#ifdef LBDD_CONCURRENT
+    // Readers and inserters hold the table lock shared, only doubling the table takes it exclusively.
+    // New nodes are published by compare-and-swap into an empty slot. If another thread wins the slot with the same node, the reserved node is given back.
+    node* var_struct::unique_find_concurrent(const size_t index, node* l, node* h)
+    {
+        std::shared_lock<std::shared_mutex> lock(*table_mutex);
+        if(occupied_rate() > max_unique_table_fill)
+        {
+            lock.unlock();
             {
-                node* p = fetch_node(k);
-                if(p != nullptr)
-                {
-                    const size_t next_free_slot = [&]() {
-                        for(size_t l=k;; l++)
-                        {
-                            l = l & new_mask;
-                            if(new_base[k] == nullptr)
-                                return l;
-                        }
-                        assert(false);
-                        return size_t(0);
-                    }();
-
-                    new_base[next_free_slot] = p;
-                } 
+                std::unique_lock<std::shared_mutex> exclusive_lock(*table_mutex);
+                if(occupied_rate() > max_unique_table_fill)
+                    double_cache();
             }
+            lock.lock();
+        }
 
-            free_page(base, mask);
-            base = new_base;
-            mask = new_mask;
+        node* p_new = nullptr;
+        for(std::size_t hash = hash_code(l,h);; hash++)
+        {
+            node** slot = base + base_index(hash);
+            node* p = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+            if(p == nullptr)
+            {
+                if(p_new == nullptr)
+                {
+                    p_new = bdd_mgr_.get_node_cache().reserve_node();
+                    assert(p_new != nullptr);
+                    p_new->init_new_node(index,l,h);
+                }
+                if(__atomic_compare_exchange_n(slot, &p, p_new, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                {
+                    __atomic_fetch_sub(&free, 1, __ATOMIC_RELAXED);
+                    return p_new;
+                }
+                // slot was taken concurrently, p holds the node stored there now
+            }
+            if(p->lo == l && p->hi == h)
+            {
+                if(p_new != nullptr)
+                    bdd_mgr_.get_node_cache().free_node(p_new);
+                return p;
+            }
         }
     }
+#endif
 
     node* var_struct::unique_find(const size_t index, node* l, node* h)
     {
@@ -282,6 +325,10 @@ namespace BDD {
         if(l==h)
             return l;
 
+#ifdef LBDD_CONCURRENT
+        return unique_find_concurrent(index, l, h);
+#endif
+
         node* p = unique_table_lookup(l, h);
 
         if(p != nullptr) // node present
@@ -303,13 +350,15 @@ namespace BDD {
         }
         else // node not present
         {
-            // garbage collection
-            //if((++timer % timerinterval) == 0 && (dead_nodes > unique_table_size()/dead_fraction))
-            if((++timer % timerinterval) == 0)
+            // garbage collection. l and h are protected, since the step may rebuild this and other unique tables
+            if((++timer % timerinterval) == 0 && bdd_mgr_.garbage_collection_due())
             {
-                // TODO: implement
-                //remove_dead_nodes();
-                return unique_find(l, h);
+                l->inc_xref();
+                h->inc_xref();
+                bdd_mgr_.garbage_collection_step();
+                l->dec_xref();
+                h->dec_xref();
+                return unique_find(index, l, h);
             }
         }
 
@@ -2,6 +2,9 @@
 
 #include <string>
 #include <stdexcept>
+#include <vector>
+#include <random>
+#include <numeric>
 #include "bdd_mgr.h"
 
 inline void test(const bool cond, const std::string error = "")
@@ -16,3 +19,29 @@ inline void test_labeling(BDD::node_ref p, LABEL_ITERATOR label_begin, LABEL_ITE
     test(p.evaluate(label_begin, label_end) == result, "BDD evaluation error");
 };
 
+// conjunction of random clauses of width three over given variables
+inline BDD::node_ref random_cnf(BDD::bdd_mgr& mgr, const std::vector<size_t>& vars, const size_t nr_clauses, std::mt19937& gen)
+{
+    std::uniform_int_distribution<size_t> var_dist(0, vars.size()-1);
+    std::bernoulli_distribution sign_dist(0.5);
+    BDD::node_ref f = mgr.topsink();
+    for(size_t c=0; c<nr_clauses; ++c)
+    {
+        BDD::node_ref clause = mgr.botsink();
+        for(size_t l=0; l<3; ++l)
+        {
+            const size_t v = vars[var_dist(gen)];
+            clause = mgr.or_rec(clause, sign_dist(gen) ? mgr.projection(v) : mgr.neg_projection(v));
+        }
+        f = mgr.and_rec(f, clause);
+    }
+    return f;
+}
+
+// over variables 0,...,nr_vars-1
+inline BDD::node_ref random_cnf(BDD::bdd_mgr& mgr, const size_t nr_vars, const size_t nr_clauses, std::mt19937& gen)
+{
+    std::vector<size_t> vars(nr_vars);
+    std::iota(vars.begin(), vars.end(), 0);
+    return random_cnf(mgr, vars, nr_clauses, gen);
+}
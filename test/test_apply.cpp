@@ -0,0 +1,115 @@
+#include "bdd_mgr.h"
+#include "bdd_collection.h"
+#include "test.h"
+#include <vector>
+#include <random>
+#include <limits>
+
+using namespace BDD;
+
+template<typename OP>
+void test_operator(bdd_mgr& mgr, node_ref f, node_ref g, node_ref r, const size_t nr_vars)
+{
+    test(mgr.apply<OP>(f, g) == r, "apply differs from named operation");
+    for(size_t a=0; a<(size_t(1) << nr_vars); ++a)
+    {
+        std::vector<char> x(nr_vars);
+        for(size_t i=0; i<nr_vars; ++i)
+            x[i] = (a >> i) & 1;
+        test(r.evaluate(x.begin(), x.end()) == OP::value(f.evaluate(x.begin(), x.end()), g.evaluate(x.begin(), x.end())), "binary operation evaluates wrong");
+    }
+}
+
+template<typename OP>
+void test_collection_operator(bdd_mgr& mgr, bdd_collection& collection, const size_t i, const size_t j, node_ref r)
+{
+    const size_t nr = collection.bdd_apply<OP>(i, j);
+    test((nr == std::numeric_limits<size_t>::max()) == r.is_terminal(), "collection and manager disagree on constant result");
+    test(collection.last_result() != bdd_collection::result_kind::node_limit_exceeded, "collection operation without node limit failed");
+    test((collection.last_result() == bdd_collection::result_kind::constant_true) == r.is_topsink(), "collection and manager disagree on constant true result");
+    test((collection.last_result() == bdd_collection::result_kind::constant_false) == r.is_botsink(), "collection and manager disagree on constant false result");
+    if(nr != std::numeric_limits<size_t>::max())
+    {
+        test(collection.export_bdd(mgr, nr) == r, "collection operation differs from manager");
+        test(collection.nr_bdd_nodes(nr) == r.nr_nodes() + 2, "collection operation not reduced");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 9;
+    bdd_mgr mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+    std::mt19937 gen(11);
+
+    std::vector<node_ref> operands = {mgr.topsink(), mgr.botsink(), mgr.projection(3), mgr.neg_projection(0)};
+    while(operands.size() < 12)
+        operands.push_back(random_cnf(mgr, nr_vars, 2 + operands.size(), gen));
+
+    bdd_collection collection;
+    std::vector<size_t> bdd_nrs;
+    for(node_ref f : operands)
+        bdd_nrs.push_back(f.is_terminal() ? std::numeric_limits<size_t>::max() : collection.add_bdd(f));
+
+    for(size_t i=0; i<operands.size(); ++i)
+    {
+        for(size_t j=0; j<operands.size(); ++j)
+        {
+            node_ref f = operands[i];
+            node_ref g = operands[j];
+            test_operator<and_operator>(mgr, f, g, mgr.and_rec(f, g), nr_vars);
+            test_operator<or_operator>(mgr, f, g, mgr.or_rec(f, g), nr_vars);
+            test_operator<xor_operator>(mgr, f, g, mgr.xor_rec(f, g), nr_vars);
+            test_operator<nand_operator>(mgr, f, g, mgr.nand_rec(f, g), nr_vars);
+            test_operator<implies_operator>(mgr, f, g, mgr.implies_rec(f, g), nr_vars);
+            test_operator<diff_operator>(mgr, f, g, mgr.diff_rec(f, g), nr_vars);
+            test_operator<equiv_operator>(mgr, f, g, mgr.equiv_rec(f, g), nr_vars);
+            test(mgr.or_rec(f, g) != mgr.xor_rec(f, g) || mgr.and_rec(f, g).is_botsink(), "or and xor results mixed up");
+
+            if(f.is_terminal() || g.is_terminal())
+                continue;
+            test_collection_operator<and_operator>(mgr, collection, bdd_nrs[i], bdd_nrs[j], mgr.and_rec(f, g));
+            test_collection_operator<or_operator>(mgr, collection, bdd_nrs[i], bdd_nrs[j], mgr.or_rec(f, g));
+            test_collection_operator<xor_operator>(mgr, collection, bdd_nrs[i], bdd_nrs[j], mgr.xor_rec(f, g));
+            test_collection_operator<implies_operator>(mgr, collection, bdd_nrs[i], bdd_nrs[j], mgr.implies_rec(f, g));
+            test_collection_operator<diff_operator>(mgr, collection, bdd_nrs[i], bdd_nrs[j], mgr.diff_rec(f, g));
+            test_collection_operator<equiv_operator>(mgr, collection, bdd_nrs[i], bdd_nrs[j], mgr.equiv_rec(f, g));
+        }
+    }
+    test(collection.bdd_or(bdd_nrs[4], bdd_nrs[5]) < collection.nr_bdds(), "collection disjunction failed");
+    test(collection.bdd_xor(bdd_nrs[4], bdd_nrs[4]) == std::numeric_limits<size_t>::max(), "constant collection xor not rejected");
+    test(collection.last_result() == bdd_collection::result_kind::constant_false, "constant collection xor not reported");
+    test(collection.bdd_apply<equiv_operator>(bdd_nrs[4], bdd_nrs[4]) == std::numeric_limits<size_t>::max(), "constant collection equivalence not rejected");
+    test(collection.last_result() == bdd_collection::result_kind::constant_true, "constant collection equivalence not reported");
+    test(collection.bdd_or(bdd_nrs[4], bdd_nrs[5], 3) == std::numeric_limits<size_t>::max(), "collection disjunction exceeding node limit succeeded");
+    test(collection.last_result() == bdd_collection::result_kind::node_limit_exceeded, "node limit of collection disjunction not reported");
+
+    // memos of the new operations are kept apart
+    {
+        node_ref f = operands[5];
+        node_ref g = operands[6];
+        const size_t implies_inserts = mgr.memo_statistics()[memo_cache_statistics::operation::implies_op].inserts;
+        mgr.implies_rec(mgr.xor_rec(f, g), mgr.and_rec(f, g));
+        test(mgr.memo_statistics()[memo_cache_statistics::operation::implies_op].inserts > implies_inserts, "implication not memoized under its own tag");
+    }
+
+    // operands deeper than the recursion bound go through the non-recursive kernel
+    {
+        bdd_mgr deep_mgr;
+        const size_t nr_deep_vars = 20000;
+        std::vector<node_ref> x;
+        for(size_t i=0; i<nr_deep_vars; ++i)
+        {
+            deep_mgr.add_variable();
+            x.push_back(deep_mgr.projection(i));
+        }
+        node_ref conj = deep_mgr.and_rec(x.begin(), x.end());
+        node_ref shifted_conj = deep_mgr.and_rec(x.begin()+1, x.end());
+        node_ref diff = deep_mgr.diff_rec(shifted_conj, conj);
+        test(diff == deep_mgr.and_rec(deep_mgr.neg_projection(0), shifted_conj), "deep difference wrong");
+        test(deep_mgr.implies_rec(conj, shifted_conj) == deep_mgr.topsink(), "deep implication wrong");
+        test(deep_mgr.equiv_rec(conj, conj) == deep_mgr.topsink(), "deep equivalence wrong");
+        test(deep_mgr.nand_rec(conj, shifted_conj) == deep_mgr.negate(conj), "deep nand wrong");
+    }
+}
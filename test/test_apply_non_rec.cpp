@@ -0,0 +1,109 @@
+#include "bdd_mgr.h"
+#include "test.h"
+#include <vector>
+#include <random>
+#include <iostream>
+
+using namespace BDD;
+
+// random bdd over given number of variables, built from projections with recursive operations
+node_ref random_bdd(bdd_mgr& mgr, std::mt19937& gen, const size_t nr_vars, const size_t nr_ops)
+{
+    std::uniform_int_distribution<size_t> var_dist(0, nr_vars-1);
+    std::uniform_int_distribution<size_t> op_dist(0, 2);
+    node_ref f = mgr.projection(var_dist(gen));
+    for(size_t i=0; i<nr_ops; ++i)
+    {
+        node_ref p = op_dist(gen) == 0 ? mgr.neg_projection(var_dist(gen)) : mgr.projection(var_dist(gen));
+        if(op_dist(gen) == 0)
+            f = mgr.and_rec(f, p);
+        else
+            f = mgr.or_rec(f, p);
+    }
+    return f;
+}
+
+// walk the path given by labeling without recursion
+template<typename ITERATOR>
+bool evaluate_non_rec(node_ref p, ITERATOR label_begin)
+{
+    node* n = p.address();
+    while(!n->is_terminal())
+        n = *(label_begin + n->index) ? n->hi : n->lo;
+    return n->is_topsink();
+}
+
+int main(int argc, char** argv)
+{
+    // compare with recursive versions on random bdds
+    {
+        std::mt19937 gen(42);
+        const size_t nr_vars = 12;
+        bdd_mgr mgr;
+        for(size_t i=0; i<nr_vars; ++i)
+            mgr.add_variable();
+
+        for(size_t iter=0; iter<50; ++iter)
+        {
+            node_ref f = random_bdd(mgr, gen, nr_vars, 8);
+            node_ref g = random_bdd(mgr, gen, nr_vars, 8);
+            node_ref h = random_bdd(mgr, gen, nr_vars, 8);
+
+            test(mgr.and_non_rec(f, g) == mgr.and_rec(f, g), "non-recursive and differs from recursive and");
+            test(mgr.or_non_rec(f, g) == mgr.or_rec(f, g), "non-recursive or differs from recursive or");
+            test(mgr.ite_non_rec(f, g, h) == mgr.ite_rec(f, g, h), "non-recursive ite differs from recursive ite");
+            test(mgr.ite_non_rec(f, mgr.botsink(), mgr.topsink()) == mgr.negate(f), "non-recursive negation via ite wrong");
+        }
+    }
+
+    // xor
+    {
+        std::mt19937 gen(17);
+        const size_t nr_vars = 10;
+        bdd_mgr mgr;
+        for(size_t i=0; i<nr_vars; ++i)
+            mgr.add_variable();
+
+        for(size_t iter=0; iter<50; ++iter)
+        {
+            node_ref f = random_bdd(mgr, gen, nr_vars, 6);
+            node_ref g = random_bdd(mgr, gen, nr_vars, 6);
+            node_ref x = mgr.xor_non_rec(f, g);
+            test(x == mgr.xor_rec(f, g), "non-recursive xor differs from recursive xor");
+            test(x == mgr.xor_non_rec(g, f), "non-recursive xor not symmetric");
+            test(mgr.xor_non_rec(x, g) == f, "non-recursive xor not invertible");
+            test(mgr.xor_non_rec(mgr.topsink(), f) == mgr.negate(f), "non-recursive negation wrong");
+        }
+    }
+
+    // bdds deeper than what recursion on the default stack can handle
+    {
+        const size_t nr_vars = 200000;
+        bdd_mgr mgr;
+        for(size_t i=0; i<nr_vars; ++i)
+            mgr.add_variable();
+
+        // conjunction and disjunction of all variables, built bottom up
+        node_ref all_true = mgr.topsink();
+        node_ref any_true = mgr.botsink();
+        for(std::ptrdiff_t i=nr_vars-1; i>=0; --i)
+        {
+            all_true = mgr.unique_find(i, mgr.botsink(), all_true);
+            any_true = mgr.unique_find(i, any_true, mgr.topsink());
+        }
+
+        test(mgr.and_non_rec(all_true, any_true) == all_true, "non-recursive and on deep bdd wrong");
+        test(mgr.or_non_rec(all_true, any_true) == any_true, "non-recursive or on deep bdd wrong");
+
+        node_ref x = mgr.xor_non_rec(all_true, any_true);
+        node_ref ite = mgr.ite_non_rec(all_true, mgr.botsink(), any_true);
+        test(x == ite, "non-recursive xor and ite on deep bdd differ");
+
+        std::vector<char> labeling(nr_vars, 0);
+        test(evaluate_non_rec(x, labeling.begin()) == false);
+        labeling[nr_vars/2] = 1;
+        test(evaluate_non_rec(x, labeling.begin()) == true);
+        std::fill(labeling.begin(), labeling.end(), 1);
+        test(evaluate_non_rec(x, labeling.begin()) == false);
+    }
+}
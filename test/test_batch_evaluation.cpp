@@ -0,0 +1,54 @@
+#include "bdd_mgr.h"
+#include "bdd_collection.h"
+#include "test.h"
+#include <vector>
+#include <random>
+
+using namespace BDD;
+
+template<size_t WORDS>
+void test_batch(bdd_collection& collection, node_ref f, const size_t bdd_nr, const size_t nr_vars, std::mt19937& gen)
+{
+    std::vector<assignment_batch<WORDS>> batch(nr_vars);
+    for(auto& b : batch)
+        for(auto& w : b)
+            w = gen() | (std::uint64_t(gen()) << 32);
+
+    const assignment_batch<WORDS> f_result = f.evaluate_batch(batch.begin(), batch.end());
+    const assignment_batch<WORDS> col_result = collection.evaluate_batch(bdd_nr, batch.begin(), batch.end());
+    for(size_t k=0; k<64*WORDS; ++k)
+    {
+        std::vector<char> x(nr_vars);
+        for(size_t i=0; i<nr_vars; ++i)
+            x[i] = (batch[i][k/64] >> (k%64)) & 1;
+        const bool expected = f.evaluate(x.begin(), x.end());
+        test(bool((f_result[k/64] >> (k%64)) & 1) == expected, "batch evaluation of node_ref wrong");
+        test(bool((col_result[k/64] >> (k%64)) & 1) == expected, "batch evaluation of bdd_collection wrong");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 20;
+    bdd_mgr mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+    bdd_collection collection;
+
+    std::mt19937 gen(11);
+    for(size_t round=0; round<20; ++round)
+    {
+        // few clauses give many satisfying assignments, many clauses few
+        node_ref f = random_cnf(mgr, nr_vars, 5 + 3*round, gen);
+        if(f.is_terminal())
+            continue;
+        const size_t bdd_nr = collection.add_bdd(f);
+        test_batch<1>(collection, f, bdd_nr, nr_vars, gen);
+        test_batch<4>(collection, f, bdd_nr, nr_vars, gen);
+    }
+
+    // terminals
+    std::vector<assignment_batch<2>> batch(nr_vars);
+    test(mgr.topsink().evaluate_batch(batch.begin(), batch.end()) == assignment_batch<2>{~std::uint64_t(0), ~std::uint64_t(0)});
+    test(mgr.botsink().evaluate_batch(batch.begin(), batch.end()) == assignment_batch<2>{0, 0});
+}
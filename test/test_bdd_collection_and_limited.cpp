@@ -0,0 +1,50 @@
+#include "bdd_mgr.h"
+#include "bdd_collection.h"
+#include "test.h"
+
+using namespace BDD;
+
+int main(int argc, char** argv)
+{
+    bdd_mgr mgr;
+    bdd_collection collection;
+
+    for(size_t i=0; i<12; ++i)
+        mgr.add_variable();
+
+    std::vector<node_ref> vars;
+    for(size_t i=0; i<12; ++i)
+        vars.push_back(mgr.projection(i));
+
+    // overlapping cardinality constraints, so that reduction is necessary
+    node_ref at_most_4 = mgr.at_most(vars.begin(), vars.begin()+9, 4);
+    node_ref card_2 = mgr.cardinality(vars.begin()+3, vars.end(), 2);
+    node_ref intersect = mgr.and_rec(at_most_4, card_2);
+
+    const size_t at_most_4_nr = collection.add_bdd(at_most_4);
+    const size_t card_2_nr = collection.add_bdd(card_2);
+
+    const size_t intersect_nr = collection.bdd_and(at_most_4_nr, card_2_nr);
+    test(intersect_nr != std::numeric_limits<size_t>::max(), "unlimited bdd_and failed");
+    test(collection.export_bdd(mgr, intersect_nr) == intersect, "bdd_and computes wrong bdd");
+    const size_t nr_nodes = collection.nr_bdd_nodes(intersect_nr);
+    test(nr_nodes == intersect.nr_nodes() + 2, "bdd_and result is not reduced"); // collection counts terminals
+
+    // the product of the sizes bounds the meld requests
+    const size_t request_bound = collection.nr_bdd_nodes(at_most_4_nr) * collection.nr_bdd_nodes(card_2_nr) + 2;
+    const size_t intersect_limited_nr = collection.bdd_and(at_most_4_nr, card_2_nr, request_bound);
+    test(intersect_limited_nr != std::numeric_limits<size_t>::max(), "bdd_and with sufficient node limit failed");
+    test(collection.export_bdd(mgr, intersect_limited_nr) == intersect, "bdd_and with node limit computes wrong bdd");
+
+    // the limit is already checked on the requests, which exceed the reduced result here
+    test(collection.bdd_and(at_most_4_nr, card_2_nr, nr_nodes) == std::numeric_limits<size_t>::max(), "bdd_and with too many requests succeeded");
+
+    // one node below limit
+    const size_t nr_bdds = collection.nr_bdds();
+    test(collection.bdd_and(at_most_4_nr, card_2_nr, nr_nodes-1) == std::numeric_limits<size_t>::max(), "bdd_and exceeding node limit succeeded");
+    test(collection.nr_bdds() == nr_bdds, "aborted bdd_and added bdd");
+
+    // collection is still usable after abort
+    const size_t intersect_again_nr = collection.bdd_and(card_2_nr, at_most_4_nr);
+    test(collection.export_bdd(mgr, intersect_again_nr) == intersect, "bdd_and after abort computes wrong bdd");
+}
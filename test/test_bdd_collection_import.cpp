@@ -0,0 +1,102 @@
+#include "bdd_mgr.h"
+#include "bdd_collection.h"
+#include "test.h"
+#include <vector>
+#include <random>
+
+using namespace BDD;
+
+std::vector<size_t> depths(node_ref f)
+{
+    std::vector<size_t> d;
+    for(node_ref n : f.nodes_postorder())
+        d.push_back(n.depth());
+    return d;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 18;
+    bdd_mgr mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+
+    std::mt19937 gen(3);
+    std::vector<node_ref> roots;
+    while(roots.size() < 10)
+    {
+        node_ref f = random_cnf(mgr, nr_vars, 4 + 3*roots.size(), gen);
+        if(!f.is_terminal())
+            roots.push_back(f);
+    }
+    // overlapping bdds share nodes in the manager, each is imported completely
+    roots.push_back(mgr.and_rec(roots[0], roots[1]));
+    roots.push_back(roots[0]);
+
+    std::vector<std::vector<size_t>> root_depths;
+    for(node_ref f : roots)
+        root_depths.push_back(depths(f));
+
+    bdd_collection collection;
+    const size_t first = collection.add_bdds(roots.begin(), roots.end());
+    test(first == 0, "first imported bdd has wrong number");
+    test(collection.nr_bdds() == roots.size(), "wrong number of imported bdds");
+    for(size_t i=0; i<roots.size(); ++i)
+    {
+        test(collection.nr_bdd_nodes(i) == roots[i].nr_nodes() + 2, "imported bdd has wrong number of nodes");
+        test(collection.export_bdd(mgr, i) == roots[i], "imported bdd differs");
+        test(depths(roots[i]) == root_depths[i], "node depths not restored after import");
+        for(size_t k=0; k<32; ++k)
+        {
+            std::vector<char> x(nr_vars);
+            for(auto& b : x)
+                b = gen() % 2;
+            test(collection.evaluate(i, x.begin(), x.end()) == roots[i].evaluate(x.begin(), x.end()), "imported bdd evaluates wrong");
+        }
+    }
+    const auto [begin_0, end_0] = collection.get_bdd_instructions(0);
+    const auto [begin_last, end_last] = collection.get_bdd_instructions(roots.size()-1);
+    test(std::distance(begin_0, end_0) == std::distance(begin_last, end_last), "repeated import differs in size");
+    for(auto it_0=begin_0, it_last=begin_last; it_0!=end_0; ++it_0, ++it_last)
+    {
+        test(it_0->index == it_last->index, "repeated import differs");
+        if(!it_0->is_terminal())
+            test(it_0->lo - collection.offset(*begin_0) == it_last->lo - collection.offset(*begin_last), "repeated import differs");
+    }
+
+    // back into the manager, directly or, for instructions rebased against the variable order, by ite
+    std::vector<size_t> reversed(nr_vars);
+    for(size_t i=0; i<nr_vars; ++i)
+        reversed[i] = nr_vars-1-i;
+    for(size_t i=0; i<roots.size(); ++i)
+    {
+        test(mgr.add_bdd(collection, i) == roots[i], "bdd imported into manager differs");
+        collection.rebase(i, reversed.begin(), reversed.end());
+        node_ref f = mgr.add_bdd(collection, i);
+        for(size_t k=0; k<32; ++k)
+        {
+            std::vector<char> x(nr_vars);
+            for(auto& b : x)
+                b = gen() % 2;
+            test(f.evaluate(x.begin(), x.end()) == collection.evaluate(i, x.begin(), x.end()), "rebased bdd imported into manager evaluates wrong");
+        }
+    }
+
+    // deep bdd, imported without recursion
+    bdd_mgr deep_mgr;
+    const size_t nr_deep_vars = 100000;
+    std::vector<node_ref> deep_vars;
+    for(size_t i=0; i<nr_deep_vars; ++i)
+    {
+        deep_mgr.add_variable();
+        deep_vars.push_back(deep_mgr.projection(i));
+    }
+    node_ref conj = deep_mgr.and_rec(deep_vars.begin(), deep_vars.end());
+    const size_t conj_depth = conj.depth();
+    bdd_collection deep_collection;
+    deep_collection.add_bdd(conj);
+    test(deep_collection.nr_bdd_nodes(0) == nr_deep_vars + 2, "deep bdd has wrong number of nodes");
+    test(conj.depth() == conj_depth, "depth of deep bdd not restored after import");
+    const std::vector<char> ones(nr_deep_vars, 1);
+    test(deep_collection.evaluate(0, ones.begin(), ones.end()) == true, "deep bdd evaluates wrong");
+}
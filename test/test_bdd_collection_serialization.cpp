@@ -0,0 +1,130 @@
+#include "bdd_mgr.h"
+#include "bdd_collection.h"
+#include "bdd_mapped_collection.h"
+#include "bdd_message_passing.h"
+#include "test.h"
+#include <vector>
+#include <random>
+#include <fstream>
+#include <stdexcept>
+#include <cstdio>
+#include <cstddef>
+#include <unistd.h>
+
+using namespace BDD;
+
+bool fails_to_map(const std::string& filename)
+{
+    try {
+        mapped_bdd_collection m(filename);
+    } catch(const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    const std::string filename = "test_bdd_collection_serialization_" + std::to_string(getpid()) + ".lbdd";
+    const size_t nr_vars = 16;
+    bdd_mgr mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+
+    bdd_collection collection;
+    std::vector<node_ref> bdds;
+    std::mt19937 gen(5);
+    for(size_t i=0; i<12; ++i)
+    {
+        node_ref f = random_cnf(mgr, nr_vars, 2 + 2*i, gen);
+        if(f.is_terminal())
+            continue;
+        bdds.push_back(f);
+        collection.add_bdd(f);
+    }
+    std::vector<size_t> simplex_vars = {1, 4, 7, 9, 12};
+    std::vector<node_ref> simplex_projections;
+    for(const size_t v : simplex_vars)
+        simplex_projections.push_back(mgr.projection(v));
+    bdds.push_back(mgr.simplex(simplex_projections.begin(), simplex_projections.end()));
+    collection.add_bdd(bdds.back());
+
+    collection.save(filename);
+    {
+        mapped_bdd_collection mapped(filename);
+        test(mapped.nr_bdds() == collection.nr_bdds(), "mapped collection has wrong number of bdds");
+        for(size_t bdd_nr=0; bdd_nr<collection.nr_bdds(); ++bdd_nr)
+        {
+            test(mapped.nr_bdd_nodes(bdd_nr) == collection.nr_bdd_nodes(bdd_nr), "mapped bdd has wrong number of nodes");
+            const auto [col_begin, col_end] = collection.get_bdd_instructions(bdd_nr);
+            const auto [map_begin, map_end] = mapped.get_bdd_instructions(bdd_nr);
+            test(std::equal(col_begin, col_end, map_begin, map_end), "mapped instructions differ");
+            test(mapped.offset(*map_begin) == collection.offset(*col_begin), "mapped offsets differ");
+            test(mapped.variables(bdd_nr) == collection.variables(bdd_nr), "mapped variables differ");
+            test(mapped.model_count<big_uint>(bdd_nr, nr_vars) == collection.model_count<big_uint>(bdd_nr, nr_vars), "mapped model count differs");
+            test(mapped.export_bdd(mgr, bdd_nr) == bdds[bdd_nr], "exported mapped bdd differs");
+
+            for(size_t k=0; k<64; ++k)
+            {
+                std::vector<char> x(nr_vars);
+                for(auto& b : x)
+                    b = gen() % 2;
+                test(mapped.evaluate(bdd_nr, x.begin(), x.end()) == bdds[bdd_nr].evaluate(x.begin(), x.end()), "mapped evaluation wrong");
+            }
+            std::vector<assignment_batch<>> batch(nr_vars);
+            for(auto& b : batch)
+                b[0] = gen() | (std::uint64_t(gen()) << 32);
+            test(mapped.evaluate_batch(bdd_nr, batch.begin(), batch.end()) == collection.evaluate_batch(bdd_nr, batch.begin(), batch.end()), "mapped batch evaluation wrong");
+        }
+
+        // message passing runs directly on the mapped bdds
+        bdd_message_passing<sum_product_semiring<double>> mp(mapped);
+        test(mp.nr_bdds() == mapped.nr_bdds(), "message passing over mapped collection has wrong number of bdds");
+
+        // moving keeps the mapping alive
+        mapped_bdd_collection moved(std::move(mapped));
+        test(moved.nr_bdds() == collection.nr_bdds(), "moved mapped collection has wrong number of bdds");
+        const std::vector<char> zero(nr_vars, 0);
+        test(moved.evaluate(moved.nr_bdds()-1, zero.begin(), zero.end()) == false, "moved mapped collection evaluates wrong");
+    }
+
+    // empty collection
+    {
+        bdd_collection empty;
+        empty.save(filename);
+        mapped_bdd_collection mapped(filename);
+        test(mapped.nr_bdds() == 0, "mapped empty collection is not empty");
+    }
+
+    // corrupt files are rejected
+    test(fails_to_map(filename + ".missing"), "missing file was mapped");
+    {
+        std::ofstream f(filename, std::ios::binary | std::ios::trunc);
+        f << "not a bdd collection, but long enough to hold a header";
+    }
+    test(fails_to_map(filename), "file with wrong magic was mapped");
+    collection.save(filename);
+    {
+        std::ofstream f(filename, std::ios::binary | std::ios::app);
+        f << "trailing";
+    }
+    test(fails_to_map(filename), "file with wrong size was mapped");
+
+    // overwrite one word at byte position pos of a freshly saved file
+    auto corrupt = [&](const size_t pos, const size_t word) {
+        collection.save(filename);
+        std::fstream f(filename, std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(pos);
+        f.write(reinterpret_cast<const char*>(&word), sizeof(word));
+    };
+    const size_t delimiters_pos = sizeof(bdd_collection_file_header);
+    const size_t instructions_pos = delimiters_pos + (collection.nr_bdds()+1) * sizeof(size_t);
+    corrupt(delimiters_pos + sizeof(size_t), collection.nr_bdd_nodes(0) + collection.nr_bdd_nodes(1) + 1);
+    test(fails_to_map(filename), "file with decreasing delimiters was mapped");
+    corrupt(instructions_pos + offsetof(bdd_instruction, hi), 0);
+    test(fails_to_map(filename), "file with backward arc was mapped");
+    corrupt(instructions_pos + offsetof(bdd_instruction, lo), collection.nr_bdd_nodes(0));
+    test(fails_to_map(filename), "file with arc into other bdd was mapped");
+
+    std::remove(filename.c_str());
+}
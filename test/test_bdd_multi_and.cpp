@@ -40,4 +40,50 @@ int main(int argc, char** argv)
                                     const std::array<size_t,8> labeling = {l0,l1,l2,l3,l4,l5,l5,l7};
                                         test(simplex_and.evaluate(labeling.begin(), labeling.end()) == collection.evaluate(simplex_and_idx, labeling.begin(), labeling.end()), "bdd collection multi and not correct.");
                                 }
+
+    // hundreds of operands, given more than once
+    {
+        bdd_mgr window_mgr;
+        const size_t nr_vars = 300;
+        std::vector<node_ref> x;
+        for(size_t i=0; i<nr_vars; ++i)
+        {
+            window_mgr.add_variable();
+            x.push_back(window_mgr.projection(i));
+        }
+        bdd_collection window_collection;
+        std::vector<node_ref> windows;
+        std::vector<size_t> window_bdds;
+        for(size_t i=0; i+8<=nr_vars; i+=2)
+        {
+            windows.push_back(window_mgr.at_most(x.begin()+i, x.begin()+i+8, 2));
+            window_bdds.push_back(window_collection.add_bdd(windows.back()));
+        }
+        window_bdds.push_back(window_bdds.front());
+        node_ref windows_and = window_mgr.and_rec(windows.begin(), windows.end());
+
+        const size_t windows_and_idx = window_collection.bdd_and(window_bdds.begin(), window_bdds.end());
+        test(windows_and_idx < window_collection.nr_bdds(), "bdd collection multi and of many bdds failed.");
+        test(window_collection.export_bdd(window_mgr, windows_and_idx) == windows_and, "bdd collection multi and of many bdds not correct.");
+        test(window_collection.nr_bdd_nodes(windows_and_idx) == windows_and.nr_nodes() + 2, "bdd collection multi and of many bdds not reduced.");
+        test(window_collection.bdd_and(window_bdds.begin(), window_bdds.end(), 100) == std::numeric_limits<size_t>::max(), "bdd collection multi and exceeds node limit.");
+        test(window_collection.last_result() == bdd_collection::result_kind::node_limit_exceeded, "bdd collection multi and exceeding node limit not reported.");
+    }
+
+    // constant results are told apart from exceeding the node limit
+    {
+        bdd_collection constant_collection;
+        const std::vector<size_t> contradiction = {
+            constant_collection.add_bdd(mgr.projection(0)),
+            constant_collection.add_bdd(mgr.neg_projection(0)),
+            constant_collection.add_bdd(mgr.projection(1))};
+        const size_t nr_bdds = constant_collection.nr_bdds();
+        test(constant_collection.bdd_and(contradiction.begin(), contradiction.end()) == std::numeric_limits<size_t>::max(), "contradicting multi and not rejected.");
+        test(constant_collection.last_result() == bdd_collection::result_kind::constant_false, "contradicting multi and not constant false.");
+        test(constant_collection.bdd_and(contradiction[0], contradiction[1]) == std::numeric_limits<size_t>::max(), "contradicting and not rejected.");
+        test(constant_collection.last_result() == bdd_collection::result_kind::constant_false, "contradicting and not constant false.");
+        test(constant_collection.nr_bdds() == nr_bdds, "constant result added as bdd.");
+        test(constant_collection.bdd_and(contradiction[0], contradiction[2]) < constant_collection.nr_bdds(), "satisfiable and failed.");
+        test(constant_collection.last_result() == bdd_collection::result_kind::bdd, "satisfiable and not reported as bdd.");
+    }
 }
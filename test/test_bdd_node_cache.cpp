@@ -1,6 +1,9 @@
 #include "bdd_node_cache.h"
 #include "test.h"
 #include <vector>
+#ifdef LBDD_CONCURRENT
+#include <thread>
+#endif
 
 using namespace BDD;
 
@@ -14,6 +17,7 @@ int main(int argc, char** argv)
         v.push_back(cache.reserve_node());
         v.back()->lo = cache.topsink();
         v.back()->hi = cache.topsink();
+        test(v.back()->lo == cache.topsink() && v.back()->hi == cache.topsink(), "node arcs not stored correctly");
         cache.topsink()->xref++;
         cache.topsink()->xref++;
         test(i+1+2 == cache.nr_nodes(), "node counting error when adding nodes");
@@ -26,4 +30,51 @@ int main(int argc, char** argv)
     } 
 
     test(2 == cache.nr_nodes());
+
+    // alternating between two caches on one thread reuses the nodes of each, so no pages are added
+    {
+        bdd_node_cache first(nullptr);
+        bdd_node_cache second(nullptr);
+        auto reserve = [](bdd_node_cache& c) {
+            node* p = c.reserve_node();
+            p->lo = c.topsink();
+            p->hi = c.topsink();
+            c.topsink()->xref += 2;
+            return p;
+        };
+        const std::size_t first_pages = first.nr_pages();
+        const std::size_t second_pages = second.nr_pages();
+        for(std::size_t i=0; i<100000; ++i)
+        {
+            node* p = reserve(first);
+            node* q = reserve(second);
+            first.free_node(p);
+            second.free_node(q);
+        }
+        test(first.nr_pages() == first_pages && second.nr_pages() == second_pages, "alternating caches adds pages");
+        test(first.nr_nodes() == 2 && second.nr_nodes() == 2, "node counting error when alternating caches");
+    }
+
+#ifdef LBDD_CONCURRENT
+    // nodes left in the magazine of an exited thread are reused by other threads
+    {
+        bdd_node_cache shared(nullptr);
+        std::thread([&]() {
+                std::vector<node*> nodes;
+                for(std::size_t i=0; i<4000; ++i)
+                {
+                    nodes.push_back(shared.reserve_node());
+                    nodes.back()->lo = shared.topsink();
+                    nodes.back()->hi = shared.topsink();
+                    __atomic_add_fetch(&shared.topsink()->xref, 2, __ATOMIC_RELAXED);
+                }
+                for(node* p : nodes)
+                    shared.free_node(p);
+                }).join();
+        const std::size_t pages = shared.nr_pages();
+        for(std::size_t i=0; i<4000; ++i)
+            shared.reserve_node();
+        test(shared.nr_pages() == pages, "nodes of exited thread not reused");
+    }
+#endif
 }
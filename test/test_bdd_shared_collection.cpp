@@ -0,0 +1,87 @@
+#include "bdd_mgr.h"
+#include "bdd_collection.h"
+#include "bdd_shared_collection.h"
+#include "test.h"
+#include <vector>
+#include <random>
+#include <array>
+#include <cstdint>
+
+using namespace BDD;
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 40;
+    bdd_mgr mgr;
+    std::vector<node_ref> x;
+    for(size_t i=0; i<nr_vars; ++i)
+    {
+        mgr.add_variable();
+        x.push_back(mgr.projection(i));
+    }
+
+    // constraints sharing one simplex below their individual parts
+    node_ref simplex = mgr.simplex(x.begin() + 20, x.end());
+    std::vector<node_ref> roots;
+    for(size_t c=0; c<16; ++c)
+        roots.push_back(mgr.and_rec(mgr.at_most(x.begin() + c, x.begin() + c + 4, 2), simplex));
+    roots.push_back(simplex);
+    roots.push_back(roots[3]);
+
+    bdd_shared_collection shared;
+    test(shared.add_bdds(roots.begin(), roots.end()) == 0, "first imported bdd has wrong number");
+    bdd_collection separate;
+    separate.add_bdds(roots.begin(), roots.end());
+    test(shared.nr_bdds() == roots.size(), "wrong number of imported bdds");
+
+    size_t nr_separate_instructions = 0;
+    std::mt19937 gen(5);
+    for(size_t i=0; i<roots.size(); ++i)
+    {
+        nr_separate_instructions += separate.nr_bdd_nodes(i);
+        test(shared.nr_bdd_nodes(i) == roots[i].nr_nodes() + 2, "shared bdd has wrong number of nodes");
+        test(shared.export_bdd(mgr, i) == roots[i], "shared bdd differs after export");
+
+        // the view iterates the same instructions as the separately stored bdd, but its arcs are positions in the shared instructions
+        const auto [begin, end] = separate.get_bdd_instructions(i);
+        const bdd_shared_collection::bdd_view view = shared.get_bdd_instructions(i);
+        test(std::distance(view.begin(), view.end()) == std::distance(begin, end), "view differs in size");
+        test(shared.offset(*view.begin()) == shared.root(i), "view does not start at the root");
+        auto it = begin;
+        for(const bdd_instruction& instr : view)
+        {
+            test(instr.index == it->index, "view differs from separate bdd");
+            if(!instr.is_terminal())
+            {
+                test(shared(instr.lo).index == separate.get_bdd_instructions(i).first[it->lo - separate.offset(*begin)].index, "arc of view differs");
+                test(shared.offset(instr) < instr.lo && shared.offset(instr) < instr.hi, "view not in topological order");
+            }
+            ++it;
+        }
+
+        for(size_t k=0; k<32; ++k)
+        {
+            std::vector<char> a(nr_vars);
+            for(auto& b : a)
+                b = gen() % 2;
+            test(shared.evaluate(i, a.begin(), a.end()) == roots[i].evaluate(a.begin(), a.end()), "shared bdd evaluates wrong");
+        }
+        std::vector<std::array<std::uint64_t,1>> batch(nr_vars);
+        for(auto& b : batch)
+            b[0] = (std::uint64_t(gen()) << 32) | gen();
+        test(shared.evaluate_batch(i, batch.begin(), batch.end()) == separate.evaluate_batch(i, batch.begin(), batch.end()), "shared batch evaluation differs");
+    }
+    test(shared.root(roots.size()-1) == shared.root(3), "repeated root stored twice");
+    test(shared.nr_instructions() < nr_separate_instructions / 4, "shared collection does not share the simplex");
+
+    // views are searched once per bdd
+    const size_t nr_first_bdd_nodes = shared.nr_bdd_nodes(0);
+    test(shared.get_bdd_instructions(0).positions_begin() == shared.get_bdd_instructions(0).positions_begin(), "positions of view not cached");
+
+    // a second import forms its own block
+    const size_t second = shared.add_bdds(roots.begin(), roots.begin() + 1);
+    test(second == roots.size(), "second import has wrong number");
+    test(shared.export_bdd(mgr, second) == roots[0], "bdd of second block differs");
+    test(shared.root(second) > shared.root(0), "second block not appended");
+    test(shared.nr_bdd_nodes(0) == nr_first_bdd_nodes && shared.nr_bdd_nodes(second) == nr_first_bdd_nodes, "bdd of second block has wrong number of nodes");
+}
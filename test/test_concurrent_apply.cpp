@@ -0,0 +1,38 @@
+#include "bdd_mgr.h"
+#include "test.h"
+#include <vector>
+#include <thread>
+#include <random>
+
+using namespace BDD;
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 40;
+    const size_t nr_threads = 8;
+    const size_t nr_bdds_per_thread = 20;
+
+    bdd_mgr mgr;
+    // variables must be present before concurrent use
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+
+    std::vector<std::vector<node_ref>> results(nr_threads);
+    std::vector<std::thread> threads;
+    for(size_t t=0; t<nr_threads; ++t)
+        threads.emplace_back([&, t]() {
+                std::mt19937 gen(t % 2); // pairs of threads build the same bdds to provoke contention on the same nodes
+                for(size_t i=0; i<nr_bdds_per_thread; ++i)
+                    results[t].push_back(random_cnf(mgr, nr_vars, 30, gen));
+                });
+    for(auto& th : threads)
+        th.join();
+
+    // canonicity: recomputing sequentially must give identical nodes
+    for(size_t t=0; t<nr_threads; ++t)
+    {
+        std::mt19937 gen(t % 2);
+        for(size_t i=0; i<nr_bdds_per_thread; ++i)
+            test(random_cnf(mgr, nr_vars, 30, gen) == results[t][i], "concurrently built bdd not canonical");
+    }
+}
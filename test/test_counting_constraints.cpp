@@ -0,0 +1,104 @@
+#include "bdd_mgr.h"
+#include "test.h"
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <numeric>
+
+using namespace BDD;
+
+// number of true operands of f_begin..f_end under the assignment x
+template<typename ITERATOR>
+size_t nr_true(ITERATOR f_begin, ITERATOR f_end, const std::vector<char>& x)
+{
+    size_t sum = 0;
+    for(auto it=f_begin; it!=f_end; ++it)
+        sum += it->evaluate(x.begin(), x.end());
+    return sum;
+}
+
+template<typename ITERATOR>
+void test_counting_constraints(bdd_mgr& mgr, ITERATOR f_begin, ITERATOR f_end, const size_t nr_vars)
+{
+    const size_t n = std::distance(f_begin, f_end);
+    node_ref simplex = mgr.simplex(f_begin, f_end);
+    node_ref at_most_one = mgr.at_most_one(f_begin, f_end);
+    node_ref at_least_one = mgr.at_least_one(f_begin, f_end);
+    node_ref all_false = mgr.all_false(f_begin, f_end);
+    std::vector<node_ref> at_most, at_least, cardinality;
+    for(size_t b=0; b<=n+1; ++b)
+    {
+        at_most.push_back(mgr.at_most(f_begin, f_end, b));
+        at_least.push_back(mgr.at_least(f_begin, f_end, b));
+        cardinality.push_back(mgr.cardinality(f_begin, f_end, b));
+    }
+
+    for(size_t a=0; a<(size_t(1) << nr_vars); ++a)
+    {
+        std::vector<char> x(nr_vars);
+        for(size_t i=0; i<nr_vars; ++i)
+            x[i] = (a >> i) & 1;
+        const size_t sum = nr_true(f_begin, f_end, x);
+        test(simplex.evaluate(x.begin(), x.end()) == (sum == 1), "simplex evaluates wrong");
+        test(at_most_one.evaluate(x.begin(), x.end()) == (sum <= 1), "at most one evaluates wrong");
+        test(at_least_one.evaluate(x.begin(), x.end()) == (sum >= 1), "at least one evaluates wrong");
+        test(all_false.evaluate(x.begin(), x.end()) == (sum == 0), "all false evaluates wrong");
+        for(size_t b=0; b<=n+1; ++b)
+        {
+            test(at_most[b].evaluate(x.begin(), x.end()) == (sum <= b), "at most evaluates wrong");
+            test(at_least[b].evaluate(x.begin(), x.end()) == (sum >= b), "at least evaluates wrong");
+            test(cardinality[b].evaluate(x.begin(), x.end()) == (sum == b), "cardinality evaluates wrong");
+        }
+    }
+
+    // results are reduced, so they coincide with the same functions composed by apply operations
+    node_ref at_most_composed = mgr.botsink();
+    for(size_t b=0; b<=n; ++b)
+    {
+        at_most_composed = mgr.or_rec(at_most_composed, cardinality[b]);
+        test(at_most[b] == at_most_composed, "at most differs from disjunction of cardinalities");
+        test(at_least[b+1] == mgr.negate(at_most[b]), "at least differs from negated at most");
+    }
+    test(simplex == cardinality[1], "simplex differs from cardinality one");
+    test(at_most_one == at_most[1], "at most one differs from at most");
+    test(all_false == cardinality[0], "all false differs from cardinality zero");
+}
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 10;
+    bdd_mgr mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+    std::mt19937 gen(11);
+
+    // literals of mixed signs, given in any order
+    for(size_t round=0; round<10; ++round)
+    {
+        std::vector<size_t> vars(nr_vars);
+        std::iota(vars.begin(), vars.end(), 0);
+        std::shuffle(vars.begin(), vars.end(), gen);
+        std::vector<node_ref> literals;
+        for(size_t i=0; i<1 + round % nr_vars; ++i)
+            literals.push_back(gen() % 2 ? mgr.projection(vars[i]) : mgr.neg_projection(vars[i]));
+        test_counting_constraints(mgr, literals.begin(), literals.end(), nr_vars);
+    }
+
+    // n literals with bound b have at most n*(b+1) nodes
+    {
+        std::vector<node_ref> literals;
+        for(size_t i=0; i<nr_vars; ++i)
+            literals.push_back(mgr.projection(i));
+        test(mgr.cardinality(literals.begin(), literals.end(), 3).nr_nodes() <= nr_vars * 4, "cardinality bdd too large");
+        test(mgr.simplex(literals.begin(), literals.end()).nr_nodes() == 2*nr_vars - 1, "simplex bdd has wrong number of nodes");
+    }
+
+    // repeated variables and operands that are no literals are composed by apply operations
+    {
+        std::vector<node_ref> operands = {mgr.projection(2), mgr.neg_projection(5), mgr.projection(2), mgr.projection(7)};
+        test_counting_constraints(mgr, operands.begin(), operands.end(), nr_vars);
+        operands.push_back(mgr.and_rec(mgr.projection(0), mgr.projection(1)));
+        operands.push_back(mgr.or_rec(mgr.projection(8), mgr.neg_projection(9)));
+        test_counting_constraints(mgr, operands.begin(), operands.end(), nr_vars);
+    }
+}
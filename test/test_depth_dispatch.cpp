@@ -0,0 +1,51 @@
+#include "bdd_mgr.h"
+#include "test.h"
+#include <vector>
+
+using namespace BDD;
+
+int main(int argc, char** argv)
+{
+    // depth of small bdds
+    {
+        bdd_mgr mgr;
+        for(size_t i=0; i<3; ++i)
+            mgr.add_variable();
+
+        test(mgr.topsink().depth() == 0);
+        test(mgr.botsink().depth() == 0);
+        test(mgr.projection(1).depth() == 1);
+
+        node_ref p01 = mgr.and_rec(mgr.projection(0), mgr.projection(1));
+        test(p01.depth() == 2);
+        node_ref p012 = mgr.or_rec(p01, mgr.projection(2));
+        test(p012.depth() == 3);
+    }
+
+    // operations on bdds too deep for recursion dispatch to non-recursive versions
+    {
+        const size_t nr_vars = 4*max_recursion_depth;
+        bdd_mgr mgr;
+        for(size_t i=0; i<nr_vars; ++i)
+            mgr.add_variable();
+
+        node_ref all_true = mgr.topsink();
+        node_ref any_true = mgr.botsink();
+        for(std::ptrdiff_t i=nr_vars-1; i>=0; --i)
+        {
+            all_true = mgr.unique_find(i, mgr.botsink(), all_true);
+            any_true = mgr.unique_find(i, any_true, mgr.topsink());
+        }
+        test(all_true.depth() == std::min(nr_vars, max_node_depth));
+        test(any_true.depth() == std::min(nr_vars, max_node_depth));
+
+        test(mgr.and_rec(all_true, any_true) == all_true, "and on deep bdd wrong");
+        test(mgr.or_rec(all_true, any_true) == any_true, "or on deep bdd wrong");
+        node_ref x = mgr.xor_rec(all_true, any_true);
+        test(x == mgr.ite_rec(all_true, mgr.botsink(), any_true), "xor and ite on deep bdd differ");
+        test(x.depth() == std::min(nr_vars, max_node_depth));
+
+        node_ref none_true = mgr.negate(any_true);
+        test(mgr.and_rec(none_true, any_true) == mgr.botsink(), "negation of deep bdd wrong");
+    }
+}
@@ -0,0 +1,47 @@
+#include "bdd_flat_hash_map.h"
+#include "bdd_collection.h"
+#include "test.h"
+#include <array>
+
+using namespace BDD;
+
+int main(int argc, char** argv)
+{
+    flat_hash_map<std::array<size_t,2>, size_t, array_hasher<2>> map(16);
+    const size_t n = 10000;
+
+    // insertion with growth
+    for(size_t i=0; i<n; ++i)
+        map.insert({i, 2*i}, i);
+    test(map.size() == n, "wrong nr of entries after insertion");
+    for(size_t i=0; i<n; ++i)
+    {
+        const size_t* v = map.find({i, 2*i});
+        test(v != nullptr && *v == i, "inserted key not found");
+        test(map.find({2*i, i}) == nullptr || i == 0, "key with swapped entries found");
+    }
+
+    // clearing keeps no entries
+    map.clear();
+    test(map.empty());
+    for(size_t i=0; i<n; ++i)
+        test(map.find({i, 2*i}) == nullptr, "key found after clear");
+
+    // reinsertion with different values after clear
+    for(size_t i=0; i<n; i+=2)
+        map.insert({i, 2*i}, i+1);
+    for(size_t i=0; i<n; ++i)
+    {
+        const size_t* v = map.find({i, 2*i});
+        if(i % 2 == 0)
+            test(v != nullptr && *v == i+1, "reinserted key not found");
+        else
+            test(v == nullptr, "key of earlier epoch found");
+    }
+
+    // bdd instructions as keys
+    flat_hash_map<bdd_instruction, size_t, bdd_instruction_hasher> reduction;
+    reduction.insert({1, 2, 3}, 7);
+    test(reduction.find({1, 2, 3}) != nullptr && *reduction.find({1, 2, 3}) == 7);
+    test(reduction.find({2, 1, 3}) == nullptr);
+}
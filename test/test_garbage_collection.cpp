@@ -0,0 +1,97 @@
+#include "bdd_mgr.h"
+#include "test.h"
+#include <vector>
+#include <random>
+
+using namespace BDD;
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 30;
+    const size_t nr_clauses = 60;
+    const size_t nr_rounds = 6;
+
+    // dead nodes are counted and reclaimed by explicit collection
+    {
+        bdd_mgr mgr;
+        mgr.set_automatic_garbage_collection(false);
+        for(size_t i=0; i<nr_vars; ++i)
+            mgr.add_variable();
+        test(mgr.nr_dead_nodes() == 0);
+        {
+            std::mt19937 gen(1);
+            node_ref f = random_cnf(mgr, nr_vars, nr_clauses, gen);
+            test(mgr.nr_dead_nodes() > 0);
+            test(mgr.nr_dead_nodes() + f.nr_nodes() + 2 <= mgr.nr_nodes());
+        }
+        // nodes only referenced by dead nodes are still counted as live
+        test(mgr.nr_dead_nodes() > 0);
+        mgr.collect_garbage();
+        test(mgr.nr_dead_nodes() == 0);
+        test(mgr.nr_nodes() == 2, "explicit garbage collection did not reclaim all nodes");
+    }
+
+    // dead nodes are counted per manager, also when one thread interleaves several of them
+    {
+        bdd_mgr mgr_1;
+        bdd_mgr mgr_2;
+        mgr_1.set_automatic_garbage_collection(false);
+        mgr_2.set_automatic_garbage_collection(false);
+        for(size_t i=0; i<nr_vars; ++i)
+        {
+            mgr_1.add_variable();
+            mgr_2.add_variable();
+        }
+        std::mt19937 gen(3);
+        random_cnf(mgr_1, nr_vars, nr_clauses, gen);
+        test(mgr_2.nr_dead_nodes() == 0, "dead nodes of one manager counted for another");
+        test(mgr_1.nr_dead_nodes() > 0);
+        node_ref f = random_cnf(mgr_2, nr_vars, nr_clauses, gen);
+        mgr_1.collect_garbage();
+        test(mgr_1.nr_dead_nodes() == 0 && mgr_1.nr_nodes() == 2);
+        test(mgr_2.nr_dead_nodes() + f.nr_nodes() + 2 <= mgr_2.nr_nodes());
+        mgr_2.collect_garbage();
+        test(mgr_2.nr_dead_nodes() == 0 && mgr_2.nr_nodes() == f.nr_nodes() + 2);
+    }
+
+    // automatic collection bounds the number of nodes and does not change results
+    {
+        bdd_mgr mgr_gc;
+        mgr_gc.set_garbage_collection_policy(0.5, 3);
+        bdd_mgr mgr_no_gc;
+        mgr_no_gc.set_automatic_garbage_collection(false);
+        for(size_t i=0; i<nr_vars; ++i)
+        {
+            mgr_gc.add_variable();
+            mgr_no_gc.add_variable();
+        }
+
+        std::mt19937 gen_gc(7);
+        std::mt19937 gen_no_gc(7);
+        node_ref f_gc = random_cnf(mgr_gc, nr_vars, nr_clauses, gen_gc);
+        node_ref f_no_gc = random_cnf(mgr_no_gc, nr_vars, nr_clauses, gen_no_gc);
+        for(size_t r=0; r<nr_rounds; ++r)
+        {
+            // results of earlier rounds become garbage
+            f_gc = mgr_gc.or_rec(mgr_gc.projection(r % nr_vars), random_cnf(mgr_gc, nr_vars, nr_clauses, gen_gc));
+            f_no_gc = mgr_no_gc.or_rec(mgr_no_gc.projection(r % nr_vars), random_cnf(mgr_no_gc, nr_vars, nr_clauses, gen_no_gc));
+        }
+
+        test(mgr_gc.nr_nodes() < mgr_no_gc.nr_nodes(), "automatic garbage collection did not reclaim nodes");
+        test(f_gc.nr_nodes() == f_no_gc.nr_nodes(), "results differ with automatic garbage collection");
+
+        std::mt19937 gen(5);
+        std::bernoulli_distribution val_dist(0.5);
+        std::vector<char> assignment(nr_vars);
+        for(size_t t=0; t<1000; ++t)
+        {
+            for(auto& x : assignment)
+                x = val_dist(gen);
+            test(f_gc.evaluate(assignment.begin(), assignment.end()) == f_no_gc.evaluate(assignment.begin(), assignment.end()), "results differ with automatic garbage collection");
+        }
+
+        // finishing a cycle by explicit collection leaves only the nodes of f_gc
+        mgr_gc.collect_garbage();
+        test(mgr_gc.nr_nodes() == f_gc.nr_nodes() + 2);
+    }
+}
@@ -0,0 +1,150 @@
+#include "bdd_mgr.h"
+#include "bdd_collection.h"
+#include "test.h"
+#include <vector>
+#include <random>
+#include <limits>
+#include <cstdint>
+
+using namespace BDD;
+
+std::int64_t weighted_sum(const std::vector<size_t>& vars, const std::vector<std::int64_t>& coefficients, const std::vector<char>& x)
+{
+    std::int64_t sum = 0;
+    for(size_t i=0; i<vars.size(); ++i)
+        sum += coefficients[i] * x[vars[i]];
+    return sum;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 8;
+    bdd_mgr mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+    std::mt19937 gen(13);
+    std::uniform_int_distribution<std::int64_t> coefficient_dist(-6, 6);
+    std::uniform_int_distribution<size_t> var_dist(0, nr_vars-1);
+
+    bdd_collection collection;
+    for(size_t round=0; round<40; ++round)
+    {
+        // variables may repeat, in the manager repeated variables are composed by ite
+        std::vector<size_t> vars;
+        std::vector<std::int64_t> coefficients;
+        std::vector<node_ref> projections;
+        for(size_t i=0; i<2 + round % 7; ++i)
+        {
+            vars.push_back(round < 20 ? (i * 5 + round) % nr_vars : var_dist(gen));
+            coefficients.push_back(coefficient_dist(gen));
+            projections.push_back(mgr.projection(vars.back()));
+        }
+
+        for(std::int64_t bound=-8; bound<=8; ++bound)
+        {
+            node_ref at_most = mgr.linear_at_most(projections.begin(), projections.end(), coefficients.begin(), bound);
+            node_ref equal = mgr.linear_equal(projections.begin(), projections.end(), coefficients.begin(), bound);
+            const size_t at_most_nr = collection.add_linear_at_most(vars.begin(), vars.end(), coefficients.begin(), bound);
+            test((at_most_nr == std::numeric_limits<size_t>::max()) == at_most.is_terminal(), "collection and manager disagree on constant constraint");
+            test((collection.last_result() == bdd_collection::result_kind::constant_true) == at_most.is_topsink(), "collection and manager disagree on constant constraint");
+            test((collection.last_result() == bdd_collection::result_kind::constant_false) == at_most.is_botsink(), "collection and manager disagree on constant constraint");
+            const size_t equal_nr = collection.add_linear_equal(vars.begin(), vars.end(), coefficients.begin(), bound);
+            test((equal_nr == std::numeric_limits<size_t>::max()) == equal.is_terminal(), "collection and manager disagree on constant constraint");
+            test((collection.last_result() == bdd_collection::result_kind::constant_true) == equal.is_topsink(), "collection and manager disagree on constant constraint");
+            test((collection.last_result() == bdd_collection::result_kind::constant_false) == equal.is_botsink(), "collection and manager disagree on constant constraint");
+            if(at_most_nr != std::numeric_limits<size_t>::max())
+            {
+                test(collection.export_bdd(mgr, at_most_nr) == at_most, "collection constraint differs from manager constraint");
+                test(collection.nr_bdd_nodes(at_most_nr) == at_most.nr_nodes() + 2, "collection constraint not reduced");
+            }
+            if(equal_nr != std::numeric_limits<size_t>::max())
+            {
+                test(collection.export_bdd(mgr, equal_nr) == equal, "collection constraint differs from manager constraint");
+                test(collection.nr_bdd_nodes(equal_nr) == equal.nr_nodes() + 2, "collection constraint not reduced");
+            }
+
+            for(size_t a=0; a<(size_t(1) << nr_vars); ++a)
+            {
+                std::vector<char> x(nr_vars);
+                for(size_t i=0; i<nr_vars; ++i)
+                    x[i] = (a >> i) & 1;
+                const std::int64_t sum = weighted_sum(vars, coefficients, x);
+                test(at_most.evaluate(x.begin(), x.end()) == (sum <= bound), "linear at most evaluates wrong");
+                test(equal.evaluate(x.begin(), x.end()) == (sum == bound), "linear equal evaluates wrong");
+            }
+        }
+    }
+
+    // unit coefficients give the counting constraints, negative literals swap the sign of their coefficient
+    {
+        std::vector<node_ref> x;
+        for(size_t i=0; i<nr_vars; ++i)
+            x.push_back(mgr.projection(i));
+        const std::vector<std::int64_t> ones(nr_vars, 1);
+        for(size_t b=0; b<=nr_vars; ++b)
+        {
+            test(mgr.linear_at_most(x.begin(), x.end(), ones.begin(), b) == mgr.at_most(x.begin(), x.end(), b), "unit coefficients differ from at most");
+            test(mgr.linear_equal(x.begin(), x.end(), ones.begin(), b) == mgr.cardinality(x.begin(), x.end(), b), "unit coefficients differ from cardinality");
+        }
+        std::vector<node_ref> neg_x;
+        for(size_t i=0; i<nr_vars; ++i)
+            neg_x.push_back(mgr.neg_projection(i));
+        const std::vector<std::int64_t> minus_ones(nr_vars, -1);
+        test(mgr.linear_at_most(neg_x.begin(), neg_x.end(), minus_ones.begin(), -3) == mgr.at_most(x.begin(), x.end(), nr_vars - 3), "negative coefficients of negative literals wrong");
+    }
+
+    // operands that are no literals are composed by ite
+    {
+        std::vector<node_ref> operands = {mgr.and_rec(mgr.projection(0), mgr.projection(1)), mgr.or_rec(mgr.projection(1), mgr.neg_projection(2)), mgr.projection(5)};
+        const std::vector<std::int64_t> coefficients = {3, -2, 4};
+        for(std::int64_t bound=-3; bound<=8; ++bound)
+        {
+            node_ref at_most = mgr.linear_at_most(operands.begin(), operands.end(), coefficients.begin(), bound);
+            node_ref equal = mgr.linear_equal(operands.begin(), operands.end(), coefficients.begin(), bound);
+            for(size_t a=0; a<(size_t(1) << nr_vars); ++a)
+            {
+                std::vector<char> x(nr_vars);
+                for(size_t i=0; i<nr_vars; ++i)
+                    x[i] = (a >> i) & 1;
+                std::int64_t sum = 0;
+                for(size_t i=0; i<operands.size(); ++i)
+                    sum += coefficients[i] * operands[i].evaluate(x.begin(), x.end());
+                test(at_most.evaluate(x.begin(), x.end()) == (sum <= bound), "linear at most over non-literals evaluates wrong");
+                test(equal.evaluate(x.begin(), x.end()) == (sum == bound), "linear equal over non-literals evaluates wrong");
+            }
+        }
+    }
+
+    // knapsack constraint over many variables stays small
+    {
+        bdd_mgr knapsack_mgr;
+        const size_t n = 200;
+        std::vector<node_ref> x;
+        std::vector<std::int64_t> weights;
+        std::vector<size_t> vars;
+        for(size_t i=0; i<n; ++i)
+        {
+            knapsack_mgr.add_variable();
+            x.push_back(knapsack_mgr.projection(i));
+            weights.push_back(1 + (i * 37) % 50);
+            vars.push_back(i);
+        }
+        node_ref knapsack = knapsack_mgr.linear_at_most(x.begin(), x.end(), weights.begin(), 1000);
+        test(knapsack.nr_nodes() < n * 1000, "knapsack bdd too large");
+        bdd_collection knapsack_collection;
+        const size_t nr = knapsack_collection.add_linear_at_most(vars.begin(), vars.end(), weights.begin(), 1000);
+        test(knapsack_collection.nr_bdd_nodes(nr) == knapsack.nr_nodes() + 2, "knapsack collection bdd differs in size");
+        for(size_t k=0; k<100; ++k)
+        {
+            std::vector<char> assignment(n);
+            std::int64_t sum = 0;
+            for(size_t i=0; i<n; ++i)
+            {
+                assignment[i] = gen() % 4 == 0;
+                sum += weights[i] * assignment[i];
+            }
+            test(knapsack.evaluate(assignment.begin(), assignment.end()) == (sum <= 1000), "knapsack evaluates wrong");
+            test(knapsack_collection.evaluate(nr, assignment.begin(), assignment.end()) == (sum <= 1000), "knapsack collection evaluates wrong");
+        }
+    }
+}
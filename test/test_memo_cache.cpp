@@ -0,0 +1,79 @@
+#include "bdd_mgr.h"
+#include "test.h"
+#include <vector>
+#include <random>
+
+using namespace BDD;
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 30;
+    const size_t nr_clauses = 60;
+
+    // counters are kept per operation
+    {
+        bdd_mgr mgr;
+        for(size_t i=0; i<nr_vars; ++i)
+            mgr.add_variable();
+
+        node_ref a = mgr.and_rec(mgr.projection(0), mgr.projection(1));
+        test(mgr.memo_statistics()[memo_cache_statistics::operation::and_op].inserts > 0);
+        test(mgr.memo_statistics()[memo_cache_statistics::operation::or_op].inserts == 0);
+        const size_t and_hits = mgr.memo_statistics()[memo_cache_statistics::operation::and_op].hits;
+        node_ref b = mgr.and_rec(mgr.projection(0), mgr.projection(1));
+        test(a == b);
+        test(mgr.memo_statistics()[memo_cache_statistics::operation::and_op].hits == and_hits + 1, "repeated and not answered from memo cache");
+
+        mgr.xor_rec(mgr.projection(2), mgr.projection(3));
+        test(mgr.memo_statistics()[memo_cache_statistics::operation::xor_op].misses > 0);
+        mgr.ite_rec(mgr.projection(2), mgr.projection(3), mgr.projection(4));
+        test(mgr.memo_statistics()[memo_cache_statistics::operation::ite_op].inserts > 0);
+
+        const memo_operation_statistics total = mgr.memo_statistics().total();
+        test(total.hits + total.misses > 0);
+
+        mgr.reset_memo_statistics();
+        test(mgr.memo_statistics().total().inserts == 0);
+        test(mgr.memo_statistics().nr_slots > 0);
+    }
+
+    // a tiny budget bounds the table and causes evictions, but results stay the same
+    {
+        bdd_mgr mgr_large;
+        bdd_mgr mgr_small;
+        const size_t small_budget = 16*memo_cache::memo_cache_ways*sizeof(memo_struct);
+        mgr_small.set_memo_cache_budget(small_budget);
+        test(mgr_small.memo_cache_budget() == small_budget);
+        for(size_t i=0; i<nr_vars; ++i)
+        {
+            mgr_large.add_variable();
+            mgr_small.add_variable();
+        }
+
+        std::mt19937 gen_large(17), gen_small(17);
+        node_ref f_large = random_cnf(mgr_large, nr_vars, nr_clauses, gen_large);
+        node_ref f_small = random_cnf(mgr_small, nr_vars, nr_clauses, gen_small);
+
+        const memo_cache_statistics& stats = mgr_small.memo_statistics();
+        test(stats.nr_slots * sizeof(memo_struct) <= small_budget, "memo cache exceeds budget");
+        test(stats.total().evictions > 0, "no evictions with tiny budget");
+        test(f_large.nr_nodes() == f_small.nr_nodes(), "results differ with small memo cache");
+
+        std::mt19937 gen(5);
+        std::bernoulli_distribution val_dist(0.5);
+        std::vector<char> assignment(nr_vars);
+        for(size_t t=0; t<1000; ++t)
+        {
+            for(auto& x : assignment)
+                x = val_dist(gen);
+            test(f_large.evaluate(assignment.begin(), assignment.end()) == f_small.evaluate(assignment.begin(), assignment.end()), "results differ with small memo cache");
+        }
+
+        // shrinking the budget of a populated cache
+        mgr_large.set_memo_cache_budget(small_budget);
+        test(mgr_large.memo_statistics().nr_slots * sizeof(memo_struct) <= small_budget);
+        std::mt19937 gen_again(17);
+        node_ref g = random_cnf(mgr_large, nr_vars, nr_clauses, gen_again);
+        test(g == f_large);
+    }
+}
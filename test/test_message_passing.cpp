@@ -0,0 +1,125 @@
+#include "bdd_mgr.h"
+#include "bdd_collection.h"
+#include "bdd_message_passing.h"
+#include "test.h"
+#include <vector>
+#include <random>
+#include <cmath>
+
+using namespace BDD;
+
+bool close(const double a, const double b)
+{
+    if(std::isinf(a) || std::isinf(b))
+        return a == b;
+    return std::abs(a - b) <= 1e-9 * std::max(1.0, std::abs(b));
+}
+
+// partition and marginals by enumerating all assignments of the variables of the bdd
+template<typename SEMIRING, size_t LANES>
+void test_brute_force(const bdd_collection& collection, const size_t bdd_nr, const bdd_message_passing<SEMIRING,LANES>& mp,
+        const std::vector<std::array<double,LANES>>& w0, const std::vector<std::array<double,LANES>>& w1)
+{
+    const std::vector<size_t>& vars = mp.variables(bdd_nr);
+    test(vars == collection.variables(bdd_nr));
+    const auto partition = mp.partition(bdd_nr, w0, w1);
+    const auto marginals = mp.marginals(bdd_nr, w0, w1);
+    test(marginals.size() == vars.size());
+
+    const size_t nr_vars = vars.back()+1;
+    for(size_t lane=0; lane<LANES; ++lane)
+    {
+        double p = SEMIRING::zero();
+        std::vector<std::array<double,2>> m(vars.size(), {SEMIRING::zero(), SEMIRING::zero()});
+        for(size_t a=0; a<(size_t(1) << vars.size()); ++a)
+        {
+            std::vector<char> x(nr_vars, 0);
+            double weight = SEMIRING::one();
+            for(size_t k=0; k<vars.size(); ++k)
+            {
+                x[vars[k]] = (a >> k) & 1;
+                weight = SEMIRING::times(weight, x[vars[k]] ? w1[vars[k]][lane] : w0[vars[k]][lane]);
+            }
+            if(!collection.evaluate(bdd_nr, x.begin(), x.end()))
+                continue;
+            p = SEMIRING::plus(p, weight);
+            for(size_t k=0; k<vars.size(); ++k)
+                m[k][x[vars[k]]] = SEMIRING::plus(m[k][x[vars[k]]], weight);
+        }
+        test(close(partition[lane], p), "partition wrong");
+        for(size_t k=0; k<vars.size(); ++k)
+        {
+            test(close(marginals[k][0][lane], m[k][0]), "marginal of value 0 wrong");
+            test(close(marginals[k][1][lane], m[k][1]), "marginal of value 1 wrong");
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bdd_mgr mgr;
+    bdd_collection collection;
+    const size_t nr_vars = 12;
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+
+    std::mt19937 gen(3);
+    std::vector<size_t> all_vars(nr_vars);
+    for(size_t i=0; i<nr_vars; ++i)
+        all_vars[i] = i;
+    for(size_t round=0; round<16; ++round)
+    {
+        // few clauses over many variables, so that arcs skip levels
+        std::shuffle(all_vars.begin(), all_vars.end(), gen);
+        const std::vector<size_t> vars(all_vars.begin(), all_vars.begin()+8);
+        collection.add_bdd(random_cnf(mgr, vars, 4 + round % 4, gen));
+    }
+
+    constexpr size_t lanes = 4;
+    std::uniform_real_distribution<double> cost_dist(-1.0, 1.0);
+    std::uniform_real_distribution<double> prob_dist(0.1, 1.0);
+    std::vector<std::array<double,lanes>> c0(nr_vars), c1(nr_vars), p0(nr_vars), p1(nr_vars);
+    for(size_t i=0; i<nr_vars; ++i)
+        for(size_t l=0; l<lanes; ++l)
+        {
+            c0[i][l] = l == 0 ? 0.0 : cost_dist(gen);
+            c1[i][l] = cost_dist(gen);
+            p0[i][l] = prob_dist(gen);
+            p1[i][l] = prob_dist(gen);
+        }
+
+    bdd_message_passing<min_sum_semiring<>, lanes> min_sum(collection);
+    bdd_message_passing<sum_product_semiring<>, lanes> sum_product(collection);
+    bdd_message_passing<max_product_semiring<>, lanes> max_product(collection);
+    test(min_sum.nr_bdds() == collection.nr_bdds());
+    for(size_t bdd_nr=0; bdd_nr<collection.nr_bdds(); ++bdd_nr)
+    {
+        test_brute_force(collection, bdd_nr, min_sum, c0, c1);
+        test_brute_force(collection, bdd_nr, sum_product, p0, p1);
+        test_brute_force(collection, bdd_nr, max_product, p0, p1);
+    }
+
+    // unit weights count models over the variables of each bdd
+    {
+        bdd_message_passing<sum_product_semiring<>> counter(collection);
+        const std::vector<std::array<double,1>> ones(nr_vars, {1.0});
+        for(size_t bdd_nr=0; bdd_nr<collection.nr_bdds(); ++bdd_nr)
+        {
+            const size_t nr_bdd_vars = collection.variables(bdd_nr).size();
+            const double count = collection.model_count(bdd_nr, nr_vars) / std::pow(2.0, nr_vars - nr_bdd_vars);
+            test(close(counter.partition(bdd_nr, ones, ones)[0], count), "unit weight partition differs from model count");
+        }
+    }
+
+    // passes over all bdds in parallel give the same results
+    {
+        const auto sequential = sum_product.partitions(p0, p1);
+        const auto sequential_marginals = min_sum.marginals(c0, c1);
+        sum_product.set_nr_threads(4);
+        min_sum.set_nr_threads(4);
+        const auto parallel = sum_product.partitions(p0, p1);
+        const auto parallel_marginals = min_sum.marginals(c0, c1);
+        test(sequential == parallel, "parallel partitions differ");
+        test(sequential_marginals == parallel_marginals, "parallel marginals differ");
+    }
+}
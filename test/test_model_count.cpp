@@ -0,0 +1,93 @@
+#include "bdd_mgr.h"
+#include "bdd_collection.h"
+#include "test.h"
+#include <vector>
+#include <random>
+#include <cmath>
+
+using namespace BDD;
+
+int main(int argc, char** argv)
+{
+    // big integer arithmetic
+    {
+        const big_uint p100 = big_uint(1) << 100;
+        test(p100.to_string() == "1267650600228229401496703205376");
+        test(p100.bit_width() == 101);
+        test((p100 >> 100) == big_uint(1));
+        test((p100 - big_uint(1) + big_uint(1)) == p100);
+        test(big_uint(1000000007) * big_uint(998244353) == big_uint(std::uint64_t(1000000007) * 998244353));
+        test((p100 * p100) == (big_uint(1) << 200));
+        test(std::abs(p100.log2() - 100.0) < 1e-9);
+        test(big_uint(12345678901234567890ull).to_string() == "12345678901234567890");
+    }
+
+    const size_t nr_vars = 12;
+    bdd_mgr mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+    bdd_collection collection;
+
+    // variables 2, 5 and 11 do not occur and are free, so arcs skip levels
+    const std::vector<size_t> cnf_vars = {0,1,3,4,6,7,8,9,10};
+    std::mt19937 gen(7);
+    for(size_t round=0; round<20; ++round)
+    {
+        node_ref f = random_cnf(mgr, cnf_vars, 10, gen);
+        const size_t bdd_nr = collection.add_bdd(f);
+
+        size_t count = 0;
+        std::vector<size_t> positive(nr_vars, 0);
+        for(size_t a=0; a<(size_t(1) << nr_vars); ++a)
+        {
+            std::vector<char> x(nr_vars);
+            for(size_t i=0; i<nr_vars; ++i)
+                x[i] = (a >> i) & 1;
+            if(f.evaluate(x.begin(), x.end()))
+            {
+                ++count;
+                for(size_t i=0; i<nr_vars; ++i)
+                    positive[i] += x[i];
+            }
+        }
+
+        test(f.model_count(nr_vars) == double(count), "node model count wrong");
+        test(f.model_count<big_uint>(nr_vars) == big_uint(count), "node exact model count wrong");
+        test(collection.model_count(bdd_nr, nr_vars) == double(count), "collection model count wrong");
+        test(collection.model_count<big_uint>(bdd_nr, nr_vars) == big_uint(count), "collection exact model count wrong");
+        if(count > 0)
+        {
+            test(std::abs(f.model_count<log2_count>(nr_vars).value - std::log2(count)) < 1e-9, "node log model count wrong");
+            test(std::abs(collection.model_count<log2_count>(bdd_nr, nr_vars).value - std::log2(count)) < 1e-9, "collection log model count wrong");
+        }
+
+        const std::vector<double> f_positive = f.positive_counts(nr_vars);
+        const std::vector<big_uint> col_positive = collection.positive_counts<big_uint>(bdd_nr, nr_vars);
+        const std::vector<log2_count> col_log_positive = collection.positive_counts<log2_count>(bdd_nr, nr_vars);
+        for(size_t i=0; i<nr_vars; ++i)
+        {
+            test(f_positive[i] == double(positive[i]), "node positive count wrong");
+            test(col_positive[i] == big_uint(positive[i]), "collection positive count wrong");
+            if(positive[i] > 0)
+                test(std::abs(col_log_positive[i].value - std::log2(positive[i])) < 1e-6, "collection log positive count wrong");
+        }
+    }
+
+    // terminals
+    test(mgr.topsink().model_count(nr_vars) == std::pow(2.0, nr_vars));
+    test(mgr.botsink().model_count<big_uint>(nr_vars).is_zero());
+
+    // counts beyond 64 bits and beyond double
+    {
+        const size_t nr_many_vars = 2000;
+        node_ref p = mgr.and_rec(mgr.projection(3), mgr.negate(mgr.projection(1500)));
+        test(p.model_count<big_uint>(nr_many_vars) == (big_uint(1) << (nr_many_vars-2)), "exact model count with many free variables wrong");
+        test(std::abs(p.model_count<log2_count>(nr_many_vars).value - double(nr_many_vars-2)) < 1e-9);
+        test(std::isinf(p.model_count(nr_many_vars)));
+        const std::vector<big_uint> pos = p.positive_counts<big_uint>(nr_many_vars);
+        test(pos[3] == (big_uint(1) << (nr_many_vars-2)));
+        test(pos[1500].is_zero());
+        test(pos[0] == (big_uint(1) << (nr_many_vars-3)));
+        test(pos[nr_many_vars-1] == (big_uint(1) << (nr_many_vars-3)));
+    }
+}
@@ -0,0 +1,57 @@
+#include "bdd_mgr.h"
+#include "test.h"
+#include <vector>
+#include <random>
+
+using namespace BDD;
+
+// many small constraints over overlapping variable windows, similar to constraints of chain mrfs
+std::vector<node_ref> window_constraints(bdd_mgr& mgr, const size_t nr_vars, const size_t window)
+{
+    std::vector<node_ref> constraints;
+    for(size_t i=0; i+window<=nr_vars; ++i)
+    {
+        std::vector<node_ref> vars;
+        for(size_t j=i; j<i+window; ++j)
+            vars.push_back(mgr.projection(j));
+        constraints.push_back(mgr.at_most_one(vars.begin(), vars.end()));
+        constraints.push_back(mgr.or_rec(vars.begin(), vars.end()));
+    }
+    return constraints;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 300;
+    const size_t window = 4;
+
+    bdd_mgr seq_mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        seq_mgr.add_variable();
+    std::vector<node_ref> seq_constraints = window_constraints(seq_mgr, nr_vars, window);
+    node_ref seq_result = seq_mgr.and_rec(seq_constraints.begin(), seq_constraints.end());
+
+    bdd_mgr par_mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        par_mgr.add_variable();
+    par_mgr.set_nr_threads(4);
+    par_mgr.set_parallel_cutoff(8);
+    std::vector<node_ref> par_constraints = window_constraints(par_mgr, nr_vars, window);
+    node_ref par_result = par_mgr.and_rec(par_constraints.begin(), par_constraints.end());
+
+    test(par_result.nr_nodes() == seq_result.nr_nodes(), "parallel conjunction has different size");
+
+    std::mt19937 gen(0);
+    std::bernoulli_distribution coin(0.25);
+    for(size_t k=0; k<1000; ++k)
+    {
+        std::vector<char> labeling(nr_vars);
+        for(auto& x : labeling)
+            x = coin(gen);
+        test(par_result.evaluate(labeling.begin(), labeling.end()) == seq_result.evaluate(labeling.begin(), labeling.end()), "parallel conjunction evaluates differently");
+    }
+
+    // sequential recomputation in the same manager must give the identical node
+    par_mgr.set_nr_threads(1);
+    test(par_mgr.and_rec(par_constraints.begin(), par_constraints.end()) == par_result, "parallel conjunction not canonical");
+}
@@ -0,0 +1,74 @@
+#include "bdd_mgr.h"
+#include "test.h"
+#include <vector>
+#include <random>
+
+using namespace BDD;
+
+// quantify by enumerating all assignments of the quantified variables
+bool quantify_brute_force(node_ref f, std::vector<char> x, const std::vector<size_t>& quantified, const size_t k, const bool existential)
+{
+    if(k == quantified.size())
+        return f.evaluate(x.begin(), x.end());
+    x[quantified[k]] = 0;
+    const bool r0 = quantify_brute_force(f, x, quantified, k+1, existential);
+    x[quantified[k]] = 1;
+    const bool r1 = quantify_brute_force(f, x, quantified, k+1, existential);
+    return existential ? (r0 || r1) : (r0 && r1);
+}
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 10;
+    bdd_mgr mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+
+    // quantification over a single variable is the disjunction resp. conjunction of its cofactors
+    {
+        node_ref f = mgr.or_rec(mgr.and_rec(mgr.projection(0), mgr.projection(1)), mgr.and_rec(mgr.neg_projection(0), mgr.projection(2)));
+        const std::vector<size_t> v0 = {0};
+        test(mgr.exists(f, mgr.cube(v0.begin(), v0.end())) == mgr.or_rec(mgr.projection(1), mgr.projection(2)), "exists over one variable wrong");
+        test(mgr.forall(f, mgr.cube(v0.begin(), v0.end())) == mgr.and_rec(mgr.projection(1), mgr.projection(2)), "forall over one variable wrong");
+        const std::vector<size_t> no_vars;
+        test(mgr.exists(f, mgr.cube(no_vars.begin(), no_vars.end())) == f, "exists over empty cube changes bdd");
+    }
+
+    std::mt19937 gen(42);
+    for(size_t round=0; round<20; ++round)
+    {
+        node_ref f = random_cnf(mgr, nr_vars, 12, gen);
+        node_ref g = random_cnf(mgr, nr_vars, 12, gen);
+
+        std::vector<size_t> quantified;
+        std::bernoulli_distribution quantify_dist(0.4);
+        for(size_t i=0; i<nr_vars; ++i)
+            if(quantify_dist(gen))
+                quantified.push_back(i);
+        node_ref c = mgr.cube(quantified.begin(), quantified.end());
+
+        node_ref ex = mgr.exists(f, c);
+        node_ref fa = mgr.forall(f, c);
+        node_ref ae = mgr.and_exists(f, g, c);
+
+        test(ae == mgr.exists(mgr.and_rec(f,g), c), "and_exists differs from exists of conjunction");
+        test(fa == mgr.negate(mgr.exists(mgr.negate(f), c)), "forall is not dual to exists");
+
+        // results do not depend on quantified variables
+        for(const size_t v : ex.variables())
+            test(!std::binary_search(quantified.begin(), quantified.end(), v), "exists result contains quantified variable");
+
+        for(size_t a=0; a<(size_t(1) << nr_vars); ++a)
+        {
+            std::vector<char> x(nr_vars);
+            for(size_t i=0; i<nr_vars; ++i)
+                x[i] = (a >> i) & 1;
+            test(ex.evaluate(x.begin(), x.end()) == quantify_brute_force(f, x, quantified, 0, true), "exists wrong");
+            test(fa.evaluate(x.begin(), x.end()) == quantify_brute_force(f, x, quantified, 0, false), "forall wrong");
+        }
+    }
+
+    test(mgr.memo_statistics()[memo_cache_statistics::operation::exists_op].inserts > 0);
+    test(mgr.memo_statistics()[memo_cache_statistics::operation::and_exists_op].inserts > 0);
+    mgr.collect_garbage();
+}
@@ -0,0 +1,86 @@
+#include "bdd_mgr.h"
+#include "test.h"
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <algorithm>
+
+using namespace BDD;
+
+// g must be f with variable v replaced by variable var_map[v]
+void test_rebased(node_ref f, node_ref g, const std::vector<size_t>& var_map)
+{
+    const size_t nr_vars = var_map.size();
+    const size_t nr_target_vars = *std::max_element(var_map.begin(), var_map.end()) + 1;
+    for(size_t a=0; a<(size_t(1) << nr_target_vars); ++a)
+    {
+        std::vector<char> y(nr_target_vars);
+        for(size_t i=0; i<nr_target_vars; ++i)
+            y[i] = (a >> i) & 1;
+        std::vector<char> x(nr_vars);
+        for(size_t i=0; i<nr_vars; ++i)
+            x[i] = y[var_map[i]];
+        test(g.evaluate(y.begin(), y.end()) == f.evaluate(x.begin(), x.end()), "rebased bdd evaluates wrong");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t nr_vars = 10;
+    bdd_mgr mgr;
+    for(size_t i=0; i<nr_vars; ++i)
+        mgr.add_variable();
+    std::mt19937 gen(7);
+
+    for(size_t round=0; round<20; ++round)
+    {
+        node_ref f = random_cnf(mgr, nr_vars, 3 + round, gen);
+        if(f.is_terminal())
+            continue;
+
+        // order preserving maps keep the shape and can be undone
+        std::vector<size_t> shift(nr_vars);
+        for(size_t i=0; i<nr_vars; ++i)
+            shift[i] = 2*i + 1;
+        node_ref g = mgr.rebase(f, shift.begin(), shift.end());
+        test(g.nr_nodes() == f.nr_nodes(), "order preserving rebase changed number of nodes");
+        test_rebased(f, g, shift);
+        std::unordered_map<size_t,size_t> unshift;
+        for(size_t i=0; i<nr_vars; ++i)
+            unshift.insert({2*i + 1, i});
+        test(mgr.rebase(g, unshift) == f, "order preserving rebase not undone");
+
+        // reversal, random permutation and a map merging variables
+        std::vector<size_t> reversed(nr_vars);
+        for(size_t i=0; i<nr_vars; ++i)
+            reversed[i] = nr_vars-1-i;
+        test_rebased(f, mgr.rebase(f, reversed.begin(), reversed.end()), reversed);
+
+        std::vector<size_t> permutation(nr_vars);
+        std::iota(permutation.begin(), permutation.end(), 0);
+        std::shuffle(permutation.begin(), permutation.end(), gen);
+        node_ref h = mgr.rebase(f, permutation.begin(), permutation.end());
+        test_rebased(f, h, permutation);
+        std::unordered_map<size_t,size_t> inverse;
+        for(size_t i=0; i<nr_vars; ++i)
+            inverse.insert({permutation[i], i});
+        test(mgr.rebase(h, inverse) == f, "permutation not undone by its inverse");
+
+        std::vector<size_t> merge(nr_vars);
+        for(size_t i=0; i<nr_vars; ++i)
+            merge[i] = (7*i) % 4;
+        test_rebased(f, mgr.rebase(f, merge.begin(), merge.end()), merge);
+    }
+
+    // permutations sort levels, which need not coincide with variables after reordering
+    {
+        node_ref f = random_cnf(mgr, nr_vars, 8, gen);
+        mgr.reorder();
+        std::vector<size_t> reversed(nr_vars);
+        for(size_t i=0; i<nr_vars; ++i)
+            reversed[i] = nr_vars-1-i;
+        node_ref g = mgr.rebase(f, reversed.begin(), reversed.end());
+        test_rebased(f, g, reversed);
+        test(mgr.rebase(g, reversed.begin(), reversed.end()) == f, "reversal after reordering not undone");
+    }
+}
@@ -0,0 +1,198 @@
+#include "bdd_mgr.h"
+#include "bdd_collection.h"
+#include "bdd_shared_collection.h"
+#include "test.h"
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+using namespace BDD;
+
+// x_0 x_n + x_1 x_{n+1} + ... + x_{n-1} x_{2n-1}, exponential in the identity order and linear when pairs are adjacent
+node_ref pairs(bdd_mgr& mgr, const size_t n)
+{
+    node_ref f = mgr.botsink();
+    for(size_t i=0; i<n; ++i)
+        f = mgr.or_rec(f, mgr.and_rec(mgr.projection(i), mgr.projection(i+n)));
+    return f;
+}
+
+bool pairs_value(const std::vector<char>& a, const size_t n)
+{
+    for(size_t i=0; i<n; ++i)
+        if(a[i] && a[i+n])
+            return true;
+    return false;
+}
+
+// nodes take variables, the order is given by their levels
+bool ordered(bdd_mgr& mgr, node_ref f)
+{
+    auto level = [&](node_ref p) { return p.is_terminal() ? mgr.nr_variables() : mgr.level(p.variable()); };
+    for(node_ref p : f.nodes_postorder())
+        if(level(p.low()) <= level(p) || level(p.high()) <= level(p))
+            return false;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n = 8;
+    std::mt19937 gen(5);
+
+    {
+        bdd_mgr mgr;
+        node_ref f = pairs(mgr, n);
+        const size_t nr_nodes_before = f.nr_nodes();
+        test(nr_nodes_before > size_t(1) << n, "pairs in bad order should be exponential");
+        const double count_before = f.model_count<double>(2*n);
+
+        mgr.reorder();
+        test(mgr.nr_reorderings() == 1);
+        test(f.nr_nodes() <= 2*n, "sifting should find linear size order for pairs, found " + std::to_string(f.nr_nodes()) + " nodes");
+        test(ordered(mgr, f), "reordered bdd must be ordered by level");
+        test(f.model_count<double>(2*n) == count_before, "model count changed by reordering");
+        for(size_t v=0; v<2*n; ++v)
+            test(mgr.variable(mgr.level(v)) == v, "levels and variables must be inverse");
+
+        // all assignments
+        for(size_t k=0; k<(size_t(1) << (2*n)); ++k)
+        {
+            std::vector<char> a(2*n);
+            for(size_t i=0; i<2*n; ++i)
+                a[i] = (k >> i) & 1;
+            test(f.evaluate(a.begin(), a.end()) == pairs_value(a, n), "reordered bdd has wrong value");
+        }
+
+        // synthesis and quantification in the new order, projections and cubes take variables
+        node_ref g = mgr.and_rec(f, mgr.neg_projection(0));
+        const std::vector<size_t> quantified = {1, n+2};
+        node_ref e = mgr.exists(f, mgr.cube(quantified.begin(), quantified.end()));
+        test(ordered(mgr, g) && ordered(mgr, e));
+        for(size_t k=0; k<1000; ++k)
+        {
+            std::vector<char> a(2*n);
+            for(auto& v : a)
+                v = gen() % 2;
+            test(g.evaluate(a.begin(), a.end()) == (pairs_value(a, n) && !a[0]), "conjunction after reordering wrong");
+            std::vector<char> a1 = a;
+            a1[1] = 1;
+            a1[n+2] = 1; // pairs is monotone
+            test(e.evaluate(a.begin(), a.end()) == pairs_value(a1, n), "quantification after reordering wrong");
+        }
+
+        // interfaces return variables, not levels
+        test(mgr.level(f.variable()) == 0, "root of pairs must lie on the first level");
+        std::vector<size_t> all_vars(2*n);
+        std::iota(all_vars.begin(), all_vars.end(), 0);
+        test(f.variables() == all_vars, "variables of reordered bdd wrong");
+        std::vector<size_t> g_vars(all_vars);
+        g_vars.erase(g_vars.begin() + n); // the partner of x_0 drops out
+        test(g.variables() == g_vars, "variables of conjunction after reordering wrong");
+        const std::vector<double> counts = g.positive_counts<double>(2*n);
+        test(counts[0] == 0.0 && counts[1] > 0.0, "positive counts after reordering not given by variable");
+        const size_t low_var = mgr.variable(2*n-1);
+        const size_t high_var = mgr.variable(0);
+        node_ref h = mgr.and_rec(mgr.projection(std::min(low_var, high_var)), mgr.neg_projection(std::max(low_var, high_var)));
+        test(h.model_count<double>(std::max(low_var, high_var) + 1) == double(size_t(1) << (std::max(low_var, high_var) - 1)), "model count after reordering wrong");
+
+        // collections hold variables and import them at their levels
+        bdd_collection collection;
+        const size_t nr = collection.add_bdd(g);
+        test(collection.get_bdd_instructions(nr).first->index == g.variable(), "collection instruction does not hold the variable");
+        test(collection.export_bdd(mgr, nr) == g, "collection roundtrip after reordering differs");
+        bdd_shared_collection shared;
+        const size_t shared_nr = shared.add_bdds(&g, &g + 1);
+        test(shared.export_bdd(mgr, shared_nr) == g, "shared collection roundtrip after reordering differs");
+
+        // rebase renames variables
+        std::vector<size_t> swap_map(all_vars);
+        std::swap(swap_map[0], swap_map[1]);
+        node_ref swapped = mgr.rebase(g, swap_map.begin(), swap_map.end());
+        test(ordered(mgr, swapped));
+        for(size_t k=0; k<1000; ++k)
+        {
+            std::vector<char> a(2*n);
+            for(auto& v : a)
+                v = gen() % 2;
+            test(collection.evaluate(nr, a.begin(), a.end()) == g.evaluate(a.begin(), a.end()), "collection evaluates wrong after reordering");
+            test(shared.evaluate(shared_nr, a.begin(), a.end()) == g.evaluate(a.begin(), a.end()), "shared collection evaluates wrong after reordering");
+            std::vector<char> b = a;
+            std::swap(b[0], b[1]);
+            test(swapped.evaluate(a.begin(), a.end()) == g.evaluate(b.begin(), b.end()), "rebase after reordering wrong");
+        }
+
+        // new variables go to the bottom
+        const size_t v = mgr.add_variable();
+        test(mgr.level(v) == v && mgr.variable(v) == v);
+    }
+
+    // random functions keep their values
+    {
+        bdd_mgr mgr;
+        const size_t nr_vars = 14;
+        for(size_t j=0; j<nr_vars; ++j)
+            mgr.add_variable();
+        std::vector<node_ref> fs;
+        std::vector<std::vector<char>> values;
+        for(size_t i=0; i<4; ++i)
+        {
+            node_ref f = mgr.botsink();
+            for(size_t t=0; t<6; ++t)
+            {
+                node_ref term = mgr.topsink();
+                for(size_t l=0; l<3; ++l)
+                {
+                    const size_t x = gen() % nr_vars;
+                    term = mgr.and_rec(term, gen() % 2 ? mgr.projection(x) : mgr.neg_projection(x));
+                }
+                f = mgr.or_rec(f, term);
+            }
+            fs.push_back(f);
+            values.emplace_back();
+            for(size_t k=0; k<(size_t(1) << nr_vars); ++k)
+            {
+                std::vector<char> a(nr_vars);
+                for(size_t j=0; j<nr_vars; ++j)
+                    a[j] = (k >> j) & 1;
+                values.back().push_back(f.evaluate(a.begin(), a.end()));
+            }
+        }
+        mgr.reorder();
+        mgr.reorder();
+        for(size_t i=0; i<fs.size(); ++i)
+        {
+            test(ordered(mgr, fs[i]));
+            for(size_t k=0; k<(size_t(1) << nr_vars); ++k)
+            {
+                std::vector<char> a(nr_vars);
+                for(size_t j=0; j<nr_vars; ++j)
+                    a[j] = (k >> j) & 1;
+                test(fs[i].evaluate(a.begin(), a.end()) == bool(values[i][k]), "random function changed by reordering");
+            }
+        }
+    }
+
+#ifndef LBDD_CONCURRENT
+    // automatic reordering while building
+    {
+        bdd_mgr mgr;
+        mgr.set_reordering_policy(256, 1.2);
+        mgr.set_automatic_reordering(true);
+        const size_t m = 12;
+        node_ref f = pairs(mgr, m);
+        test(mgr.nr_reorderings() > 0, "automatic reordering should have been triggered");
+        // each pair is added with its second variable at the bottom, so the result is not optimal, but far from exponential
+        test(f.nr_nodes() < size_t(1) << (m-2), "automatic reordering should keep pairs small, found " + std::to_string(f.nr_nodes()) + " nodes");
+        test(ordered(mgr, f));
+        for(size_t k=0; k<1000; ++k)
+        {
+            std::vector<char> a(2*m);
+            for(auto& v : a)
+                v = gen() % 2;
+            test(f.evaluate(a.begin(), a.end()) == pairs_value(a, m), "automatically reordered bdd has wrong value");
+        }
+    }
+#endif
+}